@@ -85,6 +85,8 @@ VarSymbol *gModuleInitIndentLevel = NULL;
 FnSymbol *gPrintModuleInitFn = NULL;
 FnSymbol* gChplHereAlloc = NULL;
 FnSymbol* gChplHereFree = NULL;
+FnSymbol* gChplHereTaskAlloc = NULL;
+FnSymbol* gChplHereTaskFree = NULL;
 Symbol *gCLine = NULL;
 Symbol *gCFile = NULL;
 
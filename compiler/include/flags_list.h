@@ -133,6 +133,8 @@ symbolFlag( FLAG_ITERATOR_RECORD , npr, "iterator record" , ncm )
 symbolFlag( FLAG_ITERATOR_WITH_ON , npr, "iterator with on" , "iterator which contains an on block" )
 symbolFlag( FLAG_LOCALE_MODEL_ALLOC , ypr, "locale model alloc" , "locale model specific alloc" )
 symbolFlag( FLAG_LOCALE_MODEL_FREE , ypr, "locale model free" , "locale model specific free" )
+symbolFlag( FLAG_LOCALE_MODEL_TASK_ALLOC , ypr, "locale model task alloc" , "locale model specific task region alloc" )
+symbolFlag( FLAG_LOCALE_MODEL_TASK_FREE , ypr, "locale model task free" , "locale model specific task region free" )
 
 // The arguments to this function are all values or narrow pointers.
 // Calls to an extern function use only narrow args and expect a narrow return.
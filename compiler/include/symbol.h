@@ -518,6 +518,8 @@ extern VarSymbol *gModuleInitIndentLevel;
 extern FnSymbol *gPrintModuleInitFn;
 extern FnSymbol *gChplHereAlloc;
 extern FnSymbol *gChplHereFree;
+extern FnSymbol *gChplHereTaskAlloc;
+extern FnSymbol *gChplHereTaskFree;
 extern Symbol *gCLine, *gCFile;
 
 extern Symbol *gSyncVarAuxFields;
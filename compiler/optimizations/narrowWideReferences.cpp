@@ -307,7 +307,9 @@ narrowSym(Symbol* sym, WideInfo* wi,
           (call->isPrimitive(PRIM_SIZEOF)) ||
           (call->isResolved() &&
            (call->isResolved()->hasFlag(FLAG_LOCALE_MODEL_ALLOC) ||
-            call->isResolved()->hasFlag(FLAG_LOCALE_MODEL_FREE)) &&
+            call->isResolved()->hasFlag(FLAG_LOCALE_MODEL_FREE) ||
+            call->isResolved()->hasFlag(FLAG_LOCALE_MODEL_TASK_ALLOC) ||
+            call->isResolved()->hasFlag(FLAG_LOCALE_MODEL_TASK_FREE)) &&
            call->get(1)==use) ||
           (isOpEqualPrim(call)) )
         continue;
@@ -238,7 +238,8 @@ scalarReplaceClass(AggregateType* ct, Symbol* sym) {
              (call->isResolved()->hasFlag(FLAG_ALLOCATOR) ||
               // TODO: don't know this is necessary as the arg to free
               // is a void *
-              call->isResolved()->hasFlag(FLAG_LOCALE_MODEL_FREE)))))
+              call->isResolved()->hasFlag(FLAG_LOCALE_MODEL_FREE) ||
+              call->isResolved()->hasFlag(FLAG_LOCALE_MODEL_TASK_FREE)))))
         return false;
     }
   }
@@ -289,7 +290,8 @@ scalarReplaceClass(AggregateType* ct, Symbol* sym) {
                  // TODO: don't know if this is still needed.  The
                  // PRIM_CAST_TO_VOID_STAR case may take care of it.
                  (call->isResolved() &&
-                  call->isResolved()->hasFlag(FLAG_LOCALE_MODEL_FREE))) {
+                  (call->isResolved()->hasFlag(FLAG_LOCALE_MODEL_FREE) ||
+                   call->isResolved()->hasFlag(FLAG_LOCALE_MODEL_TASK_FREE)))) {
         //
         // we can remove the setting of the cid because it is never
         // used and we are otherwise able to remove the class
@@ -303,7 +305,8 @@ scalarReplaceClass(AggregateType* ct, Symbol* sym) {
         CallExpr* parentNext = toCallExpr(parent->next);
         if (parentNext &&
             parentNext->isResolved() &&
-            parentNext->isResolved()->hasFlag(FLAG_LOCALE_MODEL_FREE))
+            (parentNext->isResolved()->hasFlag(FLAG_LOCALE_MODEL_FREE) ||
+             parentNext->isResolved()->hasFlag(FLAG_LOCALE_MODEL_TASK_FREE)))
           parentNext->remove();
         parent->remove();
       } else if (call->isPrimitive(PRIM_SET_MEMBER)) {
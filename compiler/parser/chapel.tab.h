@@ -0,0 +1,241 @@
+/* A Bison parser, made by GNU Bison 3.8.2.  */
+
+/* Bison interface for Yacc-like parsers in C
+
+   Copyright (C) 1984, 1989-1990, 2000-2015, 2018-2021 Free Software Foundation,
+   Inc.
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>.  */
+
+/* As a special exception, you may create a larger work that contains
+   part or all of the Bison parser skeleton and distribute that work
+   under terms of your choice, so long as that work isn't itself a
+   parser generator using the skeleton or a modified version thereof
+   as a parser skeleton.  Alternatively, if you modify or redistribute
+   the parser skeleton itself, you may (at your option) remove this
+   special exception, which will cause the skeleton and the resulting
+   Bison output files to be licensed under the GNU General Public
+   License without this special exception.
+
+   This special exception was added by the Free Software Foundation in
+   version 2.2 of Bison.  */
+
+/* DO NOT RELY ON FEATURES THAT ARE NOT DOCUMENTED in the manual,
+   especially those whose name start with YY_ or yy_.  They are
+   private implementation details that can be changed or removed.  */
+
+#ifndef YY_YY_CHAPEL_TAB_H_INCLUDED
+# define YY_YY_CHAPEL_TAB_H_INCLUDED
+/* Debug traces.  */
+#ifndef YYDEBUG
+# define YYDEBUG 1
+#endif
+#if YYDEBUG
+extern int yydebug;
+#endif
+
+/* Token kinds.  */
+#ifndef YYTOKENTYPE
+# define YYTOKENTYPE
+  enum yytokentype
+  {
+    YYEMPTY = -2,
+    YYEOF = 0,                     /* "end of file"  */
+    YYerror = 256,                 /* error  */
+    YYUNDEF = 257,                 /* "invalid token"  */
+    TIDENT = 258,                  /* TIDENT  */
+    IMAGLITERAL = 259,             /* IMAGLITERAL  */
+    INTLITERAL = 260,              /* INTLITERAL  */
+    REALLITERAL = 261,             /* REALLITERAL  */
+    STRINGLITERAL = 262,           /* STRINGLITERAL  */
+    EXTERNCODE = 263,              /* EXTERNCODE  */
+    TALIGN = 264,                  /* TALIGN  */
+    TATOMIC = 265,                 /* TATOMIC  */
+    TBEGIN = 266,                  /* TBEGIN  */
+    TBREAK = 267,                  /* TBREAK  */
+    TBY = 268,                     /* TBY  */
+    TCLASS = 269,                  /* TCLASS  */
+    TCOBEGIN = 270,                /* TCOBEGIN  */
+    TCOFORALL = 271,               /* TCOFORALL  */
+    TCONFIG = 272,                 /* TCONFIG  */
+    TCONST = 273,                  /* TCONST  */
+    TCONTINUE = 274,               /* TCONTINUE  */
+    TDELETE = 275,                 /* TDELETE  */
+    TDMAPPED = 276,                /* TDMAPPED  */
+    TDO = 277,                     /* TDO  */
+    TDOMAIN = 278,                 /* TDOMAIN  */
+    TELSE = 279,                   /* TELSE  */
+    TENUM = 280,                   /* TENUM  */
+    TEXPORT = 281,                 /* TEXPORT  */
+    TEXTERN = 282,                 /* TEXTERN  */
+    TFOR = 283,                    /* TFOR  */
+    TFORALL = 284,                 /* TFORALL  */
+    TIF = 285,                     /* TIF  */
+    TIN = 286,                     /* TIN  */
+    TINDEX = 287,                  /* TINDEX  */
+    TINLINE = 288,                 /* TINLINE  */
+    TINOUT = 289,                  /* TINOUT  */
+    TITER = 290,                   /* TITER  */
+    TLABEL = 291,                  /* TLABEL  */
+    TLAMBDA = 292,                 /* TLAMBDA  */
+    TLET = 293,                    /* TLET  */
+    TLOCAL = 294,                  /* TLOCAL  */
+    TMINUSMINUS = 295,             /* TMINUSMINUS  */
+    TMODULE = 296,                 /* TMODULE  */
+    TNEW = 297,                    /* TNEW  */
+    TNIL = 298,                    /* TNIL  */
+    TNOINIT = 299,                 /* TNOINIT  */
+    TON = 300,                     /* TON  */
+    TOTHERWISE = 301,              /* TOTHERWISE  */
+    TOUT = 302,                    /* TOUT  */
+    TPARAM = 303,                  /* TPARAM  */
+    TPLUSPLUS = 304,               /* TPLUSPLUS  */
+    TPRAGMA = 305,                 /* TPRAGMA  */
+    TPRIMITIVE = 306,              /* TPRIMITIVE  */
+    TPROC = 307,                   /* TPROC  */
+    TRECORD = 308,                 /* TRECORD  */
+    TREDUCE = 309,                 /* TREDUCE  */
+    TREF = 310,                    /* TREF  */
+    TRETURN = 311,                 /* TRETURN  */
+    TSCAN = 312,                   /* TSCAN  */
+    TSELECT = 313,                 /* TSELECT  */
+    TSERIAL = 314,                 /* TSERIAL  */
+    TSINGLE = 315,                 /* TSINGLE  */
+    TSPARSE = 316,                 /* TSPARSE  */
+    TSUBDOMAIN = 317,              /* TSUBDOMAIN  */
+    TSYNC = 318,                   /* TSYNC  */
+    TTHEN = 319,                   /* TTHEN  */
+    TTYPE = 320,                   /* TTYPE  */
+    TUNDERSCORE = 321,             /* TUNDERSCORE  */
+    TUNION = 322,                  /* TUNION  */
+    TUSE = 323,                    /* TUSE  */
+    TVAR = 324,                    /* TVAR  */
+    TWHEN = 325,                   /* TWHEN  */
+    TWHERE = 326,                  /* TWHERE  */
+    TWHILE = 327,                  /* TWHILE  */
+    TWITH = 328,                   /* TWITH  */
+    TYIELD = 329,                  /* TYIELD  */
+    TZIP = 330,                    /* TZIP  */
+    TALIAS = 331,                  /* TALIAS  */
+    TAND = 332,                    /* TAND  */
+    TASSIGN = 333,                 /* TASSIGN  */
+    TASSIGNBAND = 334,             /* TASSIGNBAND  */
+    TASSIGNBOR = 335,              /* TASSIGNBOR  */
+    TASSIGNBXOR = 336,             /* TASSIGNBXOR  */
+    TASSIGNDIVIDE = 337,           /* TASSIGNDIVIDE  */
+    TASSIGNEXP = 338,              /* TASSIGNEXP  */
+    TASSIGNLAND = 339,             /* TASSIGNLAND  */
+    TASSIGNLOR = 340,              /* TASSIGNLOR  */
+    TASSIGNMINUS = 341,            /* TASSIGNMINUS  */
+    TASSIGNMOD = 342,              /* TASSIGNMOD  */
+    TASSIGNMULTIPLY = 343,         /* TASSIGNMULTIPLY  */
+    TASSIGNPLUS = 344,             /* TASSIGNPLUS  */
+    TASSIGNSL = 345,               /* TASSIGNSL  */
+    TASSIGNSR = 346,               /* TASSIGNSR  */
+    TBAND = 347,                   /* TBAND  */
+    TBNOT = 348,                   /* TBNOT  */
+    TBOR = 349,                    /* TBOR  */
+    TBXOR = 350,                   /* TBXOR  */
+    TCOLON = 351,                  /* TCOLON  */
+    TCOMMA = 352,                  /* TCOMMA  */
+    TDIVIDE = 353,                 /* TDIVIDE  */
+    TDOT = 354,                    /* TDOT  */
+    TDOTDOT = 355,                 /* TDOTDOT  */
+    TDOTDOTDOT = 356,              /* TDOTDOTDOT  */
+    TEQUAL = 357,                  /* TEQUAL  */
+    TEXP = 358,                    /* TEXP  */
+    TGREATER = 359,                /* TGREATER  */
+    TGREATEREQUAL = 360,           /* TGREATEREQUAL  */
+    THASH = 361,                   /* THASH  */
+    TLESS = 362,                   /* TLESS  */
+    TLESSEQUAL = 363,              /* TLESSEQUAL  */
+    TMINUS = 364,                  /* TMINUS  */
+    TMOD = 365,                    /* TMOD  */
+    TNOT = 366,                    /* TNOT  */
+    TNOTEQUAL = 367,               /* TNOTEQUAL  */
+    TOR = 368,                     /* TOR  */
+    TPLUS = 369,                   /* TPLUS  */
+    TQUESTION = 370,               /* TQUESTION  */
+    TSEMI = 371,                   /* TSEMI  */
+    TSHIFTLEFT = 372,              /* TSHIFTLEFT  */
+    TSHIFTRIGHT = 373,             /* TSHIFTRIGHT  */
+    TSTAR = 374,                   /* TSTAR  */
+    TSWAP = 375,                   /* TSWAP  */
+    TIO = 376,                     /* TIO  */
+    TLCBR = 377,                   /* TLCBR  */
+    TRCBR = 378,                   /* TRCBR  */
+    TLP = 379,                     /* TLP  */
+    TRP = 380,                     /* TRP  */
+    TLSBR = 381,                   /* TLSBR  */
+    TRSBR = 382,                   /* TRSBR  */
+    TNOELSE = 383,                 /* TNOELSE  */
+    TUPLUS = 384,                  /* TUPLUS  */
+    TUMINUS = 385                  /* TUMINUS  */
+  };
+  typedef enum yytokentype yytoken_kind_t;
+#endif
+
+/* Value type.  */
+#if ! defined YYSTYPE && ! defined YYSTYPE_IS_DECLARED
+union YYSTYPE
+{
+#line 61 "chapel.ypp"
+
+  const char* pch;
+  Vec<const char*>* vpch;
+  RetTag retTag;
+  bool b;
+  IntentTag pt;
+  Expr* pexpr;
+  DefExpr* pdefexpr;
+  CallExpr* pcallexpr;
+  BlockStmt* pblockstmt;
+  Type* ptype;
+  EnumType* penumtype;
+  FnSymbol* pfnsymbol;
+  Flag flag;
+  ProcIter procIter;
+  FlagSet* flagSet;
+  struct { ArgSymbol* first; Expr* second; } pIntentExpr;
+
+#line 213 "chapel.tab.h"
+
+};
+typedef union YYSTYPE YYSTYPE;
+# define YYSTYPE_IS_TRIVIAL 1
+# define YYSTYPE_IS_DECLARED 1
+#endif
+
+/* Location type.  */
+#if ! defined YYLTYPE && ! defined YYLTYPE_IS_DECLARED
+typedef struct YYLTYPE YYLTYPE;
+struct YYLTYPE
+{
+  int first_line;
+  int first_column;
+  int last_line;
+  int last_column;
+};
+# define YYLTYPE_IS_DECLARED 1
+# define YYLTYPE_IS_TRIVIAL 1
+#endif
+
+
+extern YYSTYPE yylval;
+extern YYLTYPE yylloc;
+
+int yyparse (void);
+
+
+#endif /* !YY_YY_CHAPEL_TAB_H_INCLUDED  */
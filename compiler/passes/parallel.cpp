@@ -547,6 +547,29 @@ buildHeapType(Type* type) {
 }
 
 
+//
+// If the locale model provides a task region allocator, retarget the
+// chpl_here_alloc() call that insertChplHereAlloc() placed just ahead
+// of the cast-and-move 'move' and return the matching free call.
+// Otherwise return NULL and leave the allocation alone.
+//
+static CallExpr*
+callChplHereTaskFree(CallExpr* move) {
+  if (!gChplHereTaskAlloc || !gChplHereTaskFree)
+    return NULL;
+  CallExpr* allocMove = toCallExpr(move->prev);
+  if (!allocMove || !allocMove->isPrimitive(PRIM_MOVE))
+    return NULL;
+  CallExpr* alloc = toCallExpr(allocMove->get(2));
+  if (!alloc || alloc->isResolved() != gChplHereAlloc)
+    return NULL;
+  alloc->baseExpr->replace(new SymExpr(gChplHereTaskAlloc));
+  return new CallExpr(gChplHereTaskFree,
+                      new CallExpr(PRIM_CAST_TO_VOID_STAR,
+                                   move->get(1)->copy()));
+}
+
+
 static void
 freeHeapAllocatedVars(Vec<Symbol*> heapAllocatedVars) {
   Vec<FnSymbol*> fnsContainingTaskll;
@@ -665,12 +688,17 @@ freeHeapAllocatedVars(Vec<Symbol*> heapAllocatedVars) {
         }
         FnSymbol* fn = toFnSymbol(move->parentSymbol);
         SET_LINENO(var);
+        // The variable does not outlive the task that allocated it, so
+        // take its memory from the task's region instead of the heap.
+        CallExpr* freeCall = callChplHereTaskFree(move);
+        if (!freeCall)
+          freeCall = callChplHereFree(move->get(1)->copy());
         if (fn && innermostBlock == fn->body)
-          fn->insertBeforeReturnAfterLabel(callChplHereFree(move->get(1)->copy()));
+          fn->insertBeforeReturnAfterLabel(freeCall);
         else {
           BlockStmt* block = toBlockStmt(innermostBlock);
           INT_ASSERT(block);
-          block->insertAtTailBeforeGoto(callChplHereFree(move->get(1)->copy()));
+          block->insertAtTailBeforeGoto(freeCall);
         }
       }
     }
@@ -7049,6 +7049,18 @@ static void resolveOther() {
     // Resolve the function that will print module init order
     resolveFns(gPrintModuleInitFn);
   }
+
+  //
+  // The task region allocator is only called from code that
+  // parallel() inserts after resolution, so resolve it now.  The
+  // locale model might not provide it (e.g., --minimal-modules).
+  //
+  if (gChplHereTaskAlloc && gChplHereTaskFree) {
+    resolveFormals(gChplHereTaskAlloc);
+    resolveFns(gChplHereTaskAlloc);
+    resolveFormals(gChplHereTaskFree);
+    resolveFns(gChplHereTaskFree);
+  }
 }
 
 
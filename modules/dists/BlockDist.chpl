@@ -984,6 +984,113 @@ iter BlockArr.these(param tag: iterKind, followThis, param fast: bool = false) r
   }
 }
 
+//
+// Binary I/O in native byte order moves each locale's block directly
+// between that locale and its part of the file, all in parallel,
+// rather than sending every element through the channel's locale.
+// Returns false, having done nothing, when that isn't possible.
+//
+// Every locale opens the file again by name, so this is only done when
+// each of those opens finds the channel's own file (not, say, a
+// different node-local file with the same name, or nothing at all for
+// a file that has been unlinked).
+//
+proc BlockArr.doiParallelReadWrite(f, param writing: bool): bool {
+  if !_isSimpleIoType(eltType) || stridable then return false;
+  if !f.binary() ||
+     f.styleElement(QIO_STYLE_ELEMENT_IS_NATIVE_BYTE_ORDER) == 0 then
+    return false;
+
+  pragma "no prototype"
+  extern proc sizeof(type x): size_t;
+  const elemSize = sizeof(eltType):int;
+  const whole = dom.whole;
+  var path: string;
+  var dev, ino: int(64);
+  if !f._fileForParallel(path, dev, ino) then
+    return false;
+
+  var files: [dom.dist.targetLocDom] file;
+  var opened: [dom.dist.targetLocDom] bool;
+  coforall locid in dom.dist.targetLocDom do
+    on dom.dist.targetLocales(locid) {
+      if dom.locDoms(locid).myBlock.numIndices > 0 {
+        var e: syserr;
+        var fl = open(e, path, if writing then iomode.rw else iomode.r);
+        if !e {
+          var myDev, myIno: int(64);
+          if !fl._identity(myDev, myIno) && myDev == dev && myIno == ino {
+            files(locid) = fl;
+            opened(locid) = true;
+          } else {
+            fl.close(e);
+          }
+        }
+      } else {
+        opened(locid) = true;
+      }
+    }
+  if !(&& reduce opened) then
+    return false;
+
+  var offset: int(64);
+  if !f._skipForParallel(whole.numIndices*elemSize, path, offset) then
+    return false;
+
+  // the file offset of index idx; the file is in row-major order
+  proc fileOffset(idx: rank*idxType) {
+    var pos = 0;
+    for param d in 1..rank do
+      pos = pos*whole.dim(d).length + (idx(d) - whole.dim(d).low):int;
+    return offset + pos*elemSize;
+  }
+
+  var errs: [dom.dist.targetLocDom] syserr;
+  coforall locid in dom.dist.targetLocDom do
+    on dom.dist.targetLocales(locid) {
+      const myBlock = dom.locDoms(locid).myBlock;
+      const myElems = locArr(locid).myElems._value;
+      const runLo = myBlock.dim(rank).low;
+      const runBytes = myBlock.dim(rank).length*elemSize;
+
+      // the first index of each contiguous run of the local block
+      iter runStarts() {
+        if rank == 1 then
+          yield (runLo,);
+        else
+          for coord in dropDims(myBlock, rank) do
+            yield if rank == 2 then (coord, runLo) else ((...coord), runLo);
+      }
+
+      if myBlock.numIndices > 0 {
+        var e: syserr;
+        var fl = files(locid);
+        for lo in runStarts() {
+          if writing then
+            e = fl._pwriteBytes(__primitive("array_get", myElems.theData,
+                                            myElems.getDataIndex(lo)),
+                                runBytes, fileOffset(lo));
+          else
+            e = fl._preadBytes(__primitive("array_get", myElems.theData,
+                                           myElems.getDataIndex(lo)),
+                               runBytes, fileOffset(lo));
+          if e then break;
+        }
+        var closeErr: syserr;
+        fl.close(closeErr);
+        if !e then e = closeErr;
+        errs(locid) = e;
+      }
+    }
+
+  for e in errs do
+    if e {
+      f.setError(e);
+      break;
+    }
+  return true;
+}
+
 //
 // output array
 //
@@ -991,6 +1098,7 @@ proc BlockArr.dsiSerialWrite(f: Writer) {
   type strType = chpl__signedType(idxType);
   var binary = f.binary();
   if dom.dsiNumIndices == 0 then return;
+  if doiParallelReadWrite(f, writing=true) then return;
   var i : rank*idxType;
   for dim in 1..rank do
     i(dim) = dom.dsiDim(dim).low;
@@ -1015,6 +1123,16 @@ proc BlockArr.dsiSerialWrite(f: Writer) {
   }
 }
 
+//
+// input array
+//
+proc BlockArr.dsiSerialRead(f: Reader) {
+  if dom.dsiNumIndices == 0 then return;
+  if doiParallelReadWrite(f, writing=false) then return;
+  for i in dom.whole do
+    f <~> dsiAccess(i);
+}
+
 proc BlockArr.dsiSlice(d: BlockDom) {
   var alias = new BlockArr(eltType=eltType, rank=rank, idxType=idxType, stridable=d.stridable, dom=d);
   var thisid = this.locale.id;
@@ -25,10 +25,6 @@ module ChapelArray {
   use ChapelTuple;
   use ChapelLocale;
 
-  // Explicitly use a processor atomic, as most calls to this function are
-  // likely be on locale 0
-  var numPrivateObjects: atomic_int64;
-
   config param debugBulkTransfer = false;
   config param useBulkTransfer = true;
   config param useBulkTransferStride = false;
@@ -38,13 +34,17 @@ module ChapelArray {
     return !_local & ((_privatization & value.dsiSupportsPrivatization()) | value.dsiRequiresPrivatization());
 
   proc _newPrivatizedClass(value) {
+    extern proc chpl_newPrivatizedPid(): int;
 
-    var n = numPrivateObjects.fetchAdd(1);
+    var n: int;
 
     var hereID = here.id;
     const privatizeData = value.dsiGetPrivatizeData();
-    on Locales[0] do
+    on Locales[0] {
+      // Pids are allocated on locale 0 so that freed ones can be reused
+      n = chpl_newPrivatizedPid();
       _newPrivatizedClassHelp(value, value, n, hereID, privatizeData);
+    }
 
     proc _newPrivatizedClassHelp(parentValue, originalValue, n, hereID, privatizeData) {
       var newValue = originalValue;
@@ -56,6 +56,8 @@ module ChapelArray {
         __primitive("chpl_newPrivatizedClass", newValue, n);
         newValue.pid = n;
       }
+      newValue._privPid = n;
+      newValue._privOriginal = originalValue;
       cobegin {
         if chpl_localeTree.left then
           on chpl_localeTree.left do
@@ -69,6 +71,40 @@ module ChapelArray {
     return n;
   }
 
+  //
+  // Remove the privatized object with the given pid from every locale's
+  // table and make the pid available for reuse.  The copies created by
+  // dsiPrivatize() are deleted; 'original' is left to the caller.
+  //
+  proc _freePrivatizedClass(pid: int, original) {
+    extern proc chpl_clearPrivatizedClass(pid: int);
+    extern proc chpl_freePrivatizedPid(pid: int);
+
+    coforall loc in Locales do on loc {
+      const privatizedCopy = chpl_getPrivatizedCopy(original.type, pid);
+      chpl_clearPrivatizedClass(pid);
+      if privatizedCopy != original then
+        delete privatizedCopy;
+    }
+    on Locales[0] do
+      chpl_freePrivatizedPid(pid);
+  }
+
+  //
+  // Delete a distribution, domain, or array class whose reference
+  // count has dropped to zero.  A privatized 'value' may be any of its
+  // copies: all of them and the original are deleted.
+  //
+  proc _deleteRefCountedClass(value) {
+    if value._privPid < 0 {
+      delete value;
+    } else {
+      const original = value._privOriginal;
+      _freePrivatizedClass(value._privPid, original);
+      delete original;
+    }
+  }
+
   proc _reprivatize(value) {
     var pid = value.pid;
     var hereID = here.id;
@@ -358,7 +394,7 @@ module ChapelArray {
       const refcount = ev.domain._value.destroyDom();
       if !noRefCount then
         if refcount == 0 then
-          delete ev.domain._value;
+          _deleteRefCountedClass(ev.domain._value);
       chpl_decRefCountsForDomainsInArrayEltTypes(ev.eltType);
     }
   }
@@ -578,13 +614,11 @@ module ChapelArray {
   
     proc ~_distribution() {
      if !noRefCount {
-      if !_isPrivatized(_valueType) {
-        on _value {
-          var cnt = _value.destroyDist();
-          if cnt == 0 {
-            _value.dsiDestroyDistClass();
-            delete _value;
-          }
+      on _value {
+        var cnt = _value.destroyDist();
+        if cnt == 0 {
+          _value.dsiDestroyDistClass();
+          _deleteRefCountedClass(_value);
         }
       }
      }
@@ -690,12 +724,10 @@ module ChapelArray {
   
     proc ~_domain () {
      if !noRefCount {
-      if !_isPrivatized(_valueType) {
-        on _value {
-          var cnt = _value.destroyDom();
-          if cnt == 0 then
-            delete _value;
-        }
+      on _value {
+        var cnt = _value.destroyDom();
+        if cnt == 0 then
+          _deleteRefCountedClass(_value);
       }
      }
     }
@@ -1311,13 +1343,11 @@ module ChapelArray {
     //
     proc ~_array() {
      if !noRefCount {
-      if !_isPrivatized(_valueType) {
-        on _value {
-          var cnt = _value.destroyArr();
-          if cnt == 0 then {
-            chpl_decRefCountsForDomainsInArrayEltTypes(_value.eltType);
-            delete _value;
-          }
+      on _value {
+        var cnt = _value.destroyArr();
+        if cnt == 0 then {
+          chpl_decRefCountsForDomainsInArrayEltTypes(_value.eltType);
+          _deleteRefCountedClass(_value);
         }
       }
      }
@@ -34,10 +34,21 @@ module ChapelDistribution {
     var _distCnt: atomic_refcnt; // distribution reference count
     var _doms: list(BaseDom);   // domains declared over this domain
     var _domsLock: atomicflag;  //   and lock for concurrent access
+    var _privPid: int = -1;      // privatized object id, if privatized
+    var _privOriginal: BaseDist; //   and the copy holding the count
   
+    //
+    // Every copy of a privatized object shares the reference count
+    // of the original, so a copy passes count updates on to it.
+    //
     pragma "dont disable remote value forwarding"
     proc destroyDist(): int {
       compilerAssert(!noRefCount);
+      if _privOriginal != nil && _privOriginal != this {
+        var cnt: int;
+        on _privOriginal do cnt = _privOriginal.destroyDist();
+        return cnt;
+      }
       return decRefCount();
     }
   
@@ -92,7 +103,10 @@ module ChapelDistribution {
   
     inline proc incRefCount(cnt=1) {
       compilerAssert(!noRefCount);
-      _distCnt.inc(cnt);
+      if _privOriginal != nil && _privOriginal != this then
+        on _privOriginal do _privOriginal._distCnt.inc(cnt);
+      else
+        _distCnt.inc(cnt);
     }
 
     inline proc decRefCount() {
@@ -122,6 +136,8 @@ module ChapelDistribution {
     var _domCnt: atomic_refcnt; // domain reference count
     var _arrs: list(BaseArr);  // arrays declared over this domain
     var _arrsLock: atomicflag; //   and lock for concurrent access
+    var _privPid: int = -1;     // privatized object id, if privatized
+    var _privOriginal: BaseDom; //   and the copy holding the count
   
     proc dsiMyDist(): BaseDist {
       halt("internal error: dsiMyDist is not implemented");
@@ -131,6 +147,11 @@ module ChapelDistribution {
     pragma "dont disable remote value forwarding"
     proc destroyDom(): int {
       compilerAssert(!noRefCount);
+      if _privOriginal != nil && _privOriginal != this {
+        var cnt: int;
+        on _privOriginal do cnt = _privOriginal.destroyDom();
+        return cnt;
+      }
       var cnt = decRefCount();
       if cnt == 0 && dsiLinksDistribution() {
           var dist = dsiMyDist();
@@ -138,7 +159,7 @@ module ChapelDistribution {
             local dist.remove_dom(this);
             var cnt = dist.destroyDist();
             if cnt == 0 then
-              delete dist;
+              _deleteRefCountedClass(dist);
           }
       }
       return cnt;
@@ -190,7 +211,10 @@ module ChapelDistribution {
   
     inline proc incRefCount(cnt=1) {
       compilerAssert(!noRefCount);
-      _domCnt.inc(cnt);
+      if _privOriginal != nil && _privOriginal != this then
+        on _privOriginal do _privOriginal._domCnt.inc(cnt);
+      else
+        _domCnt.inc(cnt);
     }
 
     inline proc decRefCount() {
@@ -273,6 +297,8 @@ module ChapelDistribution {
     // atomics are available
     var _arrCnt: atomic_refcnt; // array reference count
     var _arrAlias: BaseArr;    // reference to base array if an alias
+    var _privPid: int = -1;     // privatized object id, if privatized
+    var _privOriginal: BaseArr; //   and the copy holding the count
   
     proc dsiStaticFastFollowCheck(type leadType) param return false;
   
@@ -284,13 +310,18 @@ module ChapelDistribution {
     pragma "dont disable remote value forwarding"
     proc destroyArr(): int {
       compilerAssert(!noRefCount);
+      if _privOriginal != nil && _privOriginal != this {
+        var cnt: int;
+        on _privOriginal do cnt = _privOriginal.destroyArr();
+        return cnt;
+      }
       var cnt = decRefCount();
       if cnt == 0 {
         if _arrAlias {
           on _arrAlias {
             var cnt = _arrAlias.destroyArr();
             if cnt == 0 then
-              delete _arrAlias;
+              _deleteRefCountedClass(_arrAlias);
           }
         } else {
           dsiDestroyData();
@@ -302,7 +333,7 @@ module ChapelDistribution {
             local dom.remove_arr(this);
             var cnt = dom.destroyDom();
             if cnt == 0 then
-              delete dom;
+              _deleteRefCountedClass(dom);
           }
       }
       return cnt;
@@ -363,7 +394,10 @@ module ChapelDistribution {
   
     inline proc incRefCount(cnt=1) {
       compilerAssert(!noRefCount);
-      _arrCnt.inc(cnt);
+      if _privOriginal != nil && _privOriginal != this then
+        on _privOriginal do _privOriginal._arrCnt.inc(cnt);
+      else
+        _arrCnt.inc(cnt);
     }
 
     inline proc decRefCount() {
@@ -47,6 +47,13 @@ module ChapelIO {
     proc writeBytes(x, len:ssize_t) {
       halt("Generic Writer.writeBytes called");
     }
+    // For parallel binary array I/O; see ChannelWriter.
+    proc _fileForParallel(ref path:string, ref dev:int(64), ref ino:int(64)):bool {
+      return false;
+    }
+    proc _skipForParallel(len:int(64), ref path:string, ref offset:int(64)):bool {
+      return false;
+    }
     proc writeIt(x:?t) {
       if _isIoPrimitiveTypeOrNewline(t) {
         writePrimitive(x);
@@ -217,6 +224,13 @@ module ChapelIO {
     proc readBytes(x, len:ssize_t) {
       halt("Generic Reader.readBytes called");
     }
+    // For parallel binary array I/O; see ChannelReader.
+    proc _fileForParallel(ref path:string, ref dev:int(64), ref ino:int(64)):bool {
+      return false;
+    }
+    proc _skipForParallel(len:int(64), ref path:string, ref offset:int(64)):bool {
+      return false;
+    }
     proc readIt(x:?t) where isClassType(t) {
       // FUTURE -- write the class name/ID? or nil?
       // possibly in a different 'Reader'
@@ -535,6 +535,10 @@ module DefaultRectangular {
     var data : _ddata(eltType);
     var shiftedData : _ddata(eltType);
     var noinit_data: bool = false;
+    // If nonzero, data is a region of a file mapped by file.mapArray
+    // rather than an allocation, and this is its length in bytes.
+    var mappedBytes: int = 0;
+    var mappedSync: bool = false; // msync the mapping before unmapping it
     //var numelm: int = -1; // for correctness checking
   
     // end class definition here, then defined secondary methods below
@@ -552,6 +556,14 @@ module DefaultRectangular {
     proc dsiGetBaseDom() return dom;
   
     proc dsiDestroyData() {
+      if mappedBytes > 0 {
+        pragma "no prototype"
+        extern proc qio_file_unmap_array(data, len:int(64), sync:c_int):syserr;
+        const err = qio_file_unmap_array(data, mappedBytes, mappedSync:c_int);
+        mappedBytes = 0;
+        if err then ioerror(err, "in unmapping array");
+        return;
+      }
       if dom.dsiNumIndices > 0 {
         pragma "no copy" pragma "no auto destroy" var dr = data;
         pragma "no copy" pragma "no auto destroy" var dv = __primitive("deref", dr);
@@ -685,7 +697,8 @@ module DefaultRectangular {
         blk(dim) = blk(dim+1) * dom.dsiDim(dim+1).length;
       computeFactoredOffs();
       var size = blk(1) * dom.dsiDim(1).length;
-      data = _ddata_allocate(eltType, size);
+      if mappedBytes == 0 then
+        data = _ddata_allocate(eltType, size);
       initShiftedData();
     }
   
@@ -848,6 +861,13 @@ module DefaultRectangular {
     }
   
     proc dsiReallocate(d: domain) {
+      // A mapped array can't be moved to a new allocation; it would
+      // silently stop being backed by its file.
+      if mappedBytes > 0 {
+        if d._value.type == dom.type && d._value.ranges == dom.ranges then
+          return;
+        halt("cannot resize the domain of an array mapped by file.mapArray");
+      }
       if (d._value.type == dom.type) {
         var copy = new DefaultRectangularArr(eltType=eltType, rank=rank,
                                             idxType=idxType,
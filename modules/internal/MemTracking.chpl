@@ -28,7 +28,9 @@ module MemTracking
     memLeaksTable: bool = false,
     memMax: size_t = 0,
     memThreshold: size_t = 0,
-    memLog: c_string = "";
+    memProfile: size_t = 0,
+    memLog: c_string = "",
+    memHugePages: c_string = "";
 
   pragma "no auto destroy"
   config const
@@ -38,6 +40,7 @@ module MemTracking
   use NewString;
   const s_memLog: string_rec = memLog;
   const s_memLeaksLog: string_rec = memLeaksLog;
+  const s_memHugePages: string_rec = memHugePages;
 
   //
   // This communicates the settings of the various memory tracking
@@ -48,8 +51,8 @@ module MemTracking
   // locale from the runtime.  Recall that c_string is considered a
   // local-only data type, so we must use some tricks to copy the
   // c_string from locale 0 to the remote locales.  We use the globals
-  // s_memLog and s_memLeaksLog to create global Chapel strings to
-  // make them available to all locales.
+  // s_memLog, s_memLeaksLog and s_memHugePages to create global Chapel
+  // strings to make them available to all locales.
   //
   export
   proc chpl_memTracking_returnConfigVals(ref ret_memTrack: bool,
@@ -58,14 +61,17 @@ module MemTracking
                                          ref ret_memLeaksTable: bool,
                                          ref ret_memMax: size_t,
                                          ref ret_memThreshold: size_t,
+                                         ref ret_memProfile: size_t,
                                          ref ret_memLog: c_string,
-                                         ref ret_memLeaksLog: c_string) {
+                                         ref ret_memLeaksLog: c_string,
+                                         ref ret_memHugePages: c_string) {
     ret_memTrack = memTrack;
     ret_memStats = memStats;
     ret_memLeaks = memLeaks;
     ret_memLeaksTable = memLeaksTable;
     ret_memMax = memMax;
     ret_memThreshold = memThreshold;
+    ret_memProfile = memProfile;
 
     if (here.id != 0) {
       // These c_strings are going to be leaked
@@ -79,9 +85,15 @@ module MemTracking
                                            s_memLeaksLog.base,
                                            s_memLeaksLog.len);
       else ret_memLeaksLog = "";
+      if s_memHugePages.len != 0 then
+        ret_memHugePages = remoteStringCopy(s_memHugePages.home.id,
+                                            s_memHugePages.base,
+                                            s_memHugePages.len);
+      else ret_memHugePages = "";
     } else {
       ret_memLog = memLog;
       ret_memLeaksLog = memLeaksLog;
+      ret_memHugePages = memHugePages;
     }
   }
 }
@@ -303,6 +303,24 @@ module LocaleModel {
     chpl_mem_free(ptr);
   }
 
+  // Heap-converted locals that the compiler can prove do not outlive
+  // their task are allocated from a per-task region instead.  The
+  // region does its own accounting, so the descriptor is unused.
+  pragma "allocator"
+  pragma "locale model task alloc"
+  proc chpl_here_task_alloc(size:int, md:int(16)) {
+    pragma "insert line file info"
+      extern proc chpl_mem_taskRegionAlloc(size:int) : opaque;
+    return chpl_mem_taskRegionAlloc(size);
+  }
+
+  pragma "locale model task free"
+  proc chpl_here_task_free(ptr:opaque) {
+    pragma "insert line file info"
+      extern proc chpl_mem_taskRegionFree(ptr:opaque): void;
+    chpl_mem_taskRegionFree(ptr);
+  }
+
 
   //////////////////////////////////////////
   //
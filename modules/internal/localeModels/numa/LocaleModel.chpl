@@ -348,20 +348,30 @@ module LocaleModel {
   // support for memory management
   //
 
+  // Memory allocated while running on a sublocale is placed in the
+  // memory of that sublocale's NUMA domain.  The runtime only moves
+  // whole pages, so this costs nothing for small allocations.
+  extern proc chpl_mem_localizeSubloc(ptr:opaque, size:int,
+                                      subloc:chpl_sublocID_t);
+
   // The allocator pragma is used by scalar replacement.
   pragma "allocator"
   pragma "locale model alloc"
   proc chpl_here_alloc(size:int, md:int(16)) {
     pragma "insert line file info"
       extern proc chpl_mem_alloc(size:int, md:int(16)) : opaque;
-    return chpl_mem_alloc(size, md + chpl_memhook_md_num());
+    const mem = chpl_mem_alloc(size, md + chpl_memhook_md_num());
+    chpl_mem_localizeSubloc(mem, size, chpl_task_getRequestedSubloc());
+    return mem;
   }
 
   pragma "allocator"
   proc chpl_here_calloc(size:int, number:int, md:int(16)) {
     pragma "insert line file info"
       extern proc chpl_mem_calloc(number:int, size:int, md:int(16)) : opaque;
-    return chpl_mem_calloc(number, size, md + chpl_memhook_md_num());
+    const mem = chpl_mem_calloc(number, size, md + chpl_memhook_md_num());
+    chpl_mem_localizeSubloc(mem, number*size, chpl_task_getRequestedSubloc());
+    return mem;
   }
 
   pragma "allocator"
@@ -378,6 +388,24 @@ module LocaleModel {
     chpl_mem_free(ptr);
   }
 
+  // Heap-converted locals that the compiler can prove do not outlive
+  // their task are allocated from a per-task region instead.  The
+  // region does its own accounting, so the descriptor is unused.
+  pragma "allocator"
+  pragma "locale model task alloc"
+  proc chpl_here_task_alloc(size:int, md:int(16)) {
+    pragma "insert line file info"
+      extern proc chpl_mem_taskRegionAlloc(size:int) : opaque;
+    return chpl_mem_taskRegionAlloc(size);
+  }
+
+  pragma "locale model task free"
+  proc chpl_here_task_free(ptr:opaque) {
+    pragma "insert line file info"
+      extern proc chpl_mem_taskRegionFree(ptr:opaque): void;
+    chpl_mem_taskRegionFree(ptr);
+  }
+
 
   //////////////////////////////////////////
   //
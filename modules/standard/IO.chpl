@@ -56,9 +56,8 @@
       NFS), we should open a local copy of that file and use that in the
       channel. (not sure how to avoid opening # channels copies of these files
       -- seems that we'd want some way to cache that...).
-    - Create leader/follower iterators for ItemReader/ItemWriter so that these
-      are as efficient as possible when working with fixed-size data types
-      (ie, they can open up channels that are not shared).
+    - Create leader/follower iterators for ItemWriter, and for ItemReaders
+      that were not created by file.lines() (these are read by one task).
 */
 
 
@@ -137,6 +136,7 @@ extern const QIO_METHOD_READWRITE:c_int;
 extern const QIO_METHOD_PREADPWRITE:c_int;
 extern const QIO_METHOD_FREADFWRITE:c_int;
 extern const QIO_METHOD_MMAP:c_int;
+extern const QIO_METHOD_ASYNC:c_int;
 extern const QIO_METHODMASK:c_int;
 extern const QIO_HINT_RANDOM:c_int;
 extern const QIO_HINT_SEQUENTIAL:c_int;
@@ -157,7 +157,10 @@ const IOHINT_NONE = 0:c_int;
 const IOHINT_RANDOM = QIO_HINT_RANDOM;
 
 /** SEQUENTAL means expect sequential access. On
-    Linux, this should double the readahead.
+    Linux, this should double the readahead. Buffered
+    channels using pread/pwrite also keep several buffers
+    of reads ahead or writes behind in flight, so I/O
+    overlaps with the work done on the data.
  */
 const IOHINT_SEQUENTIAL = QIO_HINT_SEQUENTIAL;
 
@@ -174,6 +177,26 @@ const IOHINT_CACHED = QIO_HINT_CACHED;
  */
 const IOHINT_PARALLEL = QIO_HINT_PARALLEL;
 
+/** DIRECT means that file data should bypass the
+    operating system's page cache, for example when writing
+    a checkpoint that will not be read again soon. Buffered
+    channels use pread/pwrite with O_DIRECT for the page-aligned
+    part of the data and ordinary I/O for an unaligned start or
+    end. If the file system does not support direct I/O, the
+    hint has no effect.
+ */
+const IOHINT_DIRECT = QIO_HINT_DIRECT;
+
+/** ASYNC requests asynchronous I/O for a seekable file
+    (io_uring on Linux when available, otherwise a pool of
+    I/O threads). Buffered channels issue each buffer-sized
+    chunk as a separate request and keep reading ahead or
+    writing behind, and a task waiting for I/O yields its
+    thread to other tasks. It selects the I/O
+    method, so it should not be combined with another method.
+ */
+const IOHINT_ASYNC = QIO_METHOD_ASYNC;
+
 extern type qio_file_ptr_t;
 extern const QIO_FILE_PTR_NULL:qio_file_ptr_t;
 
@@ -196,6 +219,12 @@ extern const QIO_STRING_FORMAT_JSON:uint(8);
 extern const QIO_STRING_FORMAT_TOEND:uint(8);
 extern const QIO_STRING_FORMAT_TOEOF:uint(8);
 
+extern const QIO_FIELD_SKIP:int(8);
+extern const QIO_FIELD_INT:int(8);
+extern const QIO_FIELD_UINT:int(8);
+extern const QIO_FIELD_REAL:int(8);
+extern const QIO_FIELD_STRING:int(8);
+
 extern record iostyle { // aka qio_style_t
   var binary:uint(8) = 0;
   // binary style choices
@@ -281,6 +310,11 @@ extern proc qio_file_sync(f:qio_file_ptr_t):syserr;
 extern proc qio_channel_end_offset_unlocked(ch:qio_channel_ptr_t):int(64);
 extern proc qio_file_get_style(f:qio_file_ptr_t, ref style:iostyle);
 extern proc qio_file_length(f:qio_file_ptr_t, ref len:int(64)):syserr;
+extern proc qio_file_pwrite_amt(f:qio_file_ptr_t, const ref ptr, len:ssize_t, offset:int(64)):syserr;
+extern proc qio_file_pread_amt(f:qio_file_ptr_t, ref ptr, len:ssize_t, offset:int(64)):syserr;
+extern proc qio_file_identity(f:qio_file_ptr_t, ref dev:int(64), ref ino:int(64)):syserr;
+pragma "no prototype" // FIXME
+extern proc qio_file_map_array(f:qio_file_ptr_t, offset:int(64), len:int(64), writeable:c_int, shared:c_int, hints:c_int, ref data_out):syserr;
 
 pragma "no prototype" // FIXME
 extern proc qio_channel_create(ref ch:qio_channel_ptr_t, file:qio_file_ptr_t, hints:c_int, readable:c_int, writeable:c_int, start:int(64), end:int(64), const ref style:iostyle):syserr;
@@ -319,6 +353,10 @@ extern proc qio_channel_write_byte(threadsafe:c_int, ch:qio_channel_ptr_t, byte:
 
 extern proc qio_channel_offset_unlocked(ch:qio_channel_ptr_t):int(64);
 extern proc qio_channel_advance(threadsafe:c_int, ch:qio_channel_ptr_t, nbytes:int(64)):syserr;
+pragma "no prototype" // FIXME
+extern proc qio_channel_skip_external(threadsafe:c_int, ch:qio_channel_ptr_t, nbytes:int(64), ref path:c_string_copy, ref offset:int(64)):syserr;
+pragma "no prototype" // FIXME
+extern proc qio_channel_external_file(threadsafe:c_int, ch:qio_channel_ptr_t, ref path:c_string_copy, ref dev:int(64), ref ino:int(64)):syserr;
 extern proc qio_channel_mark(threadsafe:c_int, ch:qio_channel_ptr_t):syserr;
 extern proc qio_channel_revert_unlocked(ch:qio_channel_ptr_t);
 extern proc qio_channel_commit_unlocked(ch:qio_channel_ptr_t);
@@ -395,14 +433,23 @@ extern proc qio_channel_scan_literal_2(threadsafe:c_int, ch:qio_channel_ptr_t, m
 extern proc qio_channel_print_literal(threadsafe:c_int, ch:qio_channel_ptr_t, const match:c_string, len:ssize_t):syserr;
 extern proc qio_channel_print_literal_2(threadsafe:c_int, ch:qio_channel_ptr_t, match:c_void_ptr, len:ssize_t):syserr;
 
+extern proc qio_channel_scan_fields(threadsafe:c_int, ch:qio_channel_ptr_t, delims:c_string, nfields:ssize_t, types:c_ptr(int(8)), bits:c_ptr(int(8)), nums:c_ptr(int(64)), reals:c_ptr(real(64)), strs:c_ptr(c_string_copy)):syserr;
 
-/*********************** Curl/HDFS support ******************/
+
+/*********************** Curl/HDFS/gzip support ******************/
 
 /***************** C U R L *******************/
 extern type curl_handle;
 extern const curl_function_struct:qio_file_functions_t;
 extern const curl_function_struct_ptr:qio_file_functions_ptr_t;
 
+/****************** G Z I P ******************/
+extern const gzip_function_struct_ptr:qio_file_functions_ptr_t;
+// Open a compressed file that is read and written with s and fs
+extern proc gzip_file_open_access_usr(out file_out:qio_file_ptr_t, path:string,
+                                      access:string, iohints:c_int, /*const*/ ref style:iostyle,
+                                      fs:c_void_ptr, s: qio_file_functions_ptr_t):syserr;
+
 /****************** H D F S ******************/
 extern const hdfs_function_struct_ptr:qio_file_functions_ptr_t;
 extern proc hdfs_connect(out fs: c_void_ptr, path: c_string, port: int): syserr; 
@@ -514,6 +561,7 @@ extern type fdflag_t = c_int;
   QIO_METHOD_READWRITE,
   QIO_METHOD_P_READWRITE,
   QIO_METHOD_MMAP,
+  QIO_METHOD_ASYNC,
   QIO_HINT_RANDOM,
   QIO_HINT_SEQUENTIAL,
   QIO_HINT_LATENCY,
@@ -666,6 +714,87 @@ proc file.path : string {
   return ret;
 }
 
+// Positional I/O on a file without a channel, for parallel array
+// I/O where each locale moves its own part of a region. Must be
+// called on the file's home locale.
+proc file._pwriteBytes(const ref x, len:ssize_t, offset:int(64)):syserr {
+  return qio_file_pwrite_amt(_file_internal, x, len, offset);
+}
+proc file._preadBytes(ref x, len:ssize_t, offset:int(64)):syserr {
+  return qio_file_pread_amt(_file_internal, x, len, offset);
+}
+
+// The device and inode numbers of the file, for checking that a file
+// opened again by name on another locale is the same file.
+proc file._identity(out dev:int(64), out ino:int(64)):syserr {
+  check();
+  var err:syserr = ENOERR;
+  on this.home {
+    var d, i:int(64);
+    err = qio_file_identity(_file_internal, d, i);
+    dev = d;
+    ino = i;
+  }
+  return err;
+}
+
+/** Map part of a file directly into memory as an array over the
+    local rectangular domain D, without copying or reading it in
+    advance; pages are read as the array is accessed. The array's
+    elements are the bytes of the file starting at offset, in native
+    byte order and row-major order.
+
+    If writeable is true the array can be modified. With shared=true
+    (the default) modifications go to the file, which is extended if
+    needed, and are written back with msync when the array is
+    destroyed; with shared=false they stay private to this array.
+    IOHINT_RANDOM, IOHINT_SEQUENTIAL and IOHINT_CACHED are passed on
+    as madvise hints.
+
+    The file must be on the current locale. The array stays mapped for
+    its whole life, so assigning different indices to D while it exists
+    halts rather than copying the array into memory.
+ */
+proc file.mapArray(type eltType, D: domain, offset:int(64) = 0,
+                   writeable:bool = false, shared:bool = true,
+                   hints:iohints = IOHINT_NONE)
+    where D._value.type: DefaultRectangularDom {
+  if !_isSimpleIoType(eltType) then
+    compilerError("mapArray requires a bool, numeric or enum element type");
+  if D.stridable then
+    compilerError("mapArray requires a non-strided domain");
+
+  pragma "no prototype"
+  extern proc sizeof(type x): size_t;
+
+  check();
+  if this.home != here then
+    ioerror(EINVAL, "in file.mapArray: file is on another locale",
+            this.tryGetPath());
+
+  const len = D.numIndices * sizeof(eltType):int;
+  var data: _ddata(eltType);
+  if len > 0 {
+    var err = qio_file_map_array(_file_internal, offset, len,
+                                 writeable:c_int, shared:c_int, hints, data);
+    if err then ioerror(err, "in file.mapArray", this.tryGetPath(), offset);
+  }
+
+  var x = new DefaultRectangularArr(eltType=eltType, rank=D.rank,
+                                    idxType=D.idxType,
+                                    stridable=D.stridable, dom=D._value,
+                                    data=data, mappedBytes=len,
+                                    mappedSync=writeable && shared);
+  pragma "dont disable remote value forwarding"
+  proc help() {
+    D._value.add_arr(x);
+    if !noRefCount then
+      D._value.incRefCount();
+  }
+  help();
+  return _newArray(x);
+}
+
 proc file.length():int(64) {
   var err:syserr = ENOERR;
   var len:int(64) = 0;
@@ -720,20 +849,37 @@ proc open(out error:syserr, path:string="", mode:iomode, hints:iohints=IOHINT_NO
   var ret:file;
   ret.home = here;
   if (url != "") {
-    if (url.startsWith("hdfs://")) { // HDFS
-      var (host, port, file_path) = parse_hdfs_path(url);
+    // gzip+<url> reads or writes a compressed file at <url>, with the
+    // gzip plugin layered over the one that handles <url>.
+    const gzip = url.startsWith("gzip+");
+    const inner_url = if gzip then url.substring(6..url.length) else url;
+
+    proc open_usr(file_path:string, fs:c_void_ptr, fns:qio_file_functions_ptr_t):syserr {
+      if gzip then
+        return gzip_file_open_access_usr(ret._file_internal, file_path.c_str(), _modestring(mode).c_str(), hints, local_style, fs, fns);
+      return qio_file_open_access_usr(ret._file_internal, file_path.c_str(), _modestring(mode).c_str(), hints, local_style, fs, fns);
+    }
+
+    if (inner_url.startsWith("hdfs://")) { // HDFS
+      var (host, port, file_path) = parse_hdfs_path(inner_url);
       var fs:c_void_ptr;
       error = hdfs_connect(fs, host.c_str(), port);
       if error then ioerror(error, "Unable to connect to HDFS", host);
-      error = qio_file_open_access_usr(ret._file_internal, file_path.c_str(), _modestring(mode).c_str(), hints, local_style, fs, hdfs_function_struct_ptr);
+      error = open_usr(file_path, fs, hdfs_function_struct_ptr);
       // Since we don't have an auto-destructor for this, we actually need to make
       // the reference count 1 on this FS after we open this file so that we will
       // disconnect once we close this file.
       hdfs_do_release(fs);
       if error then ioerror(error, "Unable to open file in HDFS", url);
-    } else if (url.startsWith("http://", "https://", "ftp://", "ftps://", "smtp://", "smtps://", "imap://", "imaps://"))  { // Curl
-      error = qio_file_open_access_usr(ret._file_internal, url.c_str(), _modestring(mode).c_str(), hints, local_style, c_nil, curl_function_struct_ptr);
+    } else if (inner_url.startsWith("http://", "https://", "ftp://", "ftps://", "smtp://", "smtps://", "imap://", "imaps://"))  { // Curl
+      error = open_usr(inner_url, c_nil, curl_function_struct_ptr);
       if error then ioerror(error, "Unable to open URL", url);
+    } else if (inner_url.startsWith("gzip://")) { // gzip compressed local file
+      // gzip://<path> reads or writes <path> through the gzip plugin.
+      // See $CHPL_HOME/doc/technotes/README.gzip
+      var file_path = inner_url.substring(8..inner_url.length);
+      error = open_usr(file_path, c_nil, gzip_function_struct_ptr);
+      if error then ioerror(error, "Unable to open gzip file", file_path);
     } else {
       ioerror(ENOENT:syserr, "Invalid URL passed to open");
     }
@@ -1141,24 +1287,32 @@ proc file.reader(param kind=iokind.dynamic, param locking=true, start:int(64) =
 }
 
 // for convenience..
-proc file.lines(out error:syserr, param locking:bool = true, start:int(64) = 0, end:int(64) = max(int(64)), hints:iohints = IOHINT_NONE, in local_style:iostyle = this._style) {
+// Each line includes its delimiter, which is '\n' unless another byte
+// is given.  A forall loop over the result reads the file in parallel.
+proc file.lines(out error:syserr, param locking:bool = true, start:int(64) = 0, end:int(64) = max(int(64)), hints:iohints = IOHINT_NONE, in local_style:iostyle = this._style, delimiter:uint(8) = 0x0a) {
   check();
 
   local_style.string_format = QIO_STRING_FORMAT_TOEND;
-  local_style.string_end = 0x0a; // '\n'
+  local_style.string_end = delimiter;
 
   param kind = iokind.dynamic;
   var ret:ItemReader(string, kind, locking);
   on this.home {
     var ch = new channel(false, kind, locking, this, error, hints, start, end, local_style);
-    ret = new ItemReader(string, kind, locking, ch);
+    var dev, ino:int(64);
+    if this._identity(dev, ino) {
+      dev = -1;
+      ino = -1;
+    }
+    ret = new ItemReader(string, kind, locking, ch, this, start, end, hints,
+                         delimiter, dev, ino);
   }
   return ret;
 }
 
-proc file.lines(param locking:bool = true, start:int(64) = 0, end:int(64) = max(int(64)), hints:iohints = IOHINT_NONE, style:iostyle = this._style) {
+proc file.lines(param locking:bool = true, start:int(64) = 0, end:int(64) = max(int(64)), hints:iohints = IOHINT_NONE, style:iostyle = this._style, delimiter:uint(8) = 0x0a) {
   var err:syserr = ENOERR;
-  var ret = this.lines(err, locking, start, end, hints, style);
+  var ret = this.lines(err, locking, start, end, hints, style, delimiter);
   if err then ioerror(err, "in file.lines", this.tryGetPath());
   return ret;
 }
@@ -1504,6 +1658,30 @@ inline proc _write_one_internal(_channel_internal:qio_channel_ptr_t, param kind:
   return err;
 }
 
+// Returns the path and identity (see file._identity) of the file that
+// _skip_external_internal would hand out, without moving the channel,
+// or false if the channel can't be used that way.
+proc _external_file_internal(_channel_internal:qio_channel_ptr_t, ref path:string, ref dev:int(64), ref ino:int(64)):bool {
+  var tmp:c_string_copy;
+  if qio_channel_external_file(false, _channel_internal, tmp, dev, ino) then
+    return false;
+  // This uses the version of toString that steals its operand.
+  path = toString(tmp);
+  return true;
+}
+
+// Moves the channel past len bytes that the caller will transfer
+// directly with the file at path, starting at offset. Returns false
+// if the channel can't be used that way.
+proc _skip_external_internal(_channel_internal:qio_channel_ptr_t, len:int(64), ref path:string, ref offset:int(64)):bool {
+  var tmp:c_string_copy;
+  if qio_channel_skip_external(false, _channel_internal, len, tmp, offset) then
+    return false;
+  // This uses the version of toString that steals its operand.
+  path = toString(tmp);
+  return true;
+}
+
 /* Returns true if we read all the args,
    false if we encountered EOF (or possibly another error and didn't halt)*/
 inline proc channel.read(inout args ...?k,
@@ -1728,6 +1906,87 @@ proc channel.readstring(ref str_out:string, len:int(64) = -1):bool {
   }
 }
 
+// channel.readfields: read one delimited record, such as a line of a
+// CSV file, into the fields of a record with a single runtime call.
+// arg: rec      -> The record to read into. Its fields must be integral,
+//                  real, or string; an empty numeric field leaves that
+//                  field unchanged. Fields may be "quoted", with ""
+//                  standing for a quote inside them.
+// arg: delims   -> The characters that separate fields. If this
+//                  includes space or tab, a run of them counts as one.
+// arg: out error-> On completion, the error code (possibly EOF). A record
+//                  with the wrong number of fields is EFORMAT, and one
+//                  with a number that does not fit its field's type is
+//                  ERANGE. On any error the record is not consumed and
+//                  no fields are set.
+// return: true  -> We read a record
+//         false -> We have encountered EOF or another error
+proc channel.readfields(ref rec:?t, delims:string = ",", out error:syserr):bool where isRecordType(t) {
+  param nfields = __primitive("num fields", t);
+  error = ENOERR;
+  on this.home {
+    var types: nfields*int(8);
+    var bits: nfields*int(8);
+    var nums: nfields*int(64);
+    var reals: nfields*real(64);
+    var strs: nfields*c_string_copy;
+
+    for param i in 1..nfields {
+      type ft = __primitive("field value by num", rec, i).type;
+      if isIntType(ft) {
+        types(i) = QIO_FIELD_INT;
+        bits(i) = numBits(ft):int(8);
+        nums(i) = __primitive("field value by num", rec, i):int(64);
+      } else if isUintType(ft) {
+        types(i) = QIO_FIELD_UINT;
+        bits(i) = numBits(ft):int(8);
+        nums(i) = __primitive("field value by num", rec, i):int(64);
+      } else if isRealType(ft) {
+        types(i) = QIO_FIELD_REAL;
+        reals(i) = __primitive("field value by num", rec, i):real(64);
+      } else if ft == string {
+        types(i) = QIO_FIELD_STRING;
+      } else {
+        compilerError("channel.readfields does not support fields of type ",
+                      typeToString(ft));
+      }
+    }
+
+    this.lock();
+    error = qio_channel_scan_fields(false, _channel_internal, delims.c_str(),
+                                    nfields:ssize_t, c_ptrTo(types(1)),
+                                    c_ptrTo(bits(1)),
+                                    c_ptrTo(nums(1)), c_ptrTo(reals(1)),
+                                    c_ptrTo(strs(1)));
+    this.unlock();
+
+    if !error {
+      for param i in 1..nfields {
+        type ft = __primitive("field value by num", rec, i).type;
+        if isIntegralType(ft) then
+          __primitive("field value by num", rec, i) = nums(i):ft;
+        else if isRealType(ft) then
+          __primitive("field value by num", rec, i) = reals(i):ft;
+        else
+          __primitive("field value by num", rec, i) = toString(strs(i));
+      }
+    }
+  }
+
+  return !error;
+}
+
+proc channel.readfields(ref rec, delims:string = ","):bool {
+  var e:syserr = ENOERR;
+  this.readfields(rec, delims, error=e);
+  if !e then return true;
+  else if e == EEOF then return false;
+  else {
+    this._ch_ioerror(e, "in channel.readfields(ref rec, delims:string)");
+    return false;
+  }
+}
+
 inline proc channel.readbits(out v:uint(64), nbits:int(8), out error:syserr):bool {
   var tmp:ioBits;
   var ret:bool;
@@ -1966,6 +2225,20 @@ record ItemReader {
   param kind:iokind;
   param locking:bool;
   var ch:channel(false,kind,locking);
+  // When the items come from a region of a file and each one ends with
+  // _delimiter (as for file.lines()), a forall loop splits the region
+  // into pieces and reads each piece with its own channel.  Otherwise
+  // _delimiter is -1 and forall loops read ch on one task.
+  var _file:file;
+  var _start:int(64);
+  var _end:int(64) = max(int(64));
+  var _hints:iohints = IOHINT_NONE;
+  var _delimiter:int = -1;
+  // The device and inode numbers of _file, if known, so that a follower
+  // on another locale only reads from the file opened by name there if
+  // it is the same file.
+  var _dev:int(64) = -1;
+  var _ino:int(64) = -1;
   proc read(out arg:ItemType, out error:syserr):bool {
     return ch.read(arg, error=error);
   }
@@ -1982,6 +2255,162 @@ record ItemReader {
     }
   }
 
+  iter these(param tag:iterKind) where tag == iterKind.leader {
+    // Pieces smaller than this aren't worth a channel of their own.
+    param minPiece = 64 * 1024;
+
+    if _delimiter < 0 {
+      // The follower reads everything from ch.
+      yield (0..-1,);
+    } else {
+      const lo = _start;
+      const hi = min(_end, _file.length());
+      if hi > lo {
+        // Divide the region among locales.  If the file system says
+        // where each chunk of the file lives, read the chunk there;
+        // otherwise everything is read where the file is open.
+        var chunkLen:int(64);
+        on _file.home {
+          if qio_get_chunk(_file._file_internal, chunkLen) then chunkLen = 0;
+        }
+
+        var regionsDom = {0..#0};
+        var regionLo, regionHi:[regionsDom] int(64);
+        var regionLoc:[regionsDom] int;
+        var bytesOn:[0..#numLocales] int(64);
+
+        proc addRegion(rlo:int(64), rhi:int(64), locid:int) {
+          const n = regionsDom.numIndices;
+          if n > 0 && regionLoc[n-1] == locid && regionHi[n-1] == rlo {
+            regionHi[n-1] = rhi;
+          } else {
+            regionsDom = {0..#n+1};
+            regionLo[n] = rlo;
+            regionHi[n] = rhi;
+            regionLoc[n] = locid;
+          }
+          bytesOn[locid] += rhi - rlo;
+        }
+
+        if numLocales > 1 && chunkLen > 0 {
+          var clo = lo;
+          while clo < hi {
+            const chi = min((clo / chunkLen + 1) * chunkLen, hi);
+            const locs = _file.localesForRegion(clo, chi);
+            var locid = _file.home.id;
+            if locs.numIndices < numLocales {
+              // Among the locales holding the chunk, pick the one with
+              // the least to read so far.
+              var least = max(int(64));
+              for loc in locs do
+                if bytesOn[loc.id] < least {
+                  least = bytesOn[loc.id];
+                  locid = loc.id;
+                }
+            }
+            addRegion(clo, chi, locid);
+            clo = chi;
+          }
+        } else {
+          addRegion(lo, hi, _file.home.id);
+        }
+
+        coforall loc in Locales {
+          if bytesOn[loc.id] > 0 {
+            on loc {
+              // Cut this locale's regions into enough pieces to keep its
+              // tasks busy, and hand them out as tasks become free.
+              const numTasks = max(1, here.maxTaskPar);
+              const pieceLen = max(minPiece, bytesOn[loc.id] / (4 * numTasks));
+              var piecesDom = {0..#0};
+              var pieceLo, pieceHi:[piecesDom] int(64);
+              for r in regionsDom {
+                if regionLoc[r] != loc.id then continue;
+                var plo = regionLo[r];
+                const rhi = regionHi[r];
+                while plo < rhi {
+                  const phi = if rhi - plo < 2 * pieceLen then rhi
+                              else plo + pieceLen;
+                  const n = piecesDom.numIndices;
+                  piecesDom = {0..#n+1};
+                  pieceLo[n] = plo;
+                  pieceHi[n] = phi;
+                  plo = phi;
+                }
+              }
+              var next:atomic int;
+              coforall tid in 0..#min(numTasks, piecesDom.numIndices) {
+                while true {
+                  const i = next.fetchAdd(1);
+                  if i >= piecesDom.numIndices then break;
+                  yield (pieceLo[i]..pieceHi[i]-1,);
+                }
+              }
+            }
+          }
+        }
+      }
+    }
+  }
+
+  iter these(param tag:iterKind, followThis) where tag == iterKind.follower {
+    if _delimiter < 0 {
+      for x in these() do yield x;
+    } else {
+      const piece = followThis(1);
+
+      // Read from a copy of the file opened here, if this locale can
+      // open it and it is the same file, rather than through the locale
+      // that has it open.  A different file, or one whose identity we
+      // can't check, is read through the home locale.
+      var err:syserr = ENOERR;
+      var f = _file;
+      var opened = false;
+      if f.home != here && _dev >= 0 {
+        var localFile = open(err, _file.tryGetPath(), iomode.r, _hints);
+        if !err {
+          var dev, ino:int(64);
+          if !localFile._identity(dev, ino) && dev == _dev && ino == _ino {
+            f = localFile;
+            opened = true;
+          } else {
+            localFile.close();
+          }
+        }
+      }
+
+      // A piece holds the items that start in it.  Unless the piece
+      // starts the region, back up a byte and skip to the end of the
+      // item that straddles (or ends right before) its start.
+      const skip = piece.low > _start;
+      var rd = f.reader(kind=kind, locking=false,
+                        start=if skip then piece.low - 1 else piece.low,
+                        end=_end, hints=_hints, style=ch._style());
+      var atEnd = false;
+      if skip {
+        on rd.home {
+          while true {
+            const got = qio_channel_read_byte(false, rd._channel_internal);
+            if got < 0 {
+              atEnd = true;
+              break;
+            }
+            if got == _delimiter then break;
+          }
+        }
+      }
+      if !atEnd {
+        while rd.offset() <= piece.high {
+          var x:ItemType;
+          if !rd.read(x) then break;
+          yield x;
+        }
+      }
+      rd.close();
+      if opened then f.close();
+    }
+  }
+
   /* It would be nice to be able to handle errors
      when reading with these()
      but it's not clear how to get the error argument
@@ -2095,6 +2524,28 @@ class ChannelWriter : Writer {
     }
   }
 
+  // See _external_file_internal.
+  proc _fileForParallel(ref path:string, ref dev:int(64), ref ino:int(64)):bool {
+    var ok = false;
+    if ! err {
+      on this {
+        ok = _external_file_internal(_channel_internal, path, dev, ino);
+      }
+    }
+    return ok;
+  }
+
+  // See _skip_external_internal.
+  proc _skipForParallel(len:int(64), ref path:string, ref offset:int(64)):bool {
+    var ok = false;
+    if ! err {
+      on this {
+        ok = _skip_external_internal(_channel_internal, len, path, offset);
+      }
+    }
+    return ok;
+  }
+
   proc writeThis(w:Writer) {
     // MPF - I don't understand why I had to add this,
     // but without it test/modules/diten/returnClassDiffModule5.chpl fails.
@@ -2146,6 +2597,28 @@ class ChannelReader : Reader {
     }
   }
 
+  // See _external_file_internal.
+  proc _fileForParallel(ref path:string, ref dev:int(64), ref ino:int(64)):bool {
+    var ok = false;
+    if ! err {
+      on this {
+        ok = _external_file_internal(_channel_internal, path, dev, ino);
+      }
+    }
+    return ok;
+  }
+
+  // See _skip_external_internal.
+  proc _skipForParallel(len:int(64), ref path:string, ref offset:int(64)):bool {
+    var ok = false;
+    if ! err {
+      on this {
+        ok = _skip_external_internal(_channel_internal, len, path, offset);
+      }
+    }
+    return ok;
+  }
+
   proc writeThis(w:Writer) {
     compilerError("writeThis on ChannelReader called");
   }
@@ -3937,6 +4410,7 @@ extern const FTYPE_NONE   : c_int;
 extern const FTYPE_HDFS   : c_int;
 extern const FTYPE_LUSTRE : c_int;
 extern const FTYPE_CURL   : c_int;
+extern const FTYPE_GZIP   : c_int;
 
 proc file.fstype():int {
   var t:c_int;
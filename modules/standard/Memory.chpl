@@ -43,6 +43,98 @@ proc memoryUsed() {
   return chpl_memoryUsed();
 }
 
+// The page mode used for large array data on the current locale:
+// "none", "thp" (transparent huge pages) or "hugetlb".  It is set with
+// --memHugePages or the CHPL_RT_HUGE_PAGES environment variable.
+proc arrayPageMode(): string {
+  extern proc chpl_mem_arrayPageModeName(): c_string;
+  return toString(chpl_mem_arrayPageModeName());
+}
+
+//
+// Counters-only memory statistics.  These are kept when the program is
+// run with the CHPL_RT_MEM_COUNTERS environment variable set, and are
+// much cheaper than --memTrack.  Each query reports on the locale it
+// is called on.  Byte counts are the sizes of the blocks the allocator
+// handed out.
+//
+proc locale.memoryInUse(): uint(64) {
+  pragma "insert line file info"
+  extern proc chpl_memCountersInUse(): uint(64);
+
+  var ret: uint(64);
+  on this do ret = chpl_memCountersInUse();
+  return ret;
+}
+
+proc locale.memoryHighWater(): uint(64) {
+  pragma "insert line file info"
+  extern proc chpl_memCountersHighWater(): uint(64);
+
+  var ret: uint(64);
+  on this do ret = chpl_memCountersHighWater();
+  return ret;
+}
+
+proc locale.memoryTotalAllocated(): uint(64) {
+  pragma "insert line file info"
+  extern proc chpl_memCountersTotalAllocated(): uint(64);
+
+  var ret: uint(64);
+  on this do ret = chpl_memCountersTotalAllocated();
+  return ret;
+}
+
+proc locale.memoryTotalFreed(): uint(64) {
+  pragma "insert line file info"
+  extern proc chpl_memCountersTotalFreed(): uint(64);
+
+  var ret: uint(64);
+  on this do ret = chpl_memCountersTotalFreed();
+  return ret;
+}
+
+// The number of allocations and bytes allocated for one memory
+// description (e.g., "array elements"), since the program started.
+record MemDescCounter {
+  var description: string;
+  var allocations: uint(64);
+  var bytes: uint(64);
+}
+
+// Returns a MemDescCounter for every memory description that has had
+// at least one allocation on this locale.
+proc locale.memoryByDescription() {
+  pragma "insert line file info"
+  extern proc chpl_memCountersNumDescs(): c_int;
+  extern proc chpl_memCountersDescName(desc: c_int): c_string;
+  extern proc chpl_memCountersDescAllocations(desc: c_int): uint(64);
+  extern proc chpl_memCountersDescBytes(desc: c_int): uint(64);
+
+  var numDescs, numUsed: int;
+  on this {
+    numDescs = chpl_memCountersNumDescs();
+    for i in 0..#numDescs do
+      if chpl_memCountersDescAllocations(i:c_int) > 0 then
+        numUsed += 1;
+  }
+
+  var counters: [1..numUsed] MemDescCounter;
+  on this {
+    var j = 1;
+    for i in 0..#numDescs {
+      const allocations = chpl_memCountersDescAllocations(i:c_int);
+      if allocations > 0 && j <= numUsed {
+        counters[j] = new MemDescCounter(toString(chpl_memCountersDescName(i:c_int)),
+                                         allocations,
+                                         chpl_memCountersDescBytes(i:c_int));
+        j += 1;
+      }
+    }
+  }
+  return counters;
+}
+
 proc printMemTable(thresh=0) {
   pragma "insert line file info" 
   extern proc chpl_printMemTable(thresh);
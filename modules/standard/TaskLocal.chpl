@@ -0,0 +1,84 @@
+/*
+ * Copyright 2004-2015 Cray Inc.
+ * Other additional copyright holders may be indicated within.
+ * 
+ * The entirety of this work is licensed under the Apache License,
+ * Version 2.0 (the "License"); you may not use this file except
+ * in compliance with the License.
+ * 
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ *  Task-Local Storage
+ *
+ *  A ``taskLocal`` record names a variable of which every task has its
+ *  own copy.  A task's copy starts out zeroed the first time that task
+ *  refers to it, lives as long as the task does, and is freed
+ *  automatically when the task ends.  This is useful for per-task
+ *  scratch space that would otherwise have to be allocated inside
+ *  every iteration of a forall loop:
+ *
+ *  .. code-block:: chapel
+ *
+ *    use TaskLocal;
+ *
+ *    var count: taskLocal(int);
+ *    forall i in 1..n do
+ *      count.get() += 1;   // no races: each task updates its own count
+ *
+ *  Access is cheap: after a task's first reference it is an index into
+ *  that task's private data.  The element type must be a bool or
+ *  numeric type, since task copies are created by zeroing memory and
+ *  are freed without being destroyed.  Each ``taskLocal`` record uses
+ *  up one key for the rest of the program run, so they are best
+ *  declared once and reused rather than created inside loops.
+ */
+module TaskLocal {
+
+  /*
+    A variable of type `eltType` with a separate copy for each task.
+    Copying the record yields a second name for the same variable.
+   */
+  record taskLocal {
+    type eltType;
+    const key: TaskLocal_internal.chpl_task_localKey_t =
+      TaskLocal_internal.newKey(eltType);
+
+    /*
+      Returns a reference to the calling task's copy of this variable.
+     */
+    inline proc get() ref {
+      const p = TaskLocal_internal.chpl_task_getLocal(
+                  key, TaskLocal_internal.sizeof(eltType));
+      const ep = __primitive("cast", c_ptr(eltType), p);
+      return ep.deref();
+    }
+  }
+}
+
+module TaskLocal_internal {
+  extern type chpl_task_localKey_t = int(32);
+  extern proc chpl_task_getLocal(key: chpl_task_localKey_t,
+                                 size: size_t): c_void_ptr;
+  extern proc sizeof(type x): size_t;
+
+  // Keys come from a single counter on locale 0 so that a taskLocal
+  // declared on one locale names the same slot on every other one.
+  var nextKey: atomic int(32);
+
+  proc newKey(type eltType): chpl_task_localKey_t {
+    if !(isBoolType(eltType) || isNumericType(eltType)) then
+      compilerError("taskLocal element type must be a bool or numeric type, ",
+                    "not ", typeToString(eltType));
+    return nextKey.fetchAdd(1);
+  }
+}
@@ -54,6 +54,277 @@ static inline memory_order _defaultOfMemoryOrder(void) {
   return memory_order_seq_cst;
 }
 
+//
+// When the compiler has them (GCC 4.7 and later, and the compilers that
+// mimic it) we build the atomics on the __atomic builtins.  These are
+// what <stdatomic.h> itself is implemented with, and unlike the older
+// __sync builtins they honor the requested memory order and provide a
+// real weak compare-and-swap.  We can't simply include <stdatomic.h>
+// because this interface reuses the C11 names (memory_order,
+// atomic_flag, atomic_int_least8_t, ...) for its own declarations.
+// Otherwise, we fall back to the __sync builtins.
+//
+#if defined(__ATOMIC_SEQ_CST) && !defined(_CRAYC)
+#define CHPL_ATOMICS_USE_ATOMIC_BUILTINS 1
+#endif
+
+#ifdef CHPL_ATOMICS_USE_ATOMIC_BUILTINS
+
+//
+// Map our memory orders onto the __atomic ones, strengthening any that
+// are not valid for the kind of operation at hand (e.g., a release
+// load) to the nearest one that is.
+//
+static inline int _chpl_atomic_order(memory_order order) {
+  switch (order) {
+  case memory_order_relaxed: return __ATOMIC_RELAXED;
+  case memory_order_consume: return __ATOMIC_CONSUME;
+  case memory_order_acquire: return __ATOMIC_ACQUIRE;
+  case memory_order_release: return __ATOMIC_RELEASE;
+  case memory_order_acq_rel: return __ATOMIC_ACQ_REL;
+  default:                   return __ATOMIC_SEQ_CST;
+  }
+}
+
+static inline int _chpl_atomic_load_order(memory_order order) {
+  switch (order) {
+  case memory_order_relaxed: return __ATOMIC_RELAXED;
+  case memory_order_consume: return __ATOMIC_CONSUME;
+  case memory_order_acquire:
+  case memory_order_release:
+  case memory_order_acq_rel: return __ATOMIC_ACQUIRE;
+  default:                   return __ATOMIC_SEQ_CST;
+  }
+}
+
+static inline int _chpl_atomic_store_order(memory_order order) {
+  switch (order) {
+  case memory_order_relaxed: return __ATOMIC_RELAXED;
+  case memory_order_consume:
+  case memory_order_acquire:
+  case memory_order_release:
+  case memory_order_acq_rel: return __ATOMIC_RELEASE;
+  default:                   return __ATOMIC_SEQ_CST;
+  }
+}
+
+// the failure order of a compare-and-swap can't include a release
+static inline int _chpl_atomic_cas_fail_order(memory_order order) {
+  switch (order) {
+  case memory_order_relaxed:
+  case memory_order_release: return __ATOMIC_RELAXED;
+  case memory_order_consume: return __ATOMIC_CONSUME;
+  case memory_order_acquire:
+  case memory_order_acq_rel: return __ATOMIC_ACQUIRE;
+  default:                   return __ATOMIC_SEQ_CST;
+  }
+}
+
+
+static inline void atomic_thread_fence(memory_order order)
+{
+  __atomic_thread_fence(_chpl_atomic_order(order));
+}
+static inline void atomic_signal_thread_fence(memory_order order)
+{
+  __atomic_signal_fence(_chpl_atomic_order(order));
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+////               Test & Set and Clear for flag(boolean)                 ////
+//////////////////////////////////////////////////////////////////////////////
+static inline chpl_bool atomic_flag_test_and_set_explicit(atomic_flag *obj, memory_order order) {
+  return __atomic_exchange_n(obj, true, _chpl_atomic_order(order));
+}
+static inline chpl_bool atomic_flag_test_and_set(atomic_flag *obj) {
+  return atomic_flag_test_and_set_explicit(obj, memory_order_seq_cst);
+}
+
+static inline void atomic_flag_clear_explicit(atomic_flag *obj, memory_order order) {
+  __atomic_store_n(obj, false, _chpl_atomic_store_order(order));
+}
+static inline void atomic_flag_clear(atomic_flag *obj) {
+  atomic_flag_clear_explicit(obj, memory_order_seq_cst);
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+////                      START OF INTEGER ATOMICS BASE                   ////
+//////////////////////////////////////////////////////////////////////////////
+#define DECLARE_ATOMICS_BASE(type, basetype) \
+static inline chpl_bool atomic_is_lock_free_ ## type(atomic_ ## type * obj) { \
+  return __atomic_always_lock_free(sizeof(basetype), 0); \
+} \
+static inline void atomic_init_ ## type(atomic_ ## type * obj, basetype value) { \
+  *obj = value; \
+} \
+static inline void atomic_destroy_ ## type(atomic_ ## type * obj) { \
+} \
+static inline void atomic_store_explicit_ ## type(atomic_ ## type * obj, basetype value, memory_order order) { \
+  __atomic_store_n(obj, value, _chpl_atomic_store_order(order)); \
+} \
+static inline void atomic_store_ ## type(atomic_ ## type * obj, basetype value) { \
+  atomic_store_explicit_ ## type(obj, value, memory_order_seq_cst); \
+} \
+static inline basetype atomic_load_explicit_ ## type(atomic_ ## type * obj, memory_order order) { \
+  return __atomic_load_n(obj, _chpl_atomic_load_order(order)); \
+} \
+static inline basetype atomic_load_ ## type(atomic_ ## type * obj) { \
+  return atomic_load_explicit_ ## type(obj, memory_order_seq_cst); \
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+////                 START OF INTEGER ATOMIC EXCHANGE OPS                 ////
+//////////////////////////////////////////////////////////////////////////////
+#define DECLARE_ATOMICS_EXCHANGE_OPS(type, basetype) \
+static inline basetype atomic_exchange_explicit_ ## type(atomic_ ## type * obj, basetype value, memory_order order) { \
+  return __atomic_exchange_n(obj, value, _chpl_atomic_order(order)); \
+} \
+static inline basetype atomic_exchange_ ## type(atomic_ ## type * obj, basetype value) { \
+  return atomic_exchange_explicit_ ## type(obj, value, memory_order_seq_cst); \
+} \
+static inline chpl_bool atomic_compare_exchange_strong_explicit_ ## type(atomic_ ## type * obj, basetype expected, basetype desired, memory_order order) { \
+  return __atomic_compare_exchange_n(obj, &expected, desired, false, \
+                                     _chpl_atomic_order(order), \
+                                     _chpl_atomic_cas_fail_order(order)); \
+} \
+static inline chpl_bool atomic_compare_exchange_strong_ ## type(atomic_ ## type * obj, basetype expected, basetype desired) { \
+  return atomic_compare_exchange_strong_explicit_ ## type(obj, expected, desired, memory_order_seq_cst); \
+} \
+static inline chpl_bool atomic_compare_exchange_weak_explicit_ ## type(atomic_ ## type * obj, basetype expected, basetype desired, memory_order order) { \
+  return __atomic_compare_exchange_n(obj, &expected, desired, true, \
+                                     _chpl_atomic_order(order), \
+                                     _chpl_atomic_cas_fail_order(order)); \
+} \
+static inline chpl_bool atomic_compare_exchange_weak_ ## type(atomic_ ## type * obj, basetype expected, basetype desired) { \
+  return atomic_compare_exchange_weak_explicit_ ## type(obj, expected, desired, memory_order_seq_cst); \
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+////              START OF INTEGER ATOMIC FETCH OPERATIONS                ////
+//////////////////////////////////////////////////////////////////////////////
+#define DECLARE_ATOMICS_FETCH_OP(type, op) \
+static inline type atomic_fetch_ ## op ## _explicit_ ## type(atomic_ ## type * obj, type operand, memory_order order) { \
+  return __atomic_fetch_ ## op(obj, operand, _chpl_atomic_order(order)); \
+} \
+static inline type atomic_fetch_ ## op ## _ ## type(atomic_ ## type * obj, type operand) { \
+  return atomic_fetch_ ## op ## _explicit_ ## type(obj, operand, memory_order_seq_cst); \
+}
+
+#define DECLARE_ATOMICS_FETCH_OPS(type) \
+  DECLARE_ATOMICS_FETCH_OP(type, add) \
+  DECLARE_ATOMICS_FETCH_OP(type, sub) \
+  DECLARE_ATOMICS_FETCH_OP(type, or) \
+  DECLARE_ATOMICS_FETCH_OP(type, and) \
+  DECLARE_ATOMICS_FETCH_OP(type, xor)
+
+
+///////////////////////////////////////////////////////////////////////////////
+////                       START OF REAL ATOMICS BASE                     ////
+//////////////////////////////////////////////////////////////////////////////
+//
+// The reals are operated upon through their bit patterns, viewed as
+// unsigned integers of the same size.  Note that this means that
+// compare-and-swap compares bit patterns rather than values.
+//
+#define DECLARE_REAL_ATOMICS_BASE(type, uinttype) \
+typedef union { type r; uinttype u; } _chpl_atomic_bits_ ## type; \
+static inline chpl_bool atomic_is_lock_free_ ## type(atomic_ ## type * obj) { \
+  return __atomic_always_lock_free(sizeof(uinttype), 0); \
+} \
+static inline void atomic_init_ ## type(atomic_ ## type * obj, type value) { \
+  assert(sizeof(type) == sizeof(uinttype)); \
+  *obj = value; \
+} \
+static inline void atomic_destroy_ ## type(atomic_ ## type * obj) { \
+} \
+static inline void atomic_store_explicit_ ## type(atomic_ ## type * obj, type value, memory_order order) { \
+  _chpl_atomic_bits_ ## type v; \
+  v.r = value; \
+  __atomic_store_n((uinttype *) obj, v.u, _chpl_atomic_store_order(order)); \
+} \
+static inline void atomic_store_ ## type(atomic_ ## type * obj, type value) { \
+  atomic_store_explicit_ ## type(obj, value, memory_order_seq_cst); \
+} \
+static inline type atomic_load_explicit_ ## type(atomic_ ## type * obj, memory_order order) { \
+  _chpl_atomic_bits_ ## type v; \
+  v.u = __atomic_load_n((uinttype *) obj, _chpl_atomic_load_order(order)); \
+  return v.r; \
+} \
+static inline type atomic_load_ ## type(atomic_ ## type * obj) { \
+  return atomic_load_explicit_ ## type(obj, memory_order_seq_cst); \
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+////                START OF REAL ATOMICS EXCHANGE OPS                    ////
+//////////////////////////////////////////////////////////////////////////////
+#define DECLARE_REAL_ATOMICS_EXCHANGE_OPS(type, uinttype) \
+static inline type atomic_exchange_explicit_ ## type(atomic_ ## type * obj, type value, memory_order order) { \
+  _chpl_atomic_bits_ ## type v, ret; \
+  v.r = value; \
+  ret.u = __atomic_exchange_n((uinttype *) obj, v.u, _chpl_atomic_order(order)); \
+  return ret.r; \
+} \
+static inline type atomic_exchange_ ## type(atomic_ ## type * obj, type value) { \
+  return atomic_exchange_explicit_ ## type(obj, value, memory_order_seq_cst); \
+} \
+static inline chpl_bool atomic_compare_exchange_strong_explicit_ ## type(atomic_ ## type * obj, type expected, type desired, memory_order order) { \
+  _chpl_atomic_bits_ ## type e, d; \
+  e.r = expected; \
+  d.r = desired; \
+  return __atomic_compare_exchange_n((uinttype *) obj, &e.u, d.u, false, \
+                                     _chpl_atomic_order(order), \
+                                     _chpl_atomic_cas_fail_order(order)); \
+} \
+static inline chpl_bool atomic_compare_exchange_strong_ ## type(atomic_ ## type * obj, type expected, type desired) { \
+  return atomic_compare_exchange_strong_explicit_ ## type(obj, expected, desired, memory_order_seq_cst); \
+} \
+static inline chpl_bool atomic_compare_exchange_weak_explicit_ ## type(atomic_ ## type * obj, type expected, type desired, memory_order order) { \
+  _chpl_atomic_bits_ ## type e, d; \
+  e.r = expected; \
+  d.r = desired; \
+  return __atomic_compare_exchange_n((uinttype *) obj, &e.u, d.u, true, \
+                                     _chpl_atomic_order(order), \
+                                     _chpl_atomic_cas_fail_order(order)); \
+} \
+static inline chpl_bool atomic_compare_exchange_weak_ ## type(atomic_ ## type * obj, type expected, type desired) { \
+  return atomic_compare_exchange_weak_explicit_ ## type(obj, expected, desired, memory_order_seq_cst); \
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+////                   START OF REAL ATOMICS FETCH OPS                    ////
+//////////////////////////////////////////////////////////////////////////////
+//
+// There is no hardware floating point fetch-and-add, so we loop on a
+// weak compare-and-swap.  On failure the builtin refreshes our copy of
+// the current value, so each retry costs just the arithmetic.
+//
+#define DECLARE_REAL_ATOMICS_FETCH_OP(type, uinttype, op, sym) \
+static inline type atomic_fetch_ ## op ## _explicit_ ## type(atomic_ ## type * obj, type operand, memory_order order) { \
+  _chpl_atomic_bits_ ## type cur, desired; \
+  cur.u = __atomic_load_n((uinttype *) obj, __ATOMIC_RELAXED); \
+  do { \
+    desired.r = cur.r sym operand; \
+  } while (!__atomic_compare_exchange_n((uinttype *) obj, &cur.u, desired.u, \
+                                        true, _chpl_atomic_order(order), \
+                                        __ATOMIC_RELAXED)); \
+  return cur.r; \
+} \
+static inline type atomic_fetch_ ## op ## _ ## type(atomic_ ## type * obj, type operand) { \
+  return atomic_fetch_ ## op ## _explicit_ ## type(obj, operand, memory_order_seq_cst); \
+}
+
+#define DECLARE_REAL_ATOMICS_FETCH_OPS(type, uinttype) \
+  DECLARE_REAL_ATOMICS_FETCH_OP(type, uinttype, add, +) \
+  DECLARE_REAL_ATOMICS_FETCH_OP(type, uinttype, sub, -)
+
+#else // CHPL_ATOMICS_USE_ATOMIC_BUILTINS
+
 // Cray does not support __sync_synchronize so we use a cray specific memory
 // fence. Cray also does not support __sync_bool_compare_and_swap so we 
 // cheat our way around this using __sync_val_compare_and_swap
@@ -293,7 +564,7 @@ static inline type atomic_fetch_add_explicit_ ## type(atomic_ ## type * obj, typ
     desired_as_uint = *desired_as_uint_p; \
     success = my__sync_bool_compare_and_swap((uinttype *) obj, cur_as_uint, desired_as_uint); \
   } \
-  return desired; \
+  return cur; \
 } \
 static inline type atomic_fetch_add_ ## type(atomic_ ## type * obj, type operand) { \
   return atomic_fetch_add_explicit_ ## type(obj, operand, memory_order_seq_cst); \
@@ -317,13 +588,16 @@ static inline type atomic_fetch_sub_explicit_ ## type(atomic_ ## type * obj, typ
     desired_as_uint = *desired_as_uint_p; \
     success =  my__sync_bool_compare_and_swap((uinttype *) obj, cur_as_uint, desired_as_uint); \
   } \
-  return desired; \
+  return cur; \
 } \
 static inline type atomic_fetch_sub_ ## type(atomic_ ## type * obj, type operand) { \
   return atomic_fetch_sub_explicit_ ## type(obj, operand, memory_order_seq_cst); \
 } \
 
 
+#endif // CHPL_ATOMICS_USE_ATOMIC_BUILTINS
+
+
 // Actually declare the atomics for integer and real types using the above macros 
 DECLARE_ATOMICS_BASE(flag, chpl_bool);
 DECLARE_ATOMICS_EXCHANGE_OPS(flag, chpl_bool);
@@ -357,9 +631,11 @@ DECLARE_REAL_ATOMICS(_real64, uint64_t);
 #undef DECLARE_ATOMICS_BASE
 #undef DECLARE_ATOMICS_EXCHANGE_OPS
 #undef DECLARE_ATOMICS_FETCH_OPS
+#undef DECLARE_ATOMICS_FETCH_OP
 #undef DECLARE_REAL_ATOMICS_BASE
 #undef DECLARE_REAL_ATOMICS_EXCHANGE_OPS
 #undef DECLARE_REAL_ATOMICS_FETCH_OPS
+#undef DECLARE_REAL_ATOMICS_FETCH_OP
 #undef DECLARE_ATOMICS
 #undef DECLARE_REAL_ATOMICS
 
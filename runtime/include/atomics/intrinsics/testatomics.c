@@ -21,13 +21,14 @@
 #include <assert.h>
 
 #define test(type) { \
-  bool lockless; \
+  chpl_bool lockless; \
   atomic_ ## type a, b, c; \
   atomic_init_ ## type (&a, 1); \
   atomic_init_ ## type (&b, 2); \
   atomic_init_ ## type (&c, 3); \
   \
   lockless = atomic_is_lock_free_ ## type (&a); \
+  assert( lockless ); \
   \
   assert( 1 == atomic_load_ ## type (&a) ); \
   assert( 2 == atomic_load_ ## type (&b) ); \
@@ -67,6 +68,40 @@
   atomic_store_ ## type (&a, 0x12); \
   assert( 0x12 == atomic_fetch_and_ ## type (&a, 0x10) ); \
   assert( 0x10 == atomic_load_ ## type (&a) ); \
+  \
+  atomic_store_ ## type (&a, 10); \
+  assert( ! atomic_compare_exchange_weak_ ## type (&a, 100, 11) ); \
+  while ( ! atomic_compare_exchange_weak_ ## type (&a, 10, 11) ) ; \
+  assert( 11 == atomic_load_ ## type (&a) ); \
+}
+
+#define test_real(type) { \
+  atomic_ ## type a; \
+  atomic_init_ ## type (&a, 1.5); \
+  \
+  assert( 1.5 == atomic_load_ ## type (&a) ); \
+  \
+  atomic_store_ ## type (&a, 2.5); \
+  assert( 2.5 == atomic_load_ ## type (&a) ); \
+  \
+  assert( 2.5 == atomic_exchange_ ## type (&a, 3.5) ); \
+  assert( 3.5 == atomic_load_ ## type (&a) ); \
+  \
+  assert( ! atomic_compare_exchange_strong_ ## type (&a, 1.0, 4.5) ); \
+  assert( atomic_compare_exchange_strong_ ## type (&a, 3.5, 4.5) ); \
+  assert( 4.5 == atomic_load_ ## type (&a) ); \
+  \
+  assert( ! atomic_compare_exchange_weak_ ## type (&a, 1.0, 5.5) ); \
+  while ( ! atomic_compare_exchange_weak_ ## type (&a, 4.5, 5.5) ) ; \
+  assert( 5.5 == atomic_load_ ## type (&a) ); \
+  \
+  atomic_store_ ## type (&a, 10.0); \
+  assert( 10.0 == atomic_fetch_add_ ## type (&a, 2.0) ); \
+  assert( 12.0 == atomic_load_ ## type (&a) ); \
+  \
+  atomic_store_ ## type (&a, 10.0); \
+  assert( 10.0 == atomic_fetch_sub_ ## type (&a, 2.0) ); \
+  assert( 8.0 == atomic_load_ ## type (&a) ); \
 }
 
 int main(int argc, char** argv)
@@ -84,12 +119,17 @@ int main(int argc, char** argv)
     atomic_uint_least8_t tmp;
     atomic_load_uint_least8_t(&tmp);
   }
-  /*
   test(uint_least8_t);
   test(uint_least16_t);
   test(uint_least32_t);
   test(uint_least64_t);
   test(uintptr_t);
-  */
+  test(int_least8_t);
+  test(int_least16_t);
+  test(int_least32_t);
+  test(int_least64_t);
+
+  test_real(_real32);
+  test_real(_real64);
   return 0;
 }
@@ -199,7 +199,11 @@ void chpl_check_nil(void* ptr, int32_t lineno, const char* filename)
 
 static ___always_inline
 void* chpl_array_alloc(size_t nmemb, size_t eltSize, int32_t lineno, const char* filename) {
-  return chpl_mem_allocManyZero(nmemb, eltSize, CHPL_RT_MD_ARRAY_ELEMENTS, lineno, filename);
+  void* p;
+  p = chpl_mem_arrayAlloc(nmemb, eltSize, lineno, filename);
+  // Array data allocated "on" a sublocale lives in that sublocale's memory.
+  chpl_mem_localizeSubloc(p, nmemb*eltSize, chpl_task_getRequestedSubloc());
+  return p;
 }
 
 static ___always_inline
@@ -212,7 +216,7 @@ void* chpl_wide_array_alloc(int32_t dstNode, size_t nmemb, size_t eltSize, int32
 static ___always_inline
 void chpl_array_free(void* x, int32_t lineno, const char* filename)
 {
-  chpl_mem_free(x, lineno, filename);
+  chpl_mem_arrayFree(x, lineno, filename);
 }
 
 static ___always_inline
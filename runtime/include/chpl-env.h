@@ -0,0 +1,34 @@
+/*
+ * Copyright 2004-2015 Cray Inc.
+ * Other additional copyright holders may be indicated within.
+ * 
+ * The entirety of this work is licensed under the Apache License,
+ * Version 2.0 (the "License"); you may not use this file except
+ * in compliance with the License.
+ * 
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _CHPL_ENV_H_
+#define _CHPL_ENV_H_
+
+#include "chpltypes.h"
+
+//
+// Read a boolean runtime setting from the environment variable 'name'.
+// "1", "y", "yes", "t", "true" and "on" are true, and "0", "n", "no",
+// "f", "false" and "off" are false, ignoring case.  If the variable is
+// unset or empty the result is 'dflt'; any other value draws a warning
+// and also gives 'dflt'.
+//
+chpl_bool chpl_env_rt_get_bool(const char* name, chpl_bool dflt);
+
+#endif
@@ -118,6 +118,12 @@
           "task pool descriptor"),                                      \
         m(TASK_LIST_DESCRIPTOR,                                         \
           "task list descriptor"),                                      \
+        m(TASK_LOCAL_STORAGE,                                           \
+          "task-local storage"),                                        \
+        m(TASK_PROFILE_DATA,                                            \
+          "task profile data"),                                         \
+        m(TASK_REGION,                                                  \
+          "task memory region"),                                        \
         m(THREAD_PRIVATE_DATA,                                          \
           "thread private data"),                                       \
         m(THREAD_LIST_DESCRIPTOR,                                       \
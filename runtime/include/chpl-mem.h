@@ -44,6 +44,53 @@ void chpl_mem_exit(void);
 
 int chpl_mem_inited(void);
 
+//
+// Place the pages of [p, p+size) in the memory of the NUMA domain that
+// backs the given sublocale.  Only pages lying entirely within the
+// region are affected, so that neighboring allocations sharing a page
+// keep whatever placement they already had.  This is a no-op unless
+// the sublocale is a specific one, i.e., not c_sublocid_any or
+// c_sublocid_none.
+//
+void chpl_mem_localizeSubloc(void* p, size_t size, c_sublocid_t subloc);
+
+
+//
+// Large array data can be placed on huge pages to cut TLB misses.  The
+// page mode is chosen by the memHugePages config const or, failing
+// that, the CHPL_RT_HUGE_PAGES environment variable:
+//   "none"    : normal pages (the default)
+//   "thp"     : 2 MiB aligned memory advised for transparent huge pages
+//   "hugetlb" : hugetlbfs pages, falling back to "thp" when the huge
+//               page pool cannot supply an allocation
+// Arrays smaller than CHPL_MEM_HUGE_ARRAY_MIN always use normal pages.
+//
+typedef enum {
+  CHPL_MEM_PAGES_NORMAL,
+  CHPL_MEM_PAGES_THP,
+  CHPL_MEM_PAGES_HUGETLB
+} chpl_mem_pageMode_t;
+
+#define CHPL_MEM_HUGE_ARRAY_MIN ((size_t) 2 << 20)
+
+typedef struct {
+  chpl_mem_pageMode_t mode;     // mode in effect on this locale
+  size_t numHugetlb;            // arrays allocated on hugetlbfs pages
+  size_t numThp;                // arrays allocated for transparent ones
+  size_t numFallback;           // of numThp, those hugetlb couldn't take
+  size_t curBytes;              // bytes of huge-page arrays live now
+} chpl_mem_hugePageStats_t;
+
+extern chpl_mem_pageMode_t chpl_mem_arrayPageMode;
+extern size_t chpl_mem_numHugeArrays;
+
+void chpl_mem_setArrayPageMode(c_string configMode);
+c_string chpl_mem_arrayPageModeName(void);
+void chpl_mem_getHugePageStats(chpl_mem_hugePageStats_t* stats);
+void* chpl_mem_hugeArrayAlloc(size_t number, size_t size,
+                              int32_t lineno, c_string filename);
+chpl_bool chpl_mem_hugeArrayFree(void* p, int32_t lineno, c_string filename);
+
 
 static ___always_inline
 void* chpl_mem_allocMany(size_t number, size_t size,
@@ -87,13 +134,13 @@ void* chpl_mem_realloc(void* memAlloc, size_t size,
                        int32_t lineno, c_string filename) {
   void* moreMemAlloc;
 
-  chpl_memhook_realloc_pre(memAlloc, size, description,
-                           lineno, filename);
   if (size == 0) {
     chpl_memhook_free_pre(memAlloc, lineno, filename);
     chpl_free(memAlloc);
     return NULL;
   }
+  chpl_memhook_realloc_pre(memAlloc, size, description,
+                           lineno, filename);
   moreMemAlloc = chpl_realloc(memAlloc, size);
   chpl_memhook_realloc_post(moreMemAlloc, memAlloc, size, description,
                             lineno, filename);
@@ -106,6 +153,47 @@ void chpl_mem_free(void* memAlloc, int32_t lineno, c_string filename) {
   chpl_free(memAlloc);
 }
 
+//
+// Allocate and free the element storage for arrays.  The storage is
+// zeroed.
+//
+static ___always_inline
+void* chpl_mem_arrayAlloc(size_t number, size_t size,
+                          int32_t lineno, c_string filename) {
+  if (chpl_mem_arrayPageMode != CHPL_MEM_PAGES_NORMAL
+      && number * size >= CHPL_MEM_HUGE_ARRAY_MIN) {
+    void* p = chpl_mem_hugeArrayAlloc(number, size, lineno, filename);
+    if (p != NULL)
+      return p;
+  }
+  return chpl_mem_allocManyZero(number, size, CHPL_RT_MD_ARRAY_ELEMENTS,
+                                lineno, filename);
+}
+
+static ___always_inline
+void chpl_mem_arrayFree(void* p, int32_t lineno, c_string filename) {
+  if (chpl_mem_numHugeArrays > 0
+      && chpl_mem_hugeArrayFree(p, lineno, filename))
+    return;
+  chpl_mem_free(p, lineno, filename);
+}
+
+//
+// Task regions.  Memory that the compiler knows will not outlive the
+// task allocating it can come from a region belonging to that task.
+// Region memory is bump-allocated from large blocks, and whatever has
+// not been freed by the time the task ends is released all at once.
+// A region free reclaims space only when it (together with earlier
+// frees) is at the top of the region, so freeing in reverse order of
+// allocation, as nested scopes do, keeps the region small.  Region
+// memory may only be freed by the task that allocated it, and only
+// with chpl_mem_taskRegionFree().  The blocks are recorded under the
+// CHPL_RT_MD_TASK_REGION description.
+//
+void* chpl_mem_taskRegionAlloc(size_t size, int32_t lineno, c_string filename);
+void chpl_mem_taskRegionFree(void* p, int32_t lineno, c_string filename);
+void chpl_mem_taskRegionRelease(struct chpl_mem_taskRegion_s* region);
+
 // Provide a handle to instrument Chapel calls to memcpy.
 static ___always_inline
 void* chpl_memcpy(void* dest, const void* src, size_t num)
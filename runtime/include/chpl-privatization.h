@@ -23,11 +23,20 @@
 #include <stdint.h>
 #include "chpltypes.h"
 
-extern void** chpl_privateObjects; // privatized array and domain objects
-
 extern void chpl_privatization_init(void);
 
+// Privatized array, domain, and distribution objects are stored in a
+// node-local table indexed by pid.  Pids are allocated and released on
+// locale 0; the table entries are set and cleared on every locale.
+extern int64_t chpl_newPrivatizedPid(void);
+extern void chpl_freePrivatizedPid(int64_t);
+
+// The number of pids handed out so far, which bounds the part of the
+// table in use.  Freed pids are reused before this grows.
+extern int64_t chpl_numPrivatizedPids(void);
+
 extern void chpl_newPrivatizedClass(void*, int64_t);
+extern void chpl_clearPrivatizedClass(int64_t);
 extern void* chpl_getPrivatizedClass(int64_t);
 
 #endif // LAUNCHER
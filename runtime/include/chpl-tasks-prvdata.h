@@ -23,10 +23,25 @@
 // This header file provides chpl_comm_taskPrvData_t
 #include "chpl-comm-task-decls.h"
 
+// Task-local storage: one slot per key, each pointing to a block
+// allocated on first use and freed when the task ends, plus the task's
+// memory region (see chpl_mem_taskRegionAlloc()), also freed when the
+// task ends.  Tasks never share this; whoever copies task private data
+// into a new task must start the copy off with no slots and no region
+// (all zeroes).
+struct chpl_mem_taskRegion_s;
+
+typedef struct {
+  int32_t num_slots;
+  void**  slots;
+  struct chpl_mem_taskRegion_s* region;
+} chpl_task_localData_t;
+
 // The type for task private data
 typedef struct {
   chpl_bool serial_state;      // true: serialize execution
   chpl_comm_taskPrvData_t comm_data;
+  chpl_task_localData_t local_data;
 } chpl_task_prvData_t;
 
 #endif
@@ -210,6 +210,33 @@ void      chpl_task_setSerial(chpl_bool);
 chpl_task_prvData_t* chpl_task_getPrvData(void);
 #endif
 
+//
+// Task-local storage.  A key names a zero-initialized block of memory
+// of the given size that is private to each task using it.  The block
+// is allocated the first time a task asks for it and freed when that
+// task ends.  Keys are small non-negative integers handed out by the
+// module code; the same key must always be used with the same size.
+//
+typedef int32_t chpl_task_localKey_t;
+
+void* chpl_task_getLocalSlow(chpl_task_localData_t*,
+                             chpl_task_localKey_t, size_t);
+
+static inline
+void* chpl_task_getLocal(chpl_task_localKey_t key, size_t size) {
+  chpl_task_localData_t* ld = &chpl_task_getPrvData()->local_data;
+  if (key < ld->num_slots && ld->slots[key] != NULL)
+    return ld->slots[key];
+  return chpl_task_getLocalSlow(ld, key, size);
+}
+
+//
+// Free all task-local storage, including the memory region, belonging
+// to the given task private data.  Tasking layers call this when a
+// task's body returns.
+//
+void chpl_task_freeLocals(chpl_task_localData_t*);
+
 //
 // Returns the maximum width of parallelism the tasking layer expects
 // to be able to provide on the calling (sub)locale.  With some
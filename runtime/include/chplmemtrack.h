@@ -32,16 +32,29 @@
 // Memory tracking activated?
 extern chpl_bool chpl_memTrack;
 
+// Allocation profiling (--memProfile) activated?
+extern chpl_bool chpl_memProfile;
+
+// Counters-only statistics (CHPL_RT_MEM_COUNTERS) activated?
+extern chpl_bool chpl_memCounters;
+
 void chpl_setMemFlags(void);
+void chpl_initMemCounters(void);
 uint64_t chpl_memoryUsed(int32_t lineno, c_string filename);
 void chpl_printMemStat(int32_t lineno, c_string filename);
 void chpl_printLeakedMemTable(void);
 void chpl_printMemTable(int64_t threshold, int32_t lineno, c_string filename);
 void chpl_reportMemInfo(void);
+void chpl_printMemProfile(void);
 void chpl_track_malloc(void* memAlloc, size_t number, size_t size,
                        chpl_mem_descInt_t description,
                        int32_t lineno, c_string filename);
 void chpl_track_free(void* memAlloc, int32_t lineno, c_string filename);
+void chpl_track_malloc_sized(void* memAlloc, size_t number, size_t size,
+                             size_t usable, chpl_mem_descInt_t description,
+                             int32_t lineno, c_string filename);
+void chpl_track_free_sized(void* memAlloc, size_t usable,
+                           int32_t lineno, c_string filename);
 void chpl_track_realloc_pre(void* memAlloc, size_t size,
                          chpl_mem_descInt_t description,
                          int32_t lineno, c_string filename);
@@ -50,6 +63,22 @@ void chpl_track_realloc_post(void* moreMemAlloc,
                          chpl_mem_descInt_t description,
                          int32_t lineno, c_string filename);
 
+//
+// Counters-only statistics for the calling locale.  The byte totals
+// are in terms of the block sizes the allocator actually hands out,
+// which may be a little more than was asked for.  The per-description
+// counters are indexed like chpl_mem_descString() and only count
+// allocations, since a free doesn't say what it is freeing.
+//
+uint64_t chpl_memCountersInUse(int32_t lineno, c_string filename);
+uint64_t chpl_memCountersHighWater(int32_t lineno, c_string filename);
+uint64_t chpl_memCountersTotalAllocated(int32_t lineno, c_string filename);
+uint64_t chpl_memCountersTotalFreed(int32_t lineno, c_string filename);
+int chpl_memCountersNumDescs(int32_t lineno, c_string filename);
+c_string chpl_memCountersDescName(int desc);
+uint64_t chpl_memCountersDescAllocations(int desc);
+uint64_t chpl_memCountersDescBytes(int desc);
+
 void chpl_startVerboseMem(void);
 void chpl_stopVerboseMem(void);
 void chpl_startVerboseMemHere(void);
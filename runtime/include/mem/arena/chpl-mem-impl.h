@@ -0,0 +1,46 @@
+/*
+ * Copyright 2004-2015 Cray Inc.
+ * Other additional copyright holders may be indicated within.
+ * 
+ * The entirety of this work is licensed under the Apache License,
+ * Version 2.0 (the "License"); you may not use this file except
+ * in compliance with the License.
+ * 
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* arena memory function implementation */
+
+void* chpl_arena_calloc(size_t n, size_t size);
+void* chpl_arena_malloc(size_t size);
+void* chpl_arena_realloc(void* ptr, size_t size);
+void chpl_arena_free(void* ptr);
+size_t chpl_arena_usable_size(void* ptr);
+
+static ___always_inline void* chpl_calloc(size_t n, size_t size) {
+  return chpl_arena_calloc(n, size);
+}
+
+static ___always_inline void* chpl_malloc(size_t size) {
+  return chpl_arena_malloc(size);
+}
+
+static ___always_inline void* chpl_realloc(void* ptr, size_t size) {
+  return chpl_arena_realloc(ptr, size);
+}
+
+static ___always_inline void chpl_free(void* ptr) {
+  chpl_arena_free(ptr);
+}
+
+static ___always_inline size_t chpl_usable_size(void* ptr) {
+  return chpl_arena_usable_size(ptr);
+}
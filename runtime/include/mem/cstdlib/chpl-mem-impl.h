@@ -29,6 +29,12 @@
 #undef free
 #undef _chpl_mem_warning_macros_h_
 
+#if defined(__GLIBC__)
+#include <malloc.h>
+#elif defined(__APPLE__)
+#include <malloc/malloc.h>
+#endif
+
 static ___always_inline void* chpl_calloc(size_t n, size_t size) {
   return calloc(n,size);
 }
@@ -45,6 +51,17 @@ static ___always_inline void chpl_free(void* ptr) {
   free(ptr);
 }
 
+// Returns 0 where the C library can't tell us the size of a block.
+static ___always_inline size_t chpl_usable_size(void* ptr) {
+#if defined(__GLIBC__)
+  return malloc_usable_size(ptr);
+#elif defined(__APPLE__)
+  return (ptr == NULL) ? 0 : malloc_size(ptr);
+#else
+  return 0;
+#endif
+}
+
 // Now that we've defined our functions, turn the warnings back on.
 #include "chpl-mem-warning-macros.h"
 
@@ -23,19 +23,32 @@
 
 extern mspace chpl_dlmalloc_heap;
 
+//
+// These go through the per-thread caches in mem-dlmalloc.c before
+// falling back to the mspace.
+//
+void* chpl_dlmalloc_calloc(size_t n, size_t size);
+void* chpl_dlmalloc_malloc(size_t size);
+void* chpl_dlmalloc_realloc(void* ptr, size_t size);
+void chpl_dlmalloc_free(void* ptr);
+size_t chpl_dlmalloc_usable_size(void* ptr);
+
 static ___always_inline void* chpl_calloc(size_t n, size_t size) {
-  return mspace_calloc(chpl_dlmalloc_heap,n,size);
+  return chpl_dlmalloc_calloc(n, size);
 }
 
 static ___always_inline void* chpl_malloc(size_t size) {
-  return mspace_malloc(chpl_dlmalloc_heap, size);
+  return chpl_dlmalloc_malloc(size);
 }
 
 static ___always_inline void* chpl_realloc(void* ptr, size_t size) {
-  return mspace_realloc(chpl_dlmalloc_heap, ptr, size);
+  return chpl_dlmalloc_realloc(ptr, size);
 }
 
 static ___always_inline void chpl_free(void* ptr) {
-  mspace_free(chpl_dlmalloc_heap, ptr);
+  chpl_dlmalloc_free(ptr);
 }
 
+static ___always_inline size_t chpl_usable_size(void* ptr) {
+  return chpl_dlmalloc_usable_size(ptr);
+}
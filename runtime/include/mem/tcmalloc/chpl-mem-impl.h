@@ -37,3 +37,7 @@ static ___always_inline void chpl_free(void* ptr) {
   tc_free(ptr);
 }
 
+static ___always_inline size_t chpl_usable_size(void* ptr) {
+  return tc_malloc_size(ptr);
+}
+
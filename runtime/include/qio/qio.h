@@ -74,6 +74,10 @@ typedef uint32_t qio_hint_t;
 #define FTYPE_CURL 3
 #endif
 
+#ifndef FTYPE_GZIP
+#define FTYPE_GZIP 4
+#endif
+
 // So that we can free c_strings from Chapel
 // This is temporary for now, one Sung's 'string_free' function goes in, this
 // and the use of it in IO.chpl can go away.
@@ -202,25 +206,40 @@ typedef qio_fdflag_t fdflag_t;
 
 
 // make a re-entrant lock.
+// The lock is biased towards the task that created it: until some other
+// task locks it, that task takes it with a compare-and-swap on
+// bias_state instead of the sync variable. The first other task to lock
+// it waits for it to be free and then revokes the bias for good.
 typedef struct {
   chpl_sync_aux_t sv;
   int64_t owner; // task ID of owner.
   uint64_t count; // how many times owner has locked.
+  int64_t bias; // task ID of the creating task
+  atomic_int_least32_t bias_state; // QIO_LOCK_BIAS_*
 } qio_lock_t;
 
 #define NULL_OWNER chpl_nullTaskID
 
+#define QIO_LOCK_BIAS_FREE 0 // the bias task can lock without sv
+#define QIO_LOCK_BIAS_HELD 1 // the bias task has it, without sv
+#define QIO_LOCK_BIAS_REVOKED 2 // everyone uses sv
+
 qioerr qio_lock(qio_lock_t* x);
 void qio_unlock(qio_lock_t* x);
 
 static inline qioerr qio_lock_init(qio_lock_t* x) {
   x->owner = NULL_OWNER;
   x->count = 0;
+  x->bias = chpl_task_getId();
+  atomic_init_int_least32_t(&x->bias_state,
+                            x->bias == NULL_OWNER ? QIO_LOCK_BIAS_REVOKED :
+                                                    QIO_LOCK_BIAS_FREE);
   chpl_sync_initAux(&x->sv);
   return 0;
 }
 
 static inline void qio_lock_destroy(qio_lock_t* x) {
+  atomic_destroy_int_least32_t(&x->bias_state);
   chpl_sync_destroyAux(&x->sv);
 }
 
@@ -269,6 +288,9 @@ static inline void qio_lock_destroy(qio_lock_t* x) { int rc = pthread_mutex_dest
 extern ssize_t qio_too_small_for_default_mmap;
 extern ssize_t qio_too_large_for_default_mmap;
 extern ssize_t qio_mmap_chunk_iobufs;
+// How many iobufs a pipelined channel keeps in flight;
+// -1 means use CHPL_RT_QIO_PIPELINE_DEPTH (default 4), 0 disables.
+extern ssize_t qio_pipeline_iobufs;
 
 /* Wrap system calls readv, writev, preadv, pwritev
  * to take a buffer.
@@ -316,6 +338,8 @@ char* qio_chtype_to_string(qio_chtype_t type);
      -- noreuse -- pread/pwrite
      -- cached -- mmap for reads and writes
      -- force_readwrite
+     -- async -- only when requested; preadv/pwritev through the
+                 asynchronous engine in qio_async.h
  */
 
 #define QIO_HINT_AFTERCHTYPE 0x0010
@@ -326,13 +350,14 @@ typedef enum {
   QIO_METHOD_FREADFWRITE = 3*QIO_HINT_AFTERCHTYPE,
   QIO_METHOD_MMAP = 4*QIO_HINT_AFTERCHTYPE,
   QIO_METHOD_MEMORY = 5*QIO_HINT_AFTERCHTYPE,
+  QIO_METHOD_ASYNC = 6*QIO_HINT_AFTERCHTYPE,
   //QIO_METHOD_LIBEVENT,
 } qio_method_t;
 #define QIO_METHODMASK 0x00f0
 #define QIO_HINT_AFTERMETHOD 0x0100
 #define QIO_METHOD_DEFAULT 0
 #define QIO_MIN_METHOD QIO_METHOD_READWRITE
-#define QIO_MAX_METHOD QIO_METHOD_MEMORY
+#define QIO_MAX_METHOD QIO_METHOD_ASYNC
 
 enum {
   QIO_HINT_RANDOM       = QIO_HINT_AFTERMETHOD,
@@ -342,14 +367,16 @@ enum {
   QIO_HINT_CACHED       = QIO_HINT_BANDWIDTH<<1,
   QIO_HINT_PARALLEL     = QIO_HINT_CACHED<<1,
   QIO_HINT_DIRECT       = QIO_HINT_PARALLEL<<1,
-     // note -- if DIRECT is set, you must do aligned I/O;
-     // offset, request size must be 512-byte aligned, and
-     // user buffer must be page-aligned. This should more or
-     // less work the way you expect for a buffered channel,
-     // but you'll have to round out all files to a multiple of 512
-     // bytes. This library could help by turning off O_DIRECT when
-     // encountering improper alignment, but the linux open man page
-     // says:
+     // Buffered pread/pwrite channels with DIRECT bypass the page
+     // cache: the page-aligned middle of each buffer part goes
+     // through a second descriptor opened with O_DIRECT (F_NOCACHE
+     // on Mac OS X), and the channel's buffer parts are laid out so
+     // that their memory is aligned the same way as their file
+     // offsets. Unaligned heads and tails (e.g. at the start of a
+     // channel or at the end of the data) use the normal descriptor.
+     // If the file system can't do direct I/O, everything uses the
+     // normal descriptor. Keep the unaligned parts small since the
+     // linux open man page says:
 //Applications should avoid mixing O_DIRECT and normal I/O to the same file, and
 //especially to overlapping byte regions in the same file.  Even when the file
 //system correctly handles the coherency issues in this situation, overall I/O
@@ -427,6 +454,9 @@ char* qio_hints_to_string(qio_hint_t hint)
       case QIO_METHOD_MEMORY:
         strcat(buf, " memory"); ok = 1;
         break;
+      case QIO_METHOD_ASYNC:
+        strcat(buf, " async"); ok = 1;
+        break;
       // no default to get warned if any are added.
     }
   }
@@ -460,6 +490,9 @@ typedef struct qio_file_s {
   // An (arguably) better solution is to put 
   FILE* fp; // set if this file wraps a FILE*
   fd_t fd; // -1 if not set
+  fd_t direct_fd; // O_DIRECT descriptor for the same file, used by
+                  // QIO_HINT_DIRECT channels. Opened on first use;
+                  // -1 if not opened yet, -2 if direct I/O is unavailable.
   int use_fp; // we only default to FREADFWRITE if this and fp are set.
   qbuffer_t* buf; // NULL if not set.
                   // if set, fp==NULL, fd==-1, is memory-only file.
@@ -523,6 +556,10 @@ qioerr qio_readv(qio_file_t* file, qbuffer_t* buf, qbuffer_iter_t start, qbuffer
 qioerr qio_writev(qio_file_t* file, qbuffer_t* buf, qbuffer_iter_t start, qbuffer_iter_t end, ssize_t* num_written);
 qioerr qio_preadv(qio_file_t* file, qbuffer_t* buf, qbuffer_iter_t start, qbuffer_iter_t end, int64_t seek_to_offset, ssize_t* num_read);
 qioerr qio_pwritev(qio_file_t* file, qbuffer_t* buf, qbuffer_iter_t start, qbuffer_iter_t end, int64_t seek_to_offset, ssize_t* num_written);
+// Like qio_preadv/qio_pwritev but issue the I/O through the asynchronous
+// engine in qio_async.h, one request per qbytes_iobuf_size chunk.
+qioerr qio_async_preadv(qio_file_t* file, qbuffer_t* buf, qbuffer_iter_t start, qbuffer_iter_t end, int64_t seek_to_offset, ssize_t* num_read);
+qioerr qio_async_pwritev(qio_file_t* file, qbuffer_t* buf, qbuffer_iter_t start, qbuffer_iter_t end, int64_t seek_to_offset, ssize_t* num_written);
 
 // if fp is not null, fd is ignored; if fp is null, we use fd.
 // the QIO file takes ownership of fp or fd, closing it when the QIO file is closed.
@@ -613,6 +650,24 @@ void qio_file_get_style(qio_file_t* f, qio_style_t* style)
 // Calls fflush on a FILE* first.
 qioerr qio_file_length(qio_file_t* f, int64_t *len_out);
 
+// Read or write exactly len bytes at offset in a file descriptor file,
+// without a channel. Reading past the end of the file returns EEOF.
+qioerr qio_file_pwrite_amt(qio_file_t* f, const void* ptr, ssize_t len, int64_t offset);
+qioerr qio_file_pread_amt(qio_file_t* f, void* ptr, ssize_t len, int64_t offset);
+
+// The device and inode numbers of a file descriptor file, so that a file
+// opened again by name can be checked to be the same file.
+qioerr qio_file_identity(qio_file_t* f, int64_t* dev_out, int64_t* ino_out);
+
+// Map len bytes of a file starting at offset (which need not be
+// page-aligned) for use as array data. A shared map shows changes to
+// the file and writes them back; a private map is copy-on-write.
+// Writeable shared maps extend the file if needed. RANDOM, SEQUENTIAL
+// and CACHED hints become madvise (and MAP_POPULATE) hints.
+qioerr qio_file_map_array(qio_file_t* f, int64_t offset, int64_t len, int writeable, int shared, qio_hint_t hints, void** data_out);
+// Unmap data from qio_file_map_array, first calling msync if sync is set.
+qioerr qio_file_unmap_array(void* data, int64_t len, int sync);
+
 /* CHANNELS ..... */
 
 /* A Read and Write Buffered channels support:
@@ -787,6 +842,10 @@ typedef struct qio_channel_s {
 
   qbuffer_t buf;
 
+  // read-ahead/write-behind requests in flight on buf, if the
+  // channel is pipelined (see qio_pipeline_iobufs).
+  struct qio_pipeline_s* pipe;
+
   // For reading/writing bits (ie less than a byte) at a time
   qio_bitbuffer_t bit_buffer;
   void* cached_end_bits; // cause flush before byte I/O
@@ -1290,6 +1349,19 @@ qioerr qio_channel_end_offset(const int threadsafe, qio_channel_t* ch, int64_t*
 
 qioerr qio_channel_advance(const int threadsafe, qio_channel_t* ch, int64_t nbytes);
 
+// Flushes the channel and then moves it forward by nbytes without
+// transferring them, so that the region can be read or written by
+// other means (e.g. by several locales in parallel with
+// qio_file_pwrite_amt). Returns the absolute path of the file
+// (to be freed by the caller) and the offset where the region starts.
+// Returns ENOSYS if the channel is marked or does not use pread/pwrite,
+// mmap or async I/O on a file descriptor; then the channel is unchanged.
+qioerr qio_channel_skip_external(const int threadsafe, qio_channel_t* ch, int64_t nbytes, const char** path_out, int64_t* offset_out);
+// Checks whether qio_channel_skip_external can be used, without changing
+// the channel, and returns the path (to be freed by the caller) and the
+// identity (see qio_file_identity) of the channel's file.
+qioerr qio_channel_external_file(const int threadsafe, qio_channel_t* ch, const char** path_out, int64_t* dev_out, int64_t* ino_out);
+
 qioerr qio_channel_put_bytes(const int threadsafe, qio_channel_t* ch, qbytes_t* bytes, int64_t skip_bytes, int64_t len_bytes);
 
 qioerr qio_channel_put_buffer(const int threadsafe, qio_channel_t* ch, qbuffer_t* src, qbuffer_iter_t src_start, qbuffer_iter_t src_end);
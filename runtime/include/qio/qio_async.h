@@ -0,0 +1,95 @@
+/*
+ * Copyright 2004-2015 Cray Inc.
+ * Other additional copyright holders may be indicated within.
+ * 
+ * The entirety of this work is licensed under the Apache License,
+ * Version 2.0 (the "License"); you may not use this file except
+ * in compliance with the License.
+ * 
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _QIO_ASYNC_H_
+#define _QIO_ASYNC_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "sys_basic.h"
+#include "sys.h"
+#include "chpl-atomics.h"
+
+#include <sys/uio.h>
+
+/*
+ * Asynchronous positional I/O for QIO_METHOD_ASYNC.
+ *
+ * Requests are submitted to an engine that performs the preadv/pwritev
+ * without occupying the submitting thread.  On Linux with io_uring
+ * available the engine is an io_uring instance driven through raw
+ * system calls; otherwise (or when io_uring setup fails) it is a small
+ * pool of pthreads that run sys_preadv/sys_pwritev on behalf of tasks.
+ *
+ * A task waiting for a request calls chpl_task_yield() between checks,
+ * so other tasks can run on its worker thread while the I/O is in flight.
+ *
+ * The environment variable CHPL_RT_QIO_ASYNC selects the engine
+ * ("uring" or "threads"); CHPL_RT_QIO_ASYNC_THREADS sets the number of
+ * threads in the thread pool (default 4).
+ */
+
+typedef enum {
+  QIO_AIO_READ = 1,
+  QIO_AIO_WRITE = 2,
+} qio_aio_op_t;
+
+typedef struct qio_aio_req_s {
+  // filled in by the submitter
+  qio_aio_op_t op;
+  fd_t fd;
+  const struct iovec* iov; // must stay valid until the request is done
+  int iovcnt;
+  off_t offset;
+  // filled in by the engine
+  ssize_t result; // number of bytes transferred
+  err_t err;      // 0, an errno value, or EEOF for a read at end of file
+  atomic_int_least32_t done;
+  struct qio_aio_req_s* next; // engine-private
+} qio_aio_req_t;
+
+void qio_aio_req_init(qio_aio_req_t* req, qio_aio_op_t op, fd_t fd,
+                      const struct iovec* iov, int iovcnt, off_t offset);
+
+// Start the request.  Returns 0 if the request was queued; otherwise
+// the request was not started and the error is returned.
+err_t qio_aio_submit(qio_aio_req_t* req);
+
+// Nonzero if the request has completed.
+int qio_aio_test(qio_aio_req_t* req);
+
+// Wait (yielding) for the request to complete and return its error,
+// storing the number of bytes transferred in *num_out.
+err_t qio_aio_wait(qio_aio_req_t* req, ssize_t* num_out);
+
+// Submit-and-wait versions with the same interface as sys_preadv/pwritev.
+err_t qio_aio_preadv(fd_t fd, const struct iovec* iov, int iovcnt, off_t seek_to_offset, ssize_t* num_read_out);
+err_t qio_aio_pwritev(fd_t fd, const struct iovec* iov, int iovcnt, off_t seek_to_offset, ssize_t* num_written_out);
+
+// Returns "uring" or "threads" depending on the engine in use,
+// initializing the engine if necessary.
+const char* qio_aio_engine_name(void);
+
+#ifdef __cplusplus
+} // end extern "C"
+#endif
+
+#endif
@@ -746,6 +746,28 @@ qioerr qio_channel_scan_literal(const int threadsafe, qio_channel_t* restrict ch
 // Chapel needs another name for the same routine.
 qioerr qio_channel_scan_literal_2(const int threadsafe, qio_channel_t* ch, /* const char* */ void* match, ssize_t len, int skipws);
 
+// Field types for qio_channel_scan_fields
+#define QIO_FIELD_SKIP 0
+#define QIO_FIELD_INT 1
+#define QIO_FIELD_UINT 2
+#define QIO_FIELD_REAL 3
+#define QIO_FIELD_STRING 4
+
+// Reads one record of nfields fields separated by any of the characters
+// in delims and ended by a newline (or EOF). types[i] says how to read
+// field i: integers go in nums[i] (unsigned ones as the same bits),
+// reals in reals[i], and strings in strs[i] as a newly allocated
+// string. If bits is not NULL, bits[i] is the width of integer field i,
+// and a value that does not fit in it is ERANGE, as is one that does
+// not fit in 64 bits. Empty numeric fields leave nums[i] or reals[i]
+// alone. A field
+// may be in double quotes, with "" for a quote inside it; spaces
+// and tabs around fields are ignored unless they are delimiters, in
+// which case a run of them separates two fields. Blank lines are
+// skipped. Returns EEOF if there are no more records, and EFORMAT if a
+// record has the wrong number of fields; on error nothing is consumed.
+qioerr qio_channel_scan_fields(const int threadsafe, qio_channel_t* restrict ch, const char* restrict delims, ssize_t nfields, const int8_t* restrict types, const int8_t* restrict bits, int64_t* restrict nums, double* restrict reals, const char** restrict strs);
+
 typedef struct qio_truncate_info_ {
   ssize_t max_columns;
   ssize_t max_chars;
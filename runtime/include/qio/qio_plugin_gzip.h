@@ -0,0 +1,65 @@
+/*
+ * Copyright 2004-2015 Cray Inc.
+ * Other additional copyright holders may be indicated within.
+ * 
+ * The entirety of this work is licensed under the Apache License,
+ * Version 2.0 (the "License"); you may not use this file except
+ * in compliance with the License.
+ * 
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// This defines the compressed file implementation of the QIO filesystem
+// plugin interface. Documentation can be found in
+// $CHPL_HOME/doc/release/technotes/README.gzip
+#ifndef QIOPLUGIN_GZIP_H_
+#define QIOPLUGIN_GZIP_H_
+
+#include "sys_basic.h"
+#include "qio.h"
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Files are written as a series of independently compressed gzip members
+// ("blocks") each holding at most this many bytes of data. Every member
+// records its compressed size in a 'BC' extra field (as in the BGZF format
+// used by samtools), which is what lets a reader find block boundaries
+// without decompressing anything.
+#define QIO_GZIP_BLOCK_SIZE 0xff00
+
+// The "fd" for a compressed file
+typedef struct gzip_file gzip_file;
+
+// The compressed file itself is a local file when gzip_function_struct
+// is opened with a NULL fs. Passing one of these as the fs instead reads
+// and writes it through another plugin (e.g. curl or HDFS), so gzip can
+// be layered on any of them. It is only needed until the open returns:
+// the gzip file copies what it holds, and gzip_file_open_access_usr
+// leaves the file's fs_info NULL rather than pointing at its own copy.
+typedef struct qio_gzip_fs_s {
+  const qio_file_functions_t* inner; // the plugin holding the file
+  void* inner_fs;                    // and its fs argument
+} qio_gzip_fs_t;
+
+extern qio_file_functions_t gzip_function_struct;
+extern const qio_file_functions_ptr_t gzip_function_struct_ptr;
+
+// Like qio_file_open_access_usr, but the file at path (opened with s and
+// fs) is compressed, and the returned file reads and writes its
+// uncompressed data.
+qioerr gzip_file_open_access_usr(qio_file_t** file_out, const char* path, const char* access, qio_hint_t iohints, const qio_style_t* style, void* fs, const qio_file_functions_t* s);
+
+#ifdef __cplusplus
+} // end extern "C"
+#endif
+
+#endif
@@ -162,6 +162,7 @@ int64_t sys_iov_total_bytes(const struct iovec* iov, int iovcnt);
 err_t sys_mmap(void* addr, size_t length, int prot, int flags, fd_t fd, off_t offset, void** ret);
 
 err_t sys_munmap(void* addr, size_t length);
+err_t sys_msync(void* addr, size_t length, int flags);
 
 err_t sys_read(fd_t fd, void* buf, size_t count, ssize_t* num_read_out);
 err_t sys_write(fd_t fd, const void* buf, size_t count, ssize_t* num_written_out);
@@ -56,11 +56,30 @@ typedef pthread_cond_t chpl_thread_condvar_t;
 //
 // Sync variables
 //
+// On Linux, tasks that have to block on a sync variable park on a
+// futex instead of a condition variable.  Each futex word is a wakeup
+// sequence number, sampled under the lock before parking and bumped
+// under the lock when signaling, so a wakeup can never be lost.  The
+// waiter counts let signalers skip the system call when nobody is
+// parked.
+//
+#ifdef __linux__
+#define CHPL_SYNC_USE_FUTEX 1
+#endif
+
 typedef struct {
   volatile chpl_bool  is_full;
   chpl_thread_mutex_t lock;
+#ifdef CHPL_SYNC_USE_FUTEX
+  volatile int32_t    signal_full;    // wait for full; bump this when full
+  volatile int32_t    signal_empty;   // wait for empty; bump this when empty
+  int32_t             full_waiters;   // number parked on signal_full
+  int32_t             empty_waiters;  // number parked on signal_empty
+#else
   chpl_thread_condvar_t signal_full;  // wait for full; signal this when full
   chpl_thread_condvar_t signal_empty; // wait for empty; signal this when empty
+#endif
+  int32_t             spin_limit;     // adaptive spin bound before blocking
   //  threadlayer_sync_aux_t tl_aux;
 } chpl_sync_aux_t;
 
@@ -0,0 +1,53 @@
+/*
+ * Copyright 2004-2015 Cray Inc.
+ * Other additional copyright holders may be indicated within.
+ * 
+ * The entirety of this work is licensed under the Apache License,
+ * Version 2.0 (the "License"); you may not use this file except
+ * in compliance with the License.
+ * 
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "chplrt.h"
+
+#include "chpl-env.h"
+#include "error.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <strings.h>
+
+
+chpl_bool chpl_env_rt_get_bool(const char* name, chpl_bool dflt) {
+  static const char* trueVals[] = { "1", "y", "yes", "t", "true", "on" };
+  static const char* falseVals[] = { "0", "n", "no", "f", "false", "off" };
+  const char* p = getenv(name);
+  char msg[256];
+  int i;
+
+  if (p == NULL || p[0] == '\0')
+    return dflt;
+
+  for (i = 0; i < sizeof(trueVals) / sizeof(trueVals[0]); i++) {
+    if (strcasecmp(p, trueVals[i]) == 0)
+      return true;
+  }
+  for (i = 0; i < sizeof(falseVals) / sizeof(falseVals[0]); i++) {
+    if (strcasecmp(p, falseVals[i]) == 0)
+      return false;
+  }
+
+  snprintf(msg, sizeof(msg),
+           "%s=\"%s\" is not a boolean value; ignoring it", name, p);
+  chpl_warning(msg, 0, 0);
+  return dflt;
+}
@@ -22,21 +22,82 @@
 //
 #include "chplrt.h"
 
+#include "chplcgfns.h"
+#include "chpl-comm.h"
 #include "chpl-mem.h"
+#include "chpl-mem-hook.h"
+#include "chpl-tasks.h"
+#include "chplsys.h"
 #include "chpltypes.h"
 #include "error.h"
 
+#include <hwloc.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+//
+// With CHPL_HWLOC=none we get a stub hwloc.h that does not define the
+// API version, so we use that to tell whether we can bind memory.
+//
+#ifdef HWLOC_API_VERSION
+#define CHPL_MEM_HWLOC_BIND 1
+#endif
+
 
 static int heapInitialized = 0;
 
+//
+// Set if sublocale memory placement is wanted, which is only the case
+// when the program was compiled for the NUMA locale model.
+//
+static int localizeSublocs = 0;
+
+#ifdef CHPL_MEM_HWLOC_BIND
+static hwloc_topology_t topology;
+static int numNumaDomains = 0;
+#endif
+
+
+static void localize_init(void) {
+  localizeSublocs = (strcmp(CHPL_LOCALE_MODEL, "numa") == 0);
+
+#ifdef CHPL_MEM_HWLOC_BIND
+  if (localizeSublocs) {
+    if (hwloc_topology_init(&topology) != 0
+        || hwloc_topology_load(topology) != 0) {
+      chpl_warning("cannot load hwloc topology; sublocale memory "
+                   "will be placed by first touch", 0, 0);
+      return;
+    }
+
+    numNumaDomains = hwloc_get_nbobjs_by_type(topology, HWLOC_OBJ_NODE);
+  }
+#endif
+}
+
+
+static void localize_exit(void) {
+#ifdef CHPL_MEM_HWLOC_BIND
+  if (numNumaDomains > 0) {
+    hwloc_topology_destroy(topology);
+    numNumaDomains = 0;
+  }
+#endif
+}
+
 
 void chpl_mem_init(void) {
   chpl_mem_layerInit();
+  chpl_initMemCounters();
+  localize_init();
   heapInitialized = 1;
 }
 
 
 void chpl_mem_exit(void) {
+  localize_exit();
   chpl_mem_layerExit();
 }
 
@@ -44,3 +105,422 @@ void chpl_mem_exit(void) {
 int chpl_mem_inited(void) {
   return heapInitialized;
 }
+
+
+void chpl_mem_localizeSubloc(void* p, size_t size, c_sublocid_t subloc) {
+  size_t pageSize;
+  uintptr_t lo, hi;
+
+  if (!localizeSublocs || p == NULL || subloc < 0)
+    return;
+
+  //
+  // Only touch the pages that belong entirely to this allocation.
+  //
+  pageSize = chpl_getSysPageSize();
+  lo = ((uintptr_t) p + pageSize - 1) & ~(uintptr_t) (pageSize - 1);
+  hi = ((uintptr_t) p + size) & ~(uintptr_t) (pageSize - 1);
+  if (hi <= lo)
+    return;
+
+#ifdef CHPL_MEM_HWLOC_BIND
+  //
+  // Sublocales are NUMA domains, numbered in topology order.  Bind the
+  // pages there, migrating any that have already been faulted in.
+  //
+  if (numNumaDomains > 0) {
+    hwloc_obj_t numaObj;
+
+    numaObj = hwloc_get_obj_by_type(topology, HWLOC_OBJ_NODE,
+                                    subloc % numNumaDomains);
+    if (numaObj != NULL
+        && hwloc_set_area_membind_nodeset(topology,
+                                          (void*) lo, hi - lo,
+                                          numaObj->nodeset,
+                                          HWLOC_MEMBIND_BIND,
+                                          HWLOC_MEMBIND_MIGRATE) == 0)
+      return;
+  }
+#endif
+
+  //
+  // No binding support.  Fall back to first touch: the caller is running
+  // on the requested sublocale, so faulting the pages in from here puts
+  // them in that NUMA domain's memory (for pages not yet touched).  The
+  // region was just allocated, so rewriting a byte in place is harmless.
+  //
+  {
+    uintptr_t a;
+    for (a = lo; a < hi; a += pageSize)
+      *(volatile char*) a = *(volatile char*) a;
+  }
+}
+
+
+//
+// Huge-page array storage.  Each huge-page array is its own mapping,
+// so freeing one has to recognize it and unmap it.  We keep the
+// mappings in a small hash table, which array frees only consult while
+// there are any.
+//
+chpl_mem_pageMode_t chpl_mem_arrayPageMode = CHPL_MEM_PAGES_NORMAL;
+size_t chpl_mem_numHugeArrays = 0;
+
+#define HUGE_PAGE_SIZE_THP ((size_t) 2 << 20)
+#define NUM_HUGE_BUCKETS   64
+
+typedef struct hugeArray_s {
+  void* p;
+  size_t len;
+  chpl_mem_pageMode_t kind;
+  struct hugeArray_s* next;
+} hugeArray_t;
+
+static hugeArray_t* hugeArrays[NUM_HUGE_BUCKETS];
+static chpl_sync_aux_t hugeArrays_lock;
+static size_t hugetlbPageSize;
+static chpl_mem_hugePageStats_t hugeStats;
+
+
+static inline hugeArray_t** hugeBucket(void* p) {
+  return &hugeArrays[((uintptr_t) p / HUGE_PAGE_SIZE_THP) % NUM_HUGE_BUCKETS];
+}
+
+
+//
+// The hugetlbfs page size is whatever the kernel reports as the
+// default; MAP_HUGETLB uses that size.
+//
+static size_t getHugetlbPageSize(void) {
+  size_t size = HUGE_PAGE_SIZE_THP;
+  FILE* f;
+  char line[128];
+  unsigned long kb;
+
+  if ((f = fopen("/proc/meminfo", "r")) == NULL)
+    return size;
+  while (fgets(line, sizeof(line), f) != NULL) {
+    if (sscanf(line, "Hugepagesize: %lu kB", &kb) == 1) {
+      size = (size_t) kb << 10;
+      break;
+    }
+  }
+  fclose(f);
+  return size;
+}
+
+
+void chpl_mem_setArrayPageMode(c_string configMode) {
+  const char* mode = configMode;
+  void* heap_base;
+  size_t heap_size;
+
+  chpl_sync_initAux(&hugeArrays_lock);
+
+  if (mode == NULL || mode[0] == '\0')
+    mode = getenv("CHPL_RT_HUGE_PAGES");
+  if (mode == NULL || mode[0] == '\0' || strcmp(mode, "none") == 0)
+    return;
+
+  //
+  // Memory the comm layer has to register lives in its shared heap,
+  // where the mem layer puts everything, arrays included.  Mapping
+  // arrays elsewhere would make them unreachable by RDMA.
+  //
+  chpl_comm_desired_shared_heap(&heap_base, &heap_size);
+  if (heap_base != NULL || heap_size != 0) {
+    chpl_warning("huge-page arrays are not supported with a registered "
+                 "shared heap; using normal pages", 0, 0);
+    return;
+  }
+
+  if (strcmp(mode, "thp") == 0) {
+#ifdef MADV_HUGEPAGE
+    chpl_mem_arrayPageMode = CHPL_MEM_PAGES_THP;
+#else
+    chpl_warning("transparent huge pages are not supported here; "
+                 "using normal pages", 0, 0);
+#endif
+  } else if (strcmp(mode, "hugetlb") == 0) {
+#ifdef MAP_HUGETLB
+    chpl_mem_arrayPageMode = CHPL_MEM_PAGES_HUGETLB;
+    hugetlbPageSize = getHugetlbPageSize();
+#elif defined(MADV_HUGEPAGE)
+    chpl_warning("hugetlbfs pages are not supported here; "
+                 "using transparent huge pages", 0, 0);
+    chpl_mem_arrayPageMode = CHPL_MEM_PAGES_THP;
+#else
+    chpl_warning("huge pages are not supported here; "
+                 "using normal pages", 0, 0);
+#endif
+  } else {
+    chpl_warning("unknown huge page mode; use none, thp or hugetlb", 0, 0);
+  }
+
+  hugeStats.mode = chpl_mem_arrayPageMode;
+}
+
+
+c_string chpl_mem_arrayPageModeName(void) {
+  switch (chpl_mem_arrayPageMode) {
+  case CHPL_MEM_PAGES_THP:     return "thp";
+  case CHPL_MEM_PAGES_HUGETLB: return "hugetlb";
+  default:                     return "none";
+  }
+}
+
+
+void chpl_mem_getHugePageStats(chpl_mem_hugePageStats_t* stats) {
+  chpl_sync_lock(&hugeArrays_lock);
+  *stats = hugeStats;
+  chpl_sync_unlock(&hugeArrays_lock);
+}
+
+
+#ifdef MADV_HUGEPAGE
+//
+// Map len bytes aligned to the transparent huge page size, by mapping
+// an extra huge page's worth and trimming, and ask for huge pages.
+//
+static void* allocThp(size_t len) {
+  char* p;
+  size_t lead;
+
+  p = mmap(NULL, len + HUGE_PAGE_SIZE_THP, PROT_READ | PROT_WRITE,
+           MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (p == MAP_FAILED)
+    return NULL;
+  lead = (HUGE_PAGE_SIZE_THP - ((uintptr_t) p & (HUGE_PAGE_SIZE_THP - 1)))
+         & (HUGE_PAGE_SIZE_THP - 1);
+  if (lead > 0)
+    munmap(p, lead);
+  munmap(p + lead + len, HUGE_PAGE_SIZE_THP - lead);
+  p += lead;
+  (void) madvise(p, len, MADV_HUGEPAGE);
+  return p;
+}
+#endif
+
+
+void* chpl_mem_hugeArrayAlloc(size_t number, size_t size,
+                              int32_t lineno, c_string filename) {
+  size_t bytes = number * size;
+  size_t len = 0;
+  void* p = NULL;
+  chpl_mem_pageMode_t kind = chpl_mem_arrayPageMode;
+  hugeArray_t* ha;
+
+  if (size != 0 && bytes / size != number)
+    return NULL;
+  if ((ha = (hugeArray_t*) chpl_malloc(sizeof(*ha))) == NULL)
+    return NULL;
+
+  chpl_memhook_malloc_pre(number, size, CHPL_RT_MD_ARRAY_ELEMENTS,
+                          lineno, filename);
+
+#ifdef MAP_HUGETLB
+  if (kind == CHPL_MEM_PAGES_HUGETLB) {
+    len = (bytes + hugetlbPageSize - 1) & ~(hugetlbPageSize - 1);
+    p = mmap(NULL, len, PROT_READ | PROT_WRITE,
+             MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (p == MAP_FAILED) {
+      p = NULL;
+      kind = CHPL_MEM_PAGES_THP;
+    }
+  }
+#endif
+#ifdef MADV_HUGEPAGE
+  if (kind == CHPL_MEM_PAGES_THP) {
+    len = (bytes + HUGE_PAGE_SIZE_THP - 1) & ~(HUGE_PAGE_SIZE_THP - 1);
+    p = allocThp(len);
+  }
+#endif
+
+  if (p == NULL) {
+    chpl_free(ha);
+    return NULL;
+  }
+
+  ha->p = p;
+  ha->len = len;
+  ha->kind = kind;
+  chpl_sync_lock(&hugeArrays_lock);
+  ha->next = *hugeBucket(p);
+  *hugeBucket(p) = ha;
+  chpl_mem_numHugeArrays++;
+  if (kind == CHPL_MEM_PAGES_HUGETLB) {
+    hugeStats.numHugetlb++;
+  } else {
+    hugeStats.numThp++;
+    if (chpl_mem_arrayPageMode == CHPL_MEM_PAGES_HUGETLB)
+      hugeStats.numFallback++;
+  }
+  hugeStats.curBytes += len;
+  chpl_sync_unlock(&hugeArrays_lock);
+
+  // Not chpl_memhook_malloc_post(): p isn't a block from chpl_malloc(),
+  // so its size for the memory counters has to be given explicitly.
+  chpl_memhook_check_post(p, CHPL_RT_MD_ARRAY_ELEMENTS, lineno, filename);
+  if (CHPL_MEMHOOKS_ACTIVE)
+    chpl_track_malloc_sized(p, number, size, len, CHPL_RT_MD_ARRAY_ELEMENTS,
+                            lineno, filename);
+  return p;
+}
+
+
+chpl_bool chpl_mem_hugeArrayFree(void* p, int32_t lineno, c_string filename) {
+  hugeArray_t** pha;
+  hugeArray_t* ha;
+
+  if (p == NULL)
+    return false;
+
+  chpl_sync_lock(&hugeArrays_lock);
+  for (pha = hugeBucket(p); *pha != NULL && (*pha)->p != p;
+       pha = &(*pha)->next)
+    ;
+  if ((ha = *pha) != NULL) {
+    *pha = ha->next;
+    chpl_mem_numHugeArrays--;
+    hugeStats.curBytes -= ha->len;
+  }
+  chpl_sync_unlock(&hugeArrays_lock);
+
+  if (ha == NULL)
+    return false;
+
+  if (CHPL_MEMHOOKS_ACTIVE) {
+    chpl_memhook_check_pre(0, 0, 0, lineno, filename);
+    chpl_track_free_sized(p, ha->len, lineno, filename);
+  }
+  munmap(p, ha->len);
+  chpl_free(ha);
+  return true;
+}
+
+
+//
+// Task regions.  A region is a stack of blocks.  Each allocation is an
+// entry in the top block, headed by its size and the offset of the
+// entry before it, so that freed entries can be popped off the top.
+// The low bit of an entry's size says whether it has been freed.  A
+// block that empties is kept as a spare, so that a task allocating
+// and freeing across a block boundary doesn't churn.
+//
+#define REGION_BLOCK_SIZE ((size_t) 16 << 10)
+#define REGION_ALIGN      ((size_t) 16)
+#define REGION_FREED      ((size_t) 1)
+#define REGION_NO_ENTRY   SIZE_MAX
+
+typedef struct regionBlock_s {
+  struct regionBlock_s* prev;   // next older block
+  size_t size;                  // bytes for entries
+  size_t used;                  // bytes of entries in use
+  size_t last;                  // offset of the top entry
+} regionBlock_t;
+
+typedef struct {
+  size_t size;                  // bytes, header included, | REGION_FREED
+  size_t prev;                  // offset of the entry below, if any
+} regionEntry_t;
+
+struct chpl_mem_taskRegion_s {
+  regionBlock_t* top;
+  regionBlock_t* spare;
+};
+
+#define BLOCK_ENTRIES(b) ((char*) (b) + sizeof(regionBlock_t))
+#define BLOCK_ENTRY(b, off) ((regionEntry_t*) (BLOCK_ENTRIES(b) + (off)))
+
+
+static regionBlock_t* regionNewBlock(struct chpl_mem_taskRegion_s* r,
+                                     size_t need,
+                                     int32_t lineno, c_string filename) {
+  regionBlock_t* b;
+  size_t size = (need > REGION_BLOCK_SIZE) ? need : REGION_BLOCK_SIZE;
+
+  if (r->spare != NULL && r->spare->size >= need) {
+    b = r->spare;
+    r->spare = NULL;
+  } else {
+    b = (regionBlock_t*) chpl_mem_alloc(sizeof(regionBlock_t) + size,
+                                        CHPL_RT_MD_TASK_REGION,
+                                        lineno, filename);
+    b->size = size;
+  }
+  b->used = 0;
+  b->last = REGION_NO_ENTRY;
+  b->prev = r->top;
+  r->top = b;
+  return b;
+}
+
+
+void* chpl_mem_taskRegionAlloc(size_t size, int32_t lineno,
+                               c_string filename) {
+  chpl_task_localData_t* ld = &chpl_task_getPrvData()->local_data;
+  struct chpl_mem_taskRegion_s* r = ld->region;
+  regionBlock_t* b;
+  regionEntry_t* e;
+  size_t need;
+
+  if (r == NULL) {
+    r = (struct chpl_mem_taskRegion_s*)
+          chpl_mem_calloc(sizeof(*r), CHPL_RT_MD_TASK_REGION,
+                          lineno, filename);
+    ld->region = r;
+  }
+
+  need = sizeof(regionEntry_t)
+         + ((size + REGION_ALIGN - 1) & ~(REGION_ALIGN - 1));
+  if ((b = r->top) == NULL || b->size - b->used < need)
+    b = regionNewBlock(r, need, lineno, filename);
+
+  e = BLOCK_ENTRY(b, b->used);
+  e->size = need;
+  e->prev = b->last;
+  b->last = b->used;
+  b->used += need;
+  return e + 1;
+}
+
+
+void chpl_mem_taskRegionFree(void* p, int32_t lineno, c_string filename) {
+  struct chpl_mem_taskRegion_s* r =
+    chpl_task_getPrvData()->local_data.region;
+  regionBlock_t* b;
+
+  if (p == NULL)
+    return;
+
+  ((regionEntry_t*) p - 1)->size |= REGION_FREED;
+
+  //
+  // Pop freed entries off the top, retiring blocks as they empty.
+  //
+  while ((b = r->top) != NULL) {
+    while (b->used > 0 && (BLOCK_ENTRY(b, b->last)->size & REGION_FREED)) {
+      b->used = b->last;
+      b->last = BLOCK_ENTRY(b, b->last)->prev;
+    }
+    if (b->used > 0)
+      break;
+    r->top = b->prev;
+    if (r->spare != NULL)
+      chpl_mem_free(r->spare, lineno, filename);
+    r->spare = b;
+  }
+}
+
+
+void chpl_mem_taskRegionRelease(struct chpl_mem_taskRegion_s* r) {
+  regionBlock_t* b;
+
+  while ((b = r->top) != NULL) {
+    r->top = b->prev;
+    chpl_mem_free(b, 0, 0);
+  }
+  if (r->spare != NULL)
+    chpl_mem_free(r->spare, 0, 0);
+  chpl_mem_free(r, 0, 0);
+}
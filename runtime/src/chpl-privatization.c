@@ -21,47 +21,108 @@
 #include "chpl-privatization.h"
 #include "chpl-mem.h"
 #include "chpl-tasks.h"
+#include "error.h"
 
-static int64_t chpl_capPrivateObjects = 0;
-static chpl_sync_aux_t privatizationSync;
+//
+// The privatized object table is two-level: a fixed top-level array
+// of pointers to fixed-size segments.  Segments are created on demand
+// and never move or go away, so chpl_getPrivatizedClass() can index
+// the table without taking a lock, and growing the table no longer
+// requires copying (and leaking) the old one.  A segment is installed
+// with a compare-and-swap; the loser of a race frees its copy.
+//
+#define PRIV_SEG_BITS 10
+#define PRIV_SEG_SIZE ((int64_t) 1 << PRIV_SEG_BITS)
+#define PRIV_SEG_MASK (PRIV_SEG_SIZE - 1)
+#define PRIV_MAX_SEGS ((int64_t) 1 << 16)
+
+static void** chpl_privateObjects[PRIV_MAX_SEGS];
 
-void** chpl_privateObjects;
+//
+// Pids are handed out by chpl_newPrivatizedPid() on the locale that
+// creates privatized objects (locale 0).  Freed pids are kept on a
+// stack and reused before new ones are minted, so a program that
+// repeatedly creates and destroys distributed objects keeps the table
+// small.  The stack is only consulted under the lock when it is known
+// to be non-empty.
+//
+static int64_t nextPid = 0;
+static int64_t numFreePids = 0;
+static int64_t capFreePids = 0;
+static int64_t* freePids = NULL;
+static chpl_sync_aux_t privatizationSync;
 
 void chpl_privatization_init(void) {
-    chpl_sync_initAux(&privatizationSync);
+  chpl_sync_initAux(&privatizationSync);
 }
 
-void chpl_newPrivatizedClass(void* v, int64_t pid) {
-  // We need to lock around this operation so two calls in rapid succession
-  // that pass the chpl_capPrivateObjects limit don't both try to create a new
-  // array. If they do, one of the calls will be leaked and an invalid pointer
-  // to be placed in the table.
-  chpl_sync_lock(&privatizationSync);
+static void** getSegment(int64_t seg) {
+  void** segment = __atomic_load_n(&chpl_privateObjects[seg], __ATOMIC_ACQUIRE);
+
+  if (segment == NULL) {
+    void** expected = NULL;
 
-  pid += 1;
-  if (pid == 1) {
-    chpl_capPrivateObjects = 8;
     // "private" means "node-private", so we can use the system allocator.
-    chpl_privateObjects = chpl_mem_allocMany(chpl_capPrivateObjects, sizeof(void*), CHPL_RT_MD_COMM_PRIVATE_OBJECTS_ARRAY, 0, "");
-  } else {
-    if (pid > chpl_capPrivateObjects) {
-      void** tmp;
-      chpl_capPrivateObjects *= 2;
-      tmp = chpl_mem_allocMany(chpl_capPrivateObjects, sizeof(void*), CHPL_RT_MD_COMM_PRIVATE_OBJECTS_ARRAY, 0, "");
-      chpl_memcpy((void*)tmp, (void*)chpl_privateObjects, (pid-1)*sizeof(void*));
-      chpl_privateObjects = tmp;
-      // purposely leak old copies of chpl_privateObject to avoid the need to
-      // lock chpl_getPrivatizedClass; TODO: fix with lock free data structure
+    segment = chpl_mem_allocManyZero(PRIV_SEG_SIZE, sizeof(void*),
+                                     CHPL_RT_MD_COMM_PRIVATE_OBJECTS_ARRAY,
+                                     0, "");
+    if (!__atomic_compare_exchange_n(&chpl_privateObjects[seg], &expected,
+                                     segment, false, __ATOMIC_ACQ_REL,
+                                     __ATOMIC_ACQUIRE)) {
+      chpl_mem_free(segment, 0, "");
+      segment = expected;
     }
   }
-  chpl_privateObjects[pid-1] = v;
 
+  return segment;
+}
+
+int64_t chpl_newPrivatizedPid(void) {
+  int64_t pid = -1;
+
+  if (__atomic_load_n(&numFreePids, __ATOMIC_ACQUIRE) > 0) {
+    chpl_sync_lock(&privatizationSync);
+    if (numFreePids > 0)
+      pid = freePids[--numFreePids];
+    chpl_sync_unlock(&privatizationSync);
+  }
+
+  if (pid < 0)
+    pid = __atomic_fetch_add(&nextPid, 1, __ATOMIC_RELAXED);
+
+  if (pid >= PRIV_MAX_SEGS * PRIV_SEG_SIZE)
+    chpl_internal_error("too many privatized objects");
+
+  return pid;
+}
+
+void chpl_freePrivatizedPid(int64_t pid) {
+  chpl_sync_lock(&privatizationSync);
+  if (numFreePids == capFreePids) {
+    capFreePids = (capFreePids == 0) ? 64 : 2 * capFreePids;
+    freePids = chpl_mem_realloc(freePids, capFreePids * sizeof(int64_t),
+                                CHPL_RT_MD_COMM_PRIVATE_OBJECTS_ARRAY, 0, "");
+  }
+  freePids[numFreePids] = pid;
+  __atomic_store_n(&numFreePids, numFreePids + 1, __ATOMIC_RELEASE);
   chpl_sync_unlock(&privatizationSync);
 }
 
+int64_t chpl_numPrivatizedPids(void) {
+  return __atomic_load_n(&nextPid, __ATOMIC_ACQUIRE);
+}
 
-extern void* chpl_getPrivatizedClass(int64_t i) {
-  return chpl_privateObjects[i];
+void chpl_newPrivatizedClass(void* v, int64_t pid) {
+  void** segment = getSegment(pid >> PRIV_SEG_BITS);
+  __atomic_store_n(&segment[pid & PRIV_SEG_MASK], v, __ATOMIC_RELEASE);
 }
 
+void chpl_clearPrivatizedClass(int64_t pid) {
+  void** segment = chpl_privateObjects[pid >> PRIV_SEG_BITS];
+  if (segment != NULL)
+    __atomic_store_n(&segment[pid & PRIV_SEG_MASK], NULL, __ATOMIC_RELEASE);
+}
 
+void* chpl_getPrivatizedClass(int64_t i) {
+  return chpl_privateObjects[i >> PRIV_SEG_BITS][i & PRIV_SEG_MASK];
+}
@@ -23,6 +23,7 @@
 //
 #include "chplrt.h"
 #include "chpl-comm.h"
+#include "chpl-mem.h"
 #include "chplsys.h"
 #include "chpl-tasks.h"
 #include "error.h"
@@ -207,3 +208,51 @@ size_t chpl_task_getDefaultCallStackSize(void)
 
   return deflt;
 }
+
+
+void* chpl_task_getLocalSlow(chpl_task_localData_t* ld,
+                             chpl_task_localKey_t key, size_t size)
+{
+  if (key < 0)
+    chpl_internal_error("invalid task-local storage key");
+
+  if (key >= ld->num_slots) {
+    int32_t num = (ld->num_slots == 0) ? 8 : 2 * ld->num_slots;
+    while (num <= key)
+      num *= 2;
+    ld->slots = (void**) chpl_mem_realloc(ld->slots, num * sizeof(void*),
+                                          CHPL_RT_MD_TASK_LOCAL_STORAGE,
+                                          0, 0);
+    memset(&ld->slots[ld->num_slots], 0,
+           (num - ld->num_slots) * sizeof(void*));
+    ld->num_slots = num;
+  }
+
+  if (ld->slots[key] == NULL)
+    ld->slots[key] = chpl_mem_calloc((size == 0) ? 1 : size,
+                                     CHPL_RT_MD_TASK_LOCAL_STORAGE, 0, 0);
+
+  return ld->slots[key];
+}
+
+
+void chpl_task_freeLocals(chpl_task_localData_t* ld)
+{
+  int32_t i;
+
+  if (ld->region != NULL) {
+    chpl_mem_taskRegionRelease(ld->region);
+    ld->region = NULL;
+  }
+
+  if (ld->slots == NULL)
+    return;
+
+  for (i = 0; i < ld->num_slots; i++) {
+    if (ld->slots[i] != NULL)
+      chpl_mem_free(ld->slots[i], 0, 0);
+  }
+  chpl_mem_free(ld->slots, 0, 0);
+  ld->slots = NULL;
+  ld->num_slots = 0;
+}
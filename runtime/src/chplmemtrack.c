@@ -25,11 +25,13 @@
 #include "chpl-tasks.h"
 #include "chpltypes.h"
 #include "chpl-comm.h"
+#include "chpl-env.h"
 #include "chplcgfns.h"
 #include "config.h"
 #include "error.h"
 
 #include "chpl-comm-compiler-macros.h"
+#include "chpl-thread-local-storage.h"
 
 #include <assert.h>
 #include <string.h>
@@ -48,10 +50,14 @@ extern void chpl_memTracking_returnConfigVals(chpl_bool*,
                                               chpl_bool*,
                                               size_t*,
                                               size_t*,
+                                              size_t*,
+                                              c_string*,
                                               c_string*,
                                               c_string*);
 
 chpl_bool chpl_memTrack = false;
+chpl_bool chpl_memProfile = false;
+chpl_bool chpl_memCounters = false;
 
 #undef malloc
 #undef calloc
@@ -67,33 +73,73 @@ typedef struct memTableEntry_struct { /* table entry */
   struct memTableEntry_struct* nextInBucket;
 } memTableEntry;
 
-#define NUM_HASH_SIZE_INDICES 20
+//
+// The memory table is split into shards, each a chained hash table
+// with its own lock, so that threads allocating and freeing different
+// memory seldom contend.  An address determines its shard and its
+// bucket within the shard, so a free on any thread finds the entry
+// its allocation made.  Each shard grows and shrinks by itself, in
+// powers of two.
+//
+#define NUM_SHARDS_LOG2 6
+#define NUM_SHARDS (1 << NUM_SHARDS_LOG2)
+#define MIN_SHARD_SIZE 64
 
-static int hashSizes[NUM_HASH_SIZE_INDICES] = { 1543, 3079, 6151, 12289, 24593, 49157, 98317,
-                                                196613, 393241, 786433, 1572869, 3145739,
-                                                6291469, 12582917, 25165843, 50331653,
-                                                100663319, 201326611, 402653189, 805306457 };
-static int hashSizeIndex = 0;
-static int hashSize = 0;
+typedef struct {
+  chpl_sync_aux_t lock;
+  memTableEntry** buckets;
+  size_t size;                    /* number of buckets (a power of 2) */
+  size_t entries;                 /* number of entries in the shard */
+  size_t freed;                   /* total memory freed from the shard */
+  char pad[64];                   /* keep shards' hot fields apart */
+} memTableShard;
 
-static memTableEntry** memTable = NULL;
+static memTableShard memTable[NUM_SHARDS];
 
 static _Bool memLeaks = false;
 static _Bool memLeaksTable = false;
 static _Bool memStats = false;
 static size_t memMax = 0;
 static size_t memThreshold = 0;
+static size_t memProfile = 0;     /* profile sample interval, in bytes */
+static chpl_sync_aux_t memProfile_sync;
 static c_string memLog = "";
 static FILE* memLogFile = NULL;
 static c_string memLeaksLog = "";
+static c_string memHugePages = "";
 
+//
+// These are updated without locks.  They are plain size_t (rather
+// than chpl-atomics.h types) so that chpl_printMemStat() can get them
+// from other locales as raw memory.  The total allocated is not kept
+// separately; it is always totalMem plus the total freed.
+//
 static size_t totalMem = 0;       /* total memory currently allocated */
 static size_t maxMem = 0;         /* maximum total memory during run  */
-static size_t totalAllocated = 0; /* total memory allocated */
-static size_t totalFreed = 0;     /* total memory freed */
-static size_t totalEntries = 0;     /* number of entries in hash table */
 
-static chpl_sync_aux_t memTrack_sync;
+#if defined(__ATOMIC_RELAXED)
+#define MEMSTAT_ADD(p, v) __atomic_add_fetch(p, v, __ATOMIC_RELAXED)
+#define MEMSTAT_SUB(p, v) __atomic_sub_fetch(p, v, __ATOMIC_RELAXED)
+#define MEMSTAT_READ(p)   __atomic_load_n(p, __ATOMIC_RELAXED)
+#else
+#define MEMSTAT_ADD(p, v) __sync_add_and_fetch(p, v)
+#define MEMSTAT_SUB(p, v) __sync_sub_and_fetch(p, v)
+#define MEMSTAT_READ(p)   (*(volatile size_t*) (p))
+#endif
+
+// If *p is *oldp, set it to newVal; otherwise update *oldp from *p.
+static inline chpl_bool memStatCAS(size_t* p, size_t* oldp, size_t newVal) {
+#if defined(__ATOMIC_RELAXED)
+  return __atomic_compare_exchange_n(p, oldp, newVal, true,
+                                     __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+#else
+  size_t prev = __sync_val_compare_and_swap(p, *oldp, newVal);
+  if (prev == *oldp)
+    return true;
+  *oldp = prev;
+  return false;
+#endif
+}
 
 
 void chpl_setMemFlags(void) {
@@ -120,8 +166,12 @@ void chpl_setMemFlags(void) {
                                     &memLeaksTable,
                                     &memMax,
                                     &memThreshold,
+                                    &memProfile,
                                     &memLog,
-                                    &memLeaksLog);
+                                    &memLeaksLog,
+                                    &memHugePages);
+
+  chpl_mem_setArrayPageMode(memHugePages);
 
   if (local_memTrack
       || memStats
@@ -146,77 +196,103 @@ void chpl_setMemFlags(void) {
   }
 
   if (chpl_memTrack) {
-    chpl_sync_initAux(&memTrack_sync);
-    hashSizeIndex = 0;
-    hashSize = hashSizes[hashSizeIndex];
-    memTable = calloc(hashSize, sizeof(memTableEntry*));
+    int i;
+    for (i = 0; i < NUM_SHARDS; i++) {
+      chpl_sync_initAux(&memTable[i].lock);
+      memTable[i].size = MIN_SHARD_SIZE;
+      memTable[i].buckets = calloc(MIN_SHARD_SIZE, sizeof(memTableEntry*));
+      if (!memTable[i].buckets)
+        chpl_error("memtrack fault: out of memory allocating memtrack table",
+                   0, 0);
+    }
+  }
+
+  if (memProfile > 0) {
+    chpl_sync_initAux(&memProfile_sync);
+    chpl_memProfile = true;
   }
 }
 
 
-static unsigned hash(void* memAlloc, int hashSize) {
-  unsigned hashValue = 0;
-  char* fakeCharPtr = (char*)&memAlloc;
-  size_t i;
-  for (i = 0; i < sizeof(void*); i++) {
-    hashValue = *fakeCharPtr + 31 * hashValue;
-    fakeCharPtr++;
-  }
-  return hashValue % hashSize;
+//
+// Mix all the bits of an address, so that the usual alignment of
+// allocations doesn't leave shards or buckets unused.  This is the
+// 64-bit finalizer from MurmurHash3.
+//
+static inline uint64_t hash(void* memAlloc) {
+  uint64_t h = (uint64_t) (uintptr_t) memAlloc;
+  h ^= h >> 33;
+  h *= UINT64_C(0xff51afd7ed558ccd);
+  h ^= h >> 33;
+  h *= UINT64_C(0xc4ceb9fe1a85ec53);
+  h ^= h >> 33;
+  return h;
+}
+
+
+static inline memTableShard* shardFor(uint64_t h) {
+  return &memTable[h & (NUM_SHARDS - 1)];
+}
+
+
+static inline size_t bucketFor(uint64_t h, size_t size) {
+  return (h >> NUM_SHARDS_LOG2) & (size - 1);
 }
 
 
 static void increaseMemStat(size_t chunk, int32_t lineno, c_string filename) {
-  totalMem += chunk;
-  totalAllocated += chunk;
-  if (memMax && (totalMem > memMax)) {
+  size_t newTotal = MEMSTAT_ADD(&totalMem, chunk);
+  size_t oldMax;
+
+  if (memMax && (newTotal > memMax)) {
     chpl_error("Exceeded memory limit", lineno, filename);
   }
-  if (totalMem > maxMem)
-    maxMem = totalMem;
+
+  oldMax = MEMSTAT_READ(&maxMem);
+  while (newTotal > oldMax && !memStatCAS(&maxMem, &oldMax, newTotal))
+    ;
 }
 
 
-static void decreaseMemStat(size_t chunk) {
-  totalMem -= chunk; // > totalMem ? 0 : totalMem - chunk;
-  totalFreed += chunk;
+// assumes the shard is locked!
+static void decreaseMemStat(memTableShard* shard, size_t chunk) {
+  (void) MEMSTAT_SUB(&totalMem, chunk);
+  shard->freed += chunk;
 }
 
 
+// assumes the shard is locked!
 static void
-resizeTable(int direction) {
-  memTableEntry** newMemTable = NULL;
-  int newHashSizeIndex, newHashSize, newHashValue;
-  int i;
+resizeShard(memTableShard* shard, size_t newSize) {
+  memTableEntry** newBuckets;
   memTableEntry* me;
   memTableEntry* next;
+  size_t i;
 
-  newHashSizeIndex = hashSizeIndex + direction;
-  newHashSize = hashSizes[newHashSizeIndex];
-  newMemTable = calloc(newHashSize, sizeof(memTableEntry*));
+  newBuckets = calloc(newSize, sizeof(memTableEntry*));
+  if (!newBuckets)
+    return;  // just live with longer chains
 
-  for (i = 0; i < hashSize; i++) {
-    for (me = memTable[i]; me != NULL; me = next) {
+  for (i = 0; i < shard->size; i++) {
+    for (me = shard->buckets[i]; me != NULL; me = next) {
+      size_t b = bucketFor(hash(me->memAlloc), newSize);
       next = me->nextInBucket;
-      newHashValue = hash(me->memAlloc, newHashSize);
-      me->nextInBucket = newMemTable[newHashValue];
-      newMemTable[newHashValue] = me;
+      me->nextInBucket = newBuckets[b];
+      newBuckets[b] = me;
     }
   }
 
-  free(memTable);
-  memTable = newMemTable;
-  hashSize = newHashSize;
-  hashSizeIndex = newHashSizeIndex;
+  free(shard->buckets);
+  shard->buckets = newBuckets;
+  shard->size = newSize;
 }
 
 
 static void addMemTableEntry(void* memAlloc, size_t number, size_t size, chpl_mem_descInt_t description, int32_t lineno, c_string filename) {
-  unsigned hashValue;
+  uint64_t h = hash(memAlloc);
+  memTableShard* shard = shardFor(h);
   memTableEntry* memEntry;
-
-  if ((totalEntries+1)*2 > hashSize && hashSizeIndex < NUM_HASH_SIZE_INDICES-1)
-    resizeTable(1);
+  size_t b;
 
   memEntry = (memTableEntry*) calloc(1, sizeof(memTableEntry));
   if (!memEntry) {
@@ -224,51 +300,468 @@ static void addMemTableEntry(void* memAlloc, size_t number, size_t size, chpl_me
                lineno, filename);
   }
 
-  hashValue = hash(memAlloc, hashSize);
-  memEntry->nextInBucket = memTable[hashValue];
-  memTable[hashValue] = memEntry;
   memEntry->description = description;
   memEntry->memAlloc = memAlloc;
   memEntry->lineno = lineno;
   memEntry->filename = filename; // do we want to copy this string?
   memEntry->number = number;
   memEntry->size = size;
+
+  chpl_sync_lock(&shard->lock);
+  if (shard->entries + 1 > shard->size)
+    resizeShard(shard, 2 * shard->size);
+  b = bucketFor(h, shard->size);
+  memEntry->nextInBucket = shard->buckets[b];
+  shard->buckets[b] = memEntry;
+  shard->entries += 1;
+  chpl_sync_unlock(&shard->lock);
+
   increaseMemStat(number*size, lineno, filename);
-  totalEntries += 1;
 }
 
 
+//
+// Remove the entry for the given address, if there is one, and return
+// it.  The caller owns (and must free) the returned entry.
+//
 static memTableEntry* removeMemTableEntry(void* address) {
-  unsigned hashValue = hash(address, hashSize);
-  memTableEntry* thisBucketEntry = memTable[hashValue];
+  uint64_t h = hash(address);
+  memTableShard* shard = shardFor(h);
+  memTableEntry** link;
   memTableEntry* deletedBucket = NULL;
 
-  if (!thisBucketEntry)
-    return NULL;
+  chpl_sync_lock(&shard->lock);
+  for (link = &shard->buckets[bucketFor(h, shard->size)];
+       *link != NULL;
+       link = &(*link)->nextInBucket) {
+    if ((*link)->memAlloc == address) {
+      deletedBucket = *link;
+      *link = deletedBucket->nextInBucket;
+      break;
+    }
+  }
+  if (deletedBucket) {
+    decreaseMemStat(shard, deletedBucket->number * deletedBucket->size);
+    shard->entries -= 1;
+    if (shard->entries*8 < shard->size && shard->size > MIN_SHARD_SIZE)
+      resizeShard(shard, shard->size / 2);
+  }
+  chpl_sync_unlock(&shard->lock);
 
-  if (thisBucketEntry->memAlloc == address) {
-    memTable[hashValue] = thisBucketEntry->nextInBucket;
-    deletedBucket = thisBucketEntry;
+  return deletedBucket;
+}
+
+
+static void lockAllShards(void) {
+  int i;
+  for (i = 0; i < NUM_SHARDS; i++)
+    chpl_sync_lock(&memTable[i].lock);
+}
+
+
+static void unlockAllShards(void) {
+  int i;
+  for (i = NUM_SHARDS - 1; i >= 0; i--)
+    chpl_sync_unlock(&memTable[i].lock);
+}
+
+
+//
+// Get the current, maximum, allocated, and freed totals for a locale.
+//
+static void getMemStats(int node, size_t* cur, size_t* max,
+                        size_t* allocated, size_t* freed,
+                        int32_t lineno, c_string filename) {
+  int i;
+
+  if (node == chpl_nodeID) {
+    *cur = MEMSTAT_READ(&totalMem);
+    *max = MEMSTAT_READ(&maxMem);
+    *freed = 0;
+    for (i = 0; i < NUM_SHARDS; i++)
+      *freed += MEMSTAT_READ(&memTable[i].freed);
   } else {
-    for (thisBucketEntry = memTable[hashValue];
-         thisBucketEntry != NULL;
-         thisBucketEntry = thisBucketEntry->nextInBucket) {
+    static memTableShard shards[NUM_SHARDS];
+    chpl_gen_comm_get(cur, node, &totalMem, sizeof(size_t), -1 /* broke for hetero */, 1, lineno, filename);
+    chpl_gen_comm_get(max, node, &maxMem, sizeof(size_t), -1 /* broke for hetero */, 1, lineno, filename);
+    chpl_gen_comm_get(shards, node, memTable, sizeof(shards), -1 /* broke for hetero */, 1, lineno, filename);
+    *freed = 0;
+    for (i = 0; i < NUM_SHARDS; i++)
+      *freed += shards[i].freed;
+  }
+  *allocated = *cur + *freed;
+}
+
+
+//
+// Counters-only statistics.  With CHPL_RT_MEM_COUNTERS set, every
+// allocation and free adjusts a few per-locale byte counters, and
+// every allocation bumps the counters for its description, all with
+// relaxed atomic adds and no table.  The sizes come from the
+// allocator (chpl_usable_size()), so that a free can be counted
+// without knowing what was allocated.  This has to be turned on when
+// the memory layer starts rather than by a config const, so that no
+// block is freed without its allocation having been counted.
+//
+typedef struct {
+  size_t allocations;
+  size_t bytes;
+} memDescCounter;
+
+static memDescCounter* descCounters = NULL;
+static int numDescCounters = 0;
+static size_t ctrInUse = 0;
+static size_t ctrHighWater = 0;
+static size_t ctrFreed = 0;
+
+void chpl_initMemCounters(void) {
+  if (!chpl_env_rt_get_bool("CHPL_RT_MEM_COUNTERS", false))
+    return;
+
+  numDescCounters = CHPL_RT_MD_NUM + chpl_mem_numDescs;
+  descCounters = calloc(numDescCounters, sizeof(memDescCounter));
+  if (descCounters == NULL)
+    chpl_error("out of memory allocating memory counters", 0, 0);
+  chpl_memCounters = true;
+}
+
+static void countMalloc(size_t usable, chpl_mem_descInt_t description) {
+  size_t newInUse = MEMSTAT_ADD(&ctrInUse, usable);
+  size_t oldMax = MEMSTAT_READ(&ctrHighWater);
+
+  while (newInUse > oldMax &&
+         !memStatCAS(&ctrHighWater, &oldMax, newInUse))
+    ;
+  if (description >= 0 && description < numDescCounters) {
+    (void) MEMSTAT_ADD(&descCounters[description].allocations, 1);
+    (void) MEMSTAT_ADD(&descCounters[description].bytes, usable);
+  }
+}
+
+static void countFree(size_t usable) {
+  (void) MEMSTAT_SUB(&ctrInUse, usable);
+  (void) MEMSTAT_ADD(&ctrFreed, usable);
+}
+
+static void checkMemCounters(c_string what, int32_t lineno,
+                             c_string filename) {
+  if (!chpl_memCounters) {
+    char message[128];
+    snprintf(message, sizeof(message),
+             "invalid call to %s(); rerun with CHPL_RT_MEM_COUNTERS=1", what);
+    chpl_error(message, lineno, filename);
+  }
+}
+
+uint64_t chpl_memCountersInUse(int32_t lineno, c_string filename) {
+  checkMemCounters("memoryInUse", lineno, filename);
+  return (uint64_t)MEMSTAT_READ(&ctrInUse);
+}
+
+uint64_t chpl_memCountersHighWater(int32_t lineno, c_string filename) {
+  checkMemCounters("memoryHighWater", lineno, filename);
+  return (uint64_t)MEMSTAT_READ(&ctrHighWater);
+}
+
+uint64_t chpl_memCountersTotalAllocated(int32_t lineno, c_string filename) {
+  size_t freed, inUse;
+  checkMemCounters("memoryTotalAllocated", lineno, filename);
+  freed = MEMSTAT_READ(&ctrFreed);
+  inUse = MEMSTAT_READ(&ctrInUse);
+  return (uint64_t)(inUse + freed);
+}
+
+uint64_t chpl_memCountersTotalFreed(int32_t lineno, c_string filename) {
+  checkMemCounters("memoryTotalFreed", lineno, filename);
+  return (uint64_t)MEMSTAT_READ(&ctrFreed);
+}
 
-      memTableEntry* nextBucketEntry = thisBucketEntry->nextInBucket;
+int chpl_memCountersNumDescs(int32_t lineno, c_string filename) {
+  checkMemCounters("memoryByDescription", lineno, filename);
+  return numDescCounters;
+}
+
+c_string chpl_memCountersDescName(int desc) {
+  return chpl_mem_descString(desc);
+}
+
+uint64_t chpl_memCountersDescAllocations(int desc) {
+  return (uint64_t)MEMSTAT_READ(&descCounters[desc].allocations);
+}
 
-      if (nextBucketEntry && nextBucketEntry->memAlloc == address) {
-        thisBucketEntry->nextInBucket = nextBucketEntry->nextInBucket;
-        deletedBucket = nextBucketEntry;
+uint64_t chpl_memCountersDescBytes(int desc) {
+  return (uint64_t)MEMSTAT_READ(&descCounters[desc].bytes);
+}
+
+
+//
+// Allocation profiling.  With --memProfile=N we sample allocations so
+// that on average one is recorded for every N bytes allocated, and
+// keep totals for each allocation site, that is, each combination of
+// source location and memory description.  Each sample stands for N
+// bytes times the number of sample points that fell in it, which
+// makes the totals unbiased estimates however big the allocations
+// are.  For each site we estimate the cumulative bytes allocated, the
+// bytes live now, and the most bytes live there at any one time.
+// Only sampled allocations are remembered, so a free costs a lookup
+// in a table that is much smaller than the memory tracking table.
+//
+typedef struct memProfileSite_struct {
+  c_string filename;
+  int32_t lineno;
+  chpl_mem_descInt_t description;
+  size_t samples;                 /* number of sampled allocations */
+  size_t cumulative;              /* estimated bytes allocated */
+  size_t live;                    /* estimated bytes live now */
+  size_t peakLive;                /* maximum of live */
+  struct memProfileSite_struct* next;
+} memProfileSite;
+
+typedef struct memProfileSample_struct {
+  void* memAlloc;
+  size_t weight;                  /* bytes this sample stands for */
+  memProfileSite* site;
+  struct memProfileSample_struct* next;
+} memProfileSample;
+
+#define PROFILE_SITE_BUCKETS 1024
+static memProfileSite* profileSites[PROFILE_SITE_BUCKETS];
+static size_t numProfileSites = 0;
+
+static memProfileSample** profileSamples = NULL;
+static size_t profileSamplesSize = 0;     /* a power of 2 */
+static size_t numProfileSamples = 0;
+
+//
+// Bytes left until the next sample point.  This is per thread if we
+// can manage that cheaply; otherwise unsynchronized updates from
+// different threads may perturb where samples fall, but not the
+// correctness of what is recorded.
+//
+#ifdef CHPL_TLS
+static CHPL_TLS size_t profileBytesLeft = 0;
+#else
+static size_t profileBytesLeft = 0;
+#endif
+
+
+static unsigned profileSiteHash(c_string filename, int32_t lineno,
+                                chpl_mem_descInt_t description) {
+  unsigned h = (unsigned) lineno * 31 + (unsigned) description;
+  if (filename) {
+    const char* p;
+    for (p = filename; *p != '\0'; p++)
+      h = h * 31 + (unsigned char) *p;
+  }
+  return h & (PROFILE_SITE_BUCKETS - 1);
+}
+
+
+// assumes memProfile_sync is locked!
+static memProfileSite* profileSiteFor(c_string filename, int32_t lineno,
+                                      chpl_mem_descInt_t description) {
+  unsigned b = profileSiteHash(filename, lineno, description);
+  memProfileSite* site;
+
+  for (site = profileSites[b]; site != NULL; site = site->next) {
+    if (site->lineno == lineno && site->description == description
+        && (site->filename == filename
+            || (site->filename && filename
+                && strcmp(site->filename, filename) == 0)))
+      return site;
+  }
+
+  site = (memProfileSite*) calloc(1, sizeof(memProfileSite));
+  if (!site)
+    return NULL;
+  site->filename = filename;
+  site->lineno = lineno;
+  site->description = description;
+  site->next = profileSites[b];
+  profileSites[b] = site;
+  numProfileSites++;
+  return site;
+}
+
+
+// assumes memProfile_sync is locked!
+static void growProfileSamples(void) {
+  size_t newSize = (profileSamplesSize == 0) ? 1024 : 2 * profileSamplesSize;
+  memProfileSample** newSamples;
+  memProfileSample* ps;
+  memProfileSample* next;
+  size_t i;
+
+  newSamples = calloc(newSize, sizeof(memProfileSample*));
+  if (!newSamples)
+    return;  // just live with longer chains
+  for (i = 0; i < profileSamplesSize; i++) {
+    for (ps = profileSamples[i]; ps != NULL; ps = next) {
+      size_t b = hash(ps->memAlloc) & (newSize - 1);
+      next = ps->next;
+      ps->next = newSamples[b];
+      newSamples[b] = ps;
+    }
+  }
+  free(profileSamples);
+  profileSamples = newSamples;
+  profileSamplesSize = newSize;
+}
+
+
+static void profileMalloc(void* memAlloc, size_t chunk,
+                          chpl_mem_descInt_t description,
+                          int32_t lineno, c_string filename) {
+  size_t left = profileBytesLeft;
+  size_t points;
+  memProfileSite* site;
+  memProfileSample* ps;
+
+  //
+  // This is the only part of the profiler that unsampled allocations
+  // see, so keep it short.  The next sample point is always between 1
+  // and memProfile bytes away; an allocation that reaches it is
+  // sampled, and stands for every sample point that falls within it.
+  //
+  if (left == 0)
+    left = memProfile;
+  if (chunk < left) {
+    profileBytesLeft = left - chunk;
+    return;
+  }
+  points = 1 + (chunk - left) / memProfile;
+  profileBytesLeft = memProfile - (chunk - left) % memProfile;
+
+  if (memAlloc == NULL)
+    return;
+
+  ps = (memProfileSample*) malloc(sizeof(memProfileSample));
+  if (!ps)
+    return;
+  ps->memAlloc = memAlloc;
+  ps->weight = points * memProfile;
+
+  chpl_sync_lock(&memProfile_sync);
+  site = profileSiteFor(filename, lineno, description);
+  if (site == NULL) {
+    chpl_sync_unlock(&memProfile_sync);
+    free(ps);
+    return;
+  }
+  ps->site = site;
+  site->samples++;
+  site->cumulative += ps->weight;
+  site->live += ps->weight;
+  if (site->live > site->peakLive)
+    site->peakLive = site->live;
+
+  if (numProfileSamples + 1 > profileSamplesSize)
+    growProfileSamples();
+  {
+    size_t b = hash(memAlloc) & (profileSamplesSize - 1);
+    ps->next = profileSamples[b];
+    profileSamples[b] = ps;
+    numProfileSamples++;
+  }
+  chpl_sync_unlock(&memProfile_sync);
+}
+
+
+static void profileFree(void* memAlloc) {
+  memProfileSample** link;
+  memProfileSample* ps = NULL;
+
+  if (memAlloc == NULL || numProfileSamples == 0)
+    return;
+
+  chpl_sync_lock(&memProfile_sync);
+  if (profileSamplesSize > 0) {
+    for (link = &profileSamples[hash(memAlloc) & (profileSamplesSize - 1)];
+         *link != NULL;
+         link = &(*link)->next) {
+      if ((*link)->memAlloc == memAlloc) {
+        ps = *link;
+        *link = ps->next;
+        numProfileSamples--;
+        ps->site->live -= ps->weight;
+        break;
       }
     }
   }
-  if (deletedBucket) {
-    decreaseMemStat(deletedBucket->number * deletedBucket->size);
-    totalEntries -= 1;
-    if (totalEntries*8 < hashSize && hashSizeIndex > 0)
-      resizeTable(-1);
+  chpl_sync_unlock(&memProfile_sync);
+
+  if (ps)
+    free(ps);
+}
+
+
+static int profileSiteCmp(const void* p1, const void* p2) {
+  const memProfileSite* s1 = *(memProfileSite* const*) p1;
+  const memProfileSite* s2 = *(memProfileSite* const*) p2;
+
+  if (s1->cumulative != s2->cumulative)
+    return (s1->cumulative < s2->cumulative) ? 1 : -1;
+  if (s1->peakLive != s2->peakLive)
+    return (s1->peakLive < s2->peakLive) ? 1 : -1;
+  return 0;
+}
+
+
+void chpl_printMemProfile(void) {
+  const int numberWidth = 13;
+  memProfileSite** table;
+  memProfileSite* site;
+  char loc[256];
+  size_t n, i;
+
+  if (!chpl_memProfile)
+    return;
+
+  chpl_sync_lock(&memProfile_sync);
+
+  table = (memProfileSite**) malloc((numProfileSites + 1)
+                                    * sizeof(memProfileSite*));
+  if (!table) {
+    chpl_sync_unlock(&memProfile_sync);
+    chpl_error("out of memory printing allocation profile", 0, 0);
   }
-  return deletedBucket;
+  n = 0;
+  for (i = 0; i < PROFILE_SITE_BUCKETS; i++)
+    for (site = profileSites[i]; site != NULL; site = site->next)
+      table[n++] = site;
+  qsort(table, n, sizeof(memProfileSite*), profileSiteCmp);
+
+  fprintf(memLogFile, "==================\n");
+  fprintf(memLogFile, "Allocation Profile\n");
+  fprintf(memLogFile, "==============================================================\n");
+  fprintf(memLogFile, "Locale %" FORMAT_c_nodeid_t
+          ", one sample per %zu bytes; byte counts are estimates\n",
+          chpl_nodeID, memProfile);
+  fprintf(memLogFile, "%-*s%-*s%-*s%-*s%s\n",
+          numberWidth, "Cumulative",
+          numberWidth, "Peak Live",
+          numberWidth, "Live",
+          numberWidth, "Samples",
+          "Allocation site (description)");
+  fprintf(memLogFile, "==============================================================\n");
+  for (i = 0; i < n; i++) {
+    site = table[i];
+    if (site->filename)
+      snprintf(loc, sizeof(loc), "%s:%" PRId32, site->filename, site->lineno);
+    else
+      snprintf(loc, sizeof(loc), "--");
+    fprintf(memLogFile, "%-*zu%-*zu%-*zu%-*zu%s (%s)\n",
+            numberWidth, site->cumulative,
+            numberWidth, site->peakLive,
+            numberWidth, site->live,
+            numberWidth, site->samples,
+            loc, chpl_mem_descString(site->description));
+  }
+  fprintf(memLogFile, "==============================================================\n");
+
+  chpl_sync_unlock(&memProfile_sync);
+
+  free(table);
 }
 
 
@@ -276,7 +769,7 @@ uint64_t chpl_memoryUsed(int32_t lineno, c_string filename) {
   if (!chpl_memTrack)
     chpl_error("invalid call to memoryUsed(); rerun with --memTrack",
                lineno, filename);
-  return (uint64_t)totalMem;
+  return (uint64_t)MEMSTAT_READ(&totalMem);
 }
 
 
@@ -284,15 +777,30 @@ void chpl_printMemStat(int32_t lineno, c_string filename) {
   if (!chpl_memTrack)
     chpl_error("invalid call to printMemStat(); rerun with --memTrack",
                lineno, filename);
-  chpl_sync_lock(&memTrack_sync);
   fprintf(memLogFile, "=================\n");
   fprintf(memLogFile, "Memory Statistics\n");
   if (chpl_numNodes == 1) {
+    size_t m1, m2, m3, m4;
+    getMemStats(0, &m1, &m2, &m3, &m4, lineno, filename);
     fprintf(memLogFile, "==============================================================\n");
-    fprintf(memLogFile, "Current Allocated Memory               %zd\n", totalMem);
-    fprintf(memLogFile, "Maximum Simultaneous Allocated Memory  %zd\n", maxMem);
-    fprintf(memLogFile, "Total Allocated Memory                 %zd\n", totalAllocated);
-    fprintf(memLogFile, "Total Freed Memory                     %zd\n", totalFreed);
+    fprintf(memLogFile, "Current Allocated Memory               %zd\n", m1);
+    fprintf(memLogFile, "Maximum Simultaneous Allocated Memory  %zd\n", m2);
+    fprintf(memLogFile, "Total Allocated Memory                 %zd\n", m3);
+    fprintf(memLogFile, "Total Freed Memory                     %zd\n", m4);
+    if (chpl_mem_arrayPageMode != CHPL_MEM_PAGES_NORMAL) {
+      chpl_mem_hugePageStats_t hs;
+      chpl_mem_getHugePageStats(&hs);
+      fprintf(memLogFile, "Array Page Mode                        %s\n",
+              chpl_mem_arrayPageModeName());
+      fprintf(memLogFile, "Arrays on hugetlbfs Pages              %zd\n",
+              hs.numHugetlb);
+      fprintf(memLogFile, "Arrays on Transparent Huge Pages       %zd\n",
+              hs.numThp);
+      fprintf(memLogFile, "  (hugetlbfs fallbacks)                %zd\n",
+              hs.numFallback);
+      fprintf(memLogFile, "Current Huge Page Array Memory         %zd\n",
+              hs.curBytes);
+    }
     fprintf(memLogFile, "==============================================================\n");
   } else {
     int i;
@@ -305,15 +813,11 @@ void chpl_printMemStat(int32_t lineno, c_string filename) {
     fprintf(memLogFile, "==============================================================\n");
     for (i = 0; i < chpl_numNodes; i++) {
       static size_t m1, m2, m3, m4;
-      chpl_gen_comm_get(&m1, i, &totalMem, sizeof(size_t), -1 /* broke for hetero */, 1, lineno, filename);
-      chpl_gen_comm_get(&m2, i, &maxMem, sizeof(size_t), -1 /* broke for hetero */, 1, lineno, filename);
-      chpl_gen_comm_get(&m3, i, &totalAllocated,  sizeof(size_t), -1 /* broke for hetero */, 1, lineno, filename);
-      chpl_gen_comm_get(&m4, i, &totalFreed, sizeof(size_t), -1 /*broke for hetero */, 1, lineno, filename);
+      getMemStats(i, &m1, &m2, &m3, &m4, lineno, filename);
       fprintf(memLogFile, "%-9d  %-9zu  %-9zu  %-9zu  %-9zu\n", i, m1, m2, m3, m4);
     }
     fprintf(memLogFile, "==============================================================\n");
   }
-  chpl_sync_unlock(&memTrack_sync);
 }
 
 
@@ -330,13 +834,18 @@ void chpl_printLeakedMemTable(void) {
 
   table = (size_t*)calloc(numEntries, 3*sizeof(size_t));
 
-  for (i = 0; i < hashSize; i++) {
-    for (me = memTable[i]; me != NULL; me = me->nextInBucket) {
-      table[3*me->description] += me->number*me->size;
-      table[3*me->description+1] += 1;
-      table[3*me->description+2] = me->description;
+  lockAllShards();
+  for (i = 0; i < NUM_SHARDS; i++) {
+    size_t b;
+    for (b = 0; b < memTable[i].size; b++) {
+      for (me = memTable[i].buckets[b]; me != NULL; me = me->nextInBucket) {
+        table[3*me->description] += me->number*me->size;
+        table[3*me->description+1] += 1;
+        table[3*me->description+2] = me->description;
+      }
     }
   }
+  unlockAllShards();
 
   qsort(table, numEntries, 3*sizeof(size_t), leakedMemTableEntryCmp);
 
@@ -362,6 +871,10 @@ void chpl_printLeakedMemTable(void) {
 
 
 void chpl_reportMemInfo() {
+  if (chpl_memProfile) {
+    fprintf(memLogFile, "\n");
+    chpl_printMemProfile();
+  }
   if (memStats) {
     fprintf(memLogFile, "\n");
     chpl_printMemStat(0, 0);
@@ -417,17 +930,26 @@ void chpl_printMemTable(int64_t threshold, int32_t lineno, c_string filename) {
   if (!chpl_memTrack)
     chpl_error("The printMemTable function only works with the --memTrack flag", lineno, filename);
 
+  //
+  // Hold all the shards still while we look at them, so that the
+  // entries we count are the entries we print.
+  //
+  lockAllShards();
+
   n = 0;
   filenameWidth = strlen("Allocated Memory (Bytes)");
-  for (i = 0; i < hashSize; i++) {
-    for (memEntry = memTable[i]; memEntry != NULL; memEntry = memEntry->nextInBucket) {
-      size_t chunk = memEntry->number * memEntry->size;
-      if (chunk >= threshold) {
-        n += 1;
-        if (memEntry->filename) {
-          int filenameLength = strlen(memEntry->filename);
-          if (filenameLength > filenameWidth)
-            filenameWidth = filenameLength;
+  for (i = 0; i < NUM_SHARDS; i++) {
+    size_t b;
+    for (b = 0; b < memTable[i].size; b++) {
+      for (memEntry = memTable[i].buckets[b]; memEntry != NULL; memEntry = memEntry->nextInBucket) {
+        size_t chunk = memEntry->number * memEntry->size;
+        if (chunk >= threshold) {
+          n += 1;
+          if (memEntry->filename) {
+            int filenameLength = strlen(memEntry->filename);
+            if (filenameLength > filenameWidth)
+              filenameWidth = filenameLength;
+          }
         }
       }
     }
@@ -453,11 +975,14 @@ void chpl_printMemTable(int64_t threshold, int32_t lineno, c_string filename) {
     chpl_error("out of memory printing memory table", lineno, filename);
 
   n = 0;
-  for (i = 0; i < hashSize; i++) {
-    for (memEntry = memTable[i]; memEntry != NULL; memEntry = memEntry->nextInBucket) {
-      size_t chunk = memEntry->number * memEntry->size;
-      if (chunk >= threshold) {
-        table[n++] = memEntry;
+  for (i = 0; i < NUM_SHARDS; i++) {
+    size_t b;
+    for (b = 0; b < memTable[i].size; b++) {
+      for (memEntry = memTable[i].buckets[b]; memEntry != NULL; memEntry = memEntry->nextInBucket) {
+        size_t chunk = memEntry->number * memEntry->size;
+        if (chunk >= threshold) {
+          table[n++] = memEntry;
+        }
       }
     }
   }
@@ -484,6 +1009,8 @@ void chpl_printMemTable(int64_t threshold, int32_t lineno, c_string filename) {
   fprintf(memLogFile, "\n");
   putchar('\n');
 
+  unlockAllShards();
+
   free(table);
   free(loc);
 }
@@ -492,11 +1019,22 @@ void chpl_printMemTable(int64_t threshold, int32_t lineno, c_string filename) {
 void chpl_track_malloc(void* memAlloc, size_t number, size_t size,
                        chpl_mem_descInt_t description,
                        int32_t lineno, c_string filename) {
+  chpl_track_malloc_sized(memAlloc, number, size,
+                          chpl_memCounters ? chpl_usable_size(memAlloc) : 0,
+                          description, lineno, filename);
+}
+
+
+void chpl_track_malloc_sized(void* memAlloc, size_t number, size_t size,
+                             size_t usable, chpl_mem_descInt_t description,
+                             int32_t lineno, c_string filename) {
+  if (chpl_memCounters)
+    countMalloc(usable, description);
+  if (chpl_memProfile)
+    profileMalloc(memAlloc, number * size, description, lineno, filename);
   if (number * size > memThreshold) {
     if (chpl_memTrack) {
-      chpl_sync_lock(&memTrack_sync);
       addMemTableEntry(memAlloc, number, size, description, lineno, filename);
-      chpl_sync_unlock(&memTrack_sync);
     }
     if (chpl_verbose_mem) {
       fprintf(memLogFile,
@@ -510,9 +1048,20 @@ void chpl_track_malloc(void* memAlloc, size_t number, size_t size,
 
 
 void chpl_track_free(void* memAlloc, int32_t lineno, c_string filename) {
+  chpl_track_free_sized(memAlloc,
+                        chpl_memCounters ? chpl_usable_size(memAlloc) : 0,
+                        lineno, filename);
+}
+
+
+void chpl_track_free_sized(void* memAlloc, size_t usable,
+                           int32_t lineno, c_string filename) {
   memTableEntry* memEntry = NULL;
+  if (chpl_memCounters && memAlloc != NULL)
+    countFree(usable);
+  if (chpl_memProfile)
+    profileFree(memAlloc);
   if (chpl_memTrack) {
-    chpl_sync_lock(&memTrack_sync);
     memEntry = removeMemTableEntry(memAlloc);
     if (memEntry) {
       if (chpl_verbose_mem) {
@@ -525,7 +1074,6 @@ void chpl_track_free(void* memAlloc, int32_t lineno, c_string filename) {
       }
       free(memEntry);
     }
-    chpl_sync_unlock(&memTrack_sync);
   } else if (chpl_verbose_mem && !memEntry) {
     fprintf(memLogFile,
             "%" FORMAT_c_nodeid_t ": %s:%" PRId32 ": free at %p\n",
@@ -539,14 +1087,16 @@ void chpl_track_realloc_pre(void* memAlloc, size_t size,
                          int32_t lineno, c_string filename) {
   memTableEntry* memEntry = NULL;
 
+  if (chpl_memCounters && memAlloc != NULL)
+    countFree(chpl_usable_size(memAlloc));
+  if (chpl_memProfile)
+    profileFree(memAlloc);
   if (chpl_memTrack && size > memThreshold) {
-    chpl_sync_lock(&memTrack_sync);
     if (memAlloc) {
       memEntry = removeMemTableEntry(memAlloc);
       if (memEntry)
         free(memEntry);
     }
-    chpl_sync_unlock(&memTrack_sync);
   }
 }
 
@@ -555,11 +1105,13 @@ void chpl_track_realloc_post(void* moreMemAlloc,
                          void* memAlloc, size_t size,
                          chpl_mem_descInt_t description,
                          int32_t lineno, c_string filename) {
+  if (chpl_memCounters)
+    countMalloc(chpl_usable_size(moreMemAlloc), description);
+  if (chpl_memProfile)
+    profileMalloc(moreMemAlloc, size, description, lineno, filename);
   if (size > memThreshold) {
     if (chpl_memTrack) {
-      chpl_sync_lock(&memTrack_sync);
       addMemTableEntry(moreMemAlloc, 1, size, description, lineno, filename);
-      chpl_sync_unlock(&memTrack_sync);
     }
     if (chpl_verbose_mem) {
       fprintf(memLogFile,
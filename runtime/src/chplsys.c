@@ -98,6 +98,15 @@ uint64_t chpl_bytesPerLocale(void) {
 }
 
 
+size_t chpl_getSysPageSize(void) {
+  static size_t pageSize = 0;
+
+  if (pageSize == 0)
+    pageSize = (size_t) chplGetPageSize();
+  return pageSize;
+}
+
+
 size_t chpl_bytesAvailOnThisLocale(void) {
 #if defined __APPLE__
   int membytes;
@@ -0,0 +1,597 @@
+/*
+ * Copyright 2004-2015 Cray Inc.
+ * Other additional copyright holders may be indicated within.
+ * 
+ * The entirety of this work is licensed under the Apache License,
+ * Version 2.0 (the "License"); you may not use this file except
+ * in compliance with the License.
+ * 
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//
+// A multi-arena allocator.
+//
+// Memory is managed in CHUNK_SIZE-aligned chunks.  Chunks come either
+// from the shared heap the comm layer wants us to use (for example
+// the registered GASNet segment), or from mmap() if there is no such
+// heap.  Each thread is bound to one of several arenas, and every
+// chunk other than a huge one belongs to a single arena, whose lock
+// protects it.  Threads in different arenas thus allocate and free
+// without contending with each other, and a free from any thread
+// finds the owning arena through the chunk header.
+//
+// The first page of each chunk holds the chunk header.  The remaining
+// pages are handed out in runs.  A small run is divided into objects
+// of a single size class, with a run header at its start.  A large
+// run holds one allocation.  Huge allocations get whole chunks of
+// their own, directly from the chunk source.
+//
+
+#include "chplrt.h"
+
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "chpl-comm.h"
+#include "chpl-mem.h"
+#include "chpl-thread-local-storage.h"
+#include "chpltypes.h"
+#include "error.h"
+
+#define CHUNK_SHIFT     20
+#define CHUNK_SIZE      ((size_t) 1 << CHUNK_SHIFT)
+#define AR_PAGE_SHIFT   12
+#define AR_PAGE_SIZE    ((size_t) 1 << AR_PAGE_SHIFT)
+#define CHUNK_PAGES     (CHUNK_SIZE >> AR_PAGE_SHIFT)
+#define HDR_PAGES       1
+#define ALIGNMENT       16
+
+#define NUM_CLASSES     24
+#define MAX_SMALL       2048
+#define MAX_RUN_PAGES   16
+#define MAX_LARGE       (CHUNK_SIZE / 2)
+
+#define MAX_ARENAS      64
+
+#define CHUNK_OF(p) ((chunk_t*) ((uintptr_t) (p) & ~(CHUNK_SIZE - 1)))
+#define PAGE_OF(ch, p) \
+  ((size_t) ((char*) (p) - (char*) (ch)) >> AR_PAGE_SHIFT)
+
+typedef enum {
+  PAGE_FREE = 0,
+  PAGE_SMALL,
+  PAGE_LARGE
+} page_kind_t;
+
+struct arena_s;
+
+typedef struct chunk_s {
+  struct arena_s* arena;           // owner; NULL for a huge allocation
+  size_t nchunks;                  // chunks spanned by a huge allocation
+  struct chunk_s* next;            // in the owner's chunk list
+  size_t free_pages;
+  uint8_t page_kind[CHUNK_PAGES];  // page_kind_t for each page
+  uint16_t run_start[CHUNK_PAGES]; // first page of the run holding a page
+  uint16_t run_pages[CHUNK_PAGES]; // length, for the first page of a run
+} chunk_t;
+
+typedef struct run_s {
+  struct run_s* next;              // in the arena's bin, if not full
+  struct run_s* prev;
+  void* free_list;
+  uint32_t nfree;
+  uint32_t nobjs;
+  uint32_t next_fresh;             // objects from here on never used
+  uint32_t cls;
+} run_t;
+
+#define RUN_HDR_SIZE \
+  ((sizeof(run_t) + ALIGNMENT - 1) & ~((size_t) ALIGNMENT - 1))
+
+typedef struct arena_s {
+  pthread_mutex_t lock;
+  run_t* bins[NUM_CLASSES];        // small runs with free objects
+  chunk_t* chunks;
+  int num_empty_chunks;
+  char pad[64];
+} arena_t;
+
+static const uint32_t class_size[NUM_CLASSES] = {
+  16, 32, 48, 64, 80, 96, 112, 128,
+  160, 192, 224, 256, 320, 384, 448, 512,
+  640, 768, 896, 1024, 1280, 1536, 1792, 2048
+};
+
+static uint32_t class_pages[NUM_CLASSES];
+static uint8_t size_class[MAX_SMALL / ALIGNMENT + 1];
+
+static arena_t arenas[MAX_ARENAS];
+static int num_arenas;
+static int next_arena;
+
+CHPL_TLS_DECL(arena_t*, thread_arena);
+
+//
+// Chunk source.  If the comm layer gave us a heap we carve chunks out
+// of it, keeping a byte per chunk to say whether it is in use.  The
+// map itself lives in the first chunks of the heap.
+//
+static pthread_mutex_t chunk_lock = PTHREAD_MUTEX_INITIALIZER;
+static char* heap_chunks;
+static size_t heap_nchunks;
+static uint8_t* heap_chunk_used;
+static size_t heap_hint;
+
+
+static void* chunks_alloc_heap(size_t n) {
+  size_t i, j;
+  void* p = NULL;
+
+  pthread_mutex_lock(&chunk_lock);
+  for (i = heap_hint; i + n <= heap_nchunks; i++) {
+    for (j = 0; j < n && !heap_chunk_used[i + j]; j++)
+      ;
+    if (j == n) {
+      memset(&heap_chunk_used[i], 1, n);
+      if (i == heap_hint)
+        heap_hint = i + n;
+      p = heap_chunks + i * CHUNK_SIZE;
+      break;
+    }
+    i += j;
+  }
+  pthread_mutex_unlock(&chunk_lock);
+  return p;
+}
+
+
+static void chunks_free_heap(void* p, size_t n) {
+  size_t i = (size_t) ((char*) p - heap_chunks) / CHUNK_SIZE;
+
+  pthread_mutex_lock(&chunk_lock);
+  memset(&heap_chunk_used[i], 0, n);
+  if (i < heap_hint)
+    heap_hint = i;
+  pthread_mutex_unlock(&chunk_lock);
+}
+
+
+static void* chunks_alloc_mmap(size_t n) {
+  size_t size = n * CHUNK_SIZE;
+  char* p;
+  size_t lead;
+
+  //
+  // Over-allocate by a chunk so that we can trim the result to chunk
+  // alignment.
+  //
+  p = mmap(NULL, size + CHUNK_SIZE, PROT_READ | PROT_WRITE,
+           MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (p == MAP_FAILED)
+    return NULL;
+  lead = (CHUNK_SIZE - ((uintptr_t) p & (CHUNK_SIZE - 1))) & (CHUNK_SIZE - 1);
+  if (lead > 0)
+    munmap(p, lead);
+  if (lead < CHUNK_SIZE)
+    munmap(p + lead + size, CHUNK_SIZE - lead);
+  return p + lead;
+}
+
+
+//
+// Chunks are reused often as arenas grow and shrink and as huge blocks
+// come and go, so when they come from mmap() we keep some released
+// ones for reuse rather than paying to unmap them and fault them back
+// in.  Memory fresh from mmap() is known to be zeroed, which lets
+// calloc() skip clearing it.
+//
+#define MAX_SPARE_CHUNKS 64
+
+static struct {
+  void* p;
+  size_t n;
+} spare_chunks[MAX_SPARE_CHUNKS];
+static int num_spares;
+static size_t spare_nchunks;
+
+
+static void* chunks_alloc(size_t n, chpl_bool* fresh) {
+  void* p = NULL;
+  int i;
+
+  *fresh = false;
+  if (heap_chunks != NULL)
+    return chunks_alloc_heap(n);
+
+  pthread_mutex_lock(&chunk_lock);
+  for (i = num_spares - 1; i >= 0; i--) {
+    if (spare_chunks[i].n == n) {
+      p = spare_chunks[i].p;
+      spare_chunks[i] = spare_chunks[--num_spares];
+      spare_nchunks -= n;
+      break;
+    }
+  }
+  pthread_mutex_unlock(&chunk_lock);
+  if (p == NULL && (p = chunks_alloc_mmap(n)) != NULL)
+    *fresh = true;
+  return p;
+}
+
+
+static void chunks_free(void* p, size_t n) {
+  if (heap_chunks != NULL) {
+    chunks_free_heap(p, n);
+    return;
+  }
+
+  pthread_mutex_lock(&chunk_lock);
+  if (num_spares < MAX_SPARE_CHUNKS
+      && spare_nchunks + n <= MAX_SPARE_CHUNKS) {
+    spare_chunks[num_spares].p = p;
+    spare_chunks[num_spares].n = n;
+    num_spares++;
+    spare_nchunks += n;
+    p = NULL;
+  }
+  pthread_mutex_unlock(&chunk_lock);
+  if (p != NULL)
+    munmap(p, n * CHUNK_SIZE);
+}
+
+
+//
+// Page runs within an arena's chunks.  The caller holds the arena lock.
+//
+static chunk_t* arena_new_chunk(arena_t* a) {
+  chpl_bool fresh;
+  chunk_t* ch = (chunk_t*) chunks_alloc(1, &fresh);
+
+  if (ch == NULL)
+    return NULL;
+  memset(ch, 0, sizeof(*ch));
+  ch->arena = a;
+  ch->nchunks = 1;
+  ch->free_pages = CHUNK_PAGES - HDR_PAGES;
+  ch->next = a->chunks;
+  a->chunks = ch;
+  a->num_empty_chunks++;
+  return ch;
+}
+
+
+static size_t chunk_find_pages(chunk_t* ch, size_t npages) {
+  size_t i, j;
+
+  for (i = HDR_PAGES; i + npages <= CHUNK_PAGES; i++) {
+    for (j = 0; j < npages && ch->page_kind[i + j] == PAGE_FREE; j++)
+      ;
+    if (j == npages)
+      return i;
+    i += j;
+  }
+  return 0;
+}
+
+
+static void* arena_alloc_pages(arena_t* a, size_t npages, page_kind_t kind) {
+  chunk_t* ch;
+  size_t start = 0;
+  size_t i;
+
+  for (ch = a->chunks; ch != NULL; ch = ch->next) {
+    if (ch->free_pages >= npages && (start = chunk_find_pages(ch, npages)) > 0)
+      break;
+  }
+  if (ch == NULL) {
+    if ((ch = arena_new_chunk(a)) == NULL)
+      return NULL;
+    start = HDR_PAGES;
+  }
+
+  if (ch->free_pages == CHUNK_PAGES - HDR_PAGES)
+    a->num_empty_chunks--;
+  ch->free_pages -= npages;
+  for (i = start; i < start + npages; i++) {
+    ch->page_kind[i] = kind;
+    ch->run_start[i] = start;
+  }
+  ch->run_pages[start] = npages;
+  return (char*) ch + start * AR_PAGE_SIZE;
+}
+
+
+static void arena_free_pages(arena_t* a, chunk_t* ch, size_t start) {
+  size_t npages = ch->run_pages[start];
+  chunk_t** pp;
+
+  memset(&ch->page_kind[start], PAGE_FREE, npages);
+  ch->free_pages += npages;
+  if (ch->free_pages < CHUNK_PAGES - HDR_PAGES)
+    return;
+
+  //
+  // Keep one empty chunk around so that an arena hovering at a chunk
+  // boundary doesn't keep getting and releasing chunks.
+  //
+  if (a->num_empty_chunks == 0) {
+    a->num_empty_chunks++;
+    return;
+  }
+  for (pp = &a->chunks; *pp != ch; pp = &(*pp)->next)
+    ;
+  *pp = ch->next;
+  chunks_free(ch, 1);
+}
+
+
+//
+// Small objects.  The caller holds the arena lock.
+//
+static void bin_insert(arena_t* a, run_t* r) {
+  r->prev = NULL;
+  r->next = a->bins[r->cls];
+  if (r->next != NULL)
+    r->next->prev = r;
+  a->bins[r->cls] = r;
+}
+
+
+static void bin_remove(arena_t* a, run_t* r) {
+  if (r->prev != NULL)
+    r->prev->next = r->next;
+  else
+    a->bins[r->cls] = r->next;
+  if (r->next != NULL)
+    r->next->prev = r->prev;
+}
+
+
+static void* arena_alloc_small(arena_t* a, int c) {
+  run_t* r;
+  void* p;
+
+  pthread_mutex_lock(&a->lock);
+  if ((r = a->bins[c]) == NULL) {
+    r = (run_t*) arena_alloc_pages(a, class_pages[c], PAGE_SMALL);
+    if (r == NULL) {
+      pthread_mutex_unlock(&a->lock);
+      return NULL;
+    }
+    r->free_list = NULL;
+    r->nobjs = (class_pages[c] * AR_PAGE_SIZE - RUN_HDR_SIZE) / class_size[c];
+    r->nfree = r->nobjs;
+    r->next_fresh = 0;
+    r->cls = c;
+    bin_insert(a, r);
+  }
+
+  if (r->free_list != NULL) {
+    p = r->free_list;
+    r->free_list = *(void**) p;
+  } else {
+    p = (char*) r + RUN_HDR_SIZE + (size_t) r->next_fresh++ * class_size[c];
+  }
+  if (--r->nfree == 0)
+    bin_remove(a, r);
+  pthread_mutex_unlock(&a->lock);
+  return p;
+}
+
+
+static void arena_free_small(arena_t* a, chunk_t* ch, size_t start, void* p) {
+  run_t* r = (run_t*) ((char*) ch + start * AR_PAGE_SIZE);
+
+  *(void**) p = r->free_list;
+  r->free_list = p;
+  if (r->nfree++ == 0) {
+    bin_insert(a, r);
+  } else if (r->nfree == r->nobjs
+             && (r->prev != NULL || r->next != NULL)) {
+    // Empty, and not the only run for its class: give the pages back.
+    bin_remove(a, r);
+    arena_free_pages(a, ch, start);
+  }
+}
+
+
+static arena_t* get_arena(void) {
+  arena_t* a = CHPL_TLS_GET(thread_arena);
+
+  if (a == NULL) {
+    int i = __atomic_fetch_add(&next_arena, 1, __ATOMIC_RELAXED);
+    a = &arenas[i % num_arenas];
+    CHPL_TLS_SET(thread_arena, a);
+  }
+  return a;
+}
+
+
+static size_t usable_size(void* p) {
+  chunk_t* ch = CHUNK_OF(p);
+  size_t page;
+
+  if (ch->arena == NULL)
+    return ch->nchunks * CHUNK_SIZE - AR_PAGE_SIZE;
+  page = PAGE_OF(ch, p);
+  if (ch->page_kind[page] == PAGE_SMALL) {
+    run_t* r = (run_t*) ((char*) ch + ch->run_start[page] * AR_PAGE_SIZE);
+    return class_size[r->cls];
+  }
+  return ch->run_pages[page] * AR_PAGE_SIZE;
+}
+
+
+static void* huge_alloc(size_t size, chpl_bool* fresh) {
+  size_t n = (size + AR_PAGE_SIZE + CHUNK_SIZE - 1) / CHUNK_SIZE;
+  chunk_t* ch;
+
+  if (size > SIZE_MAX - AR_PAGE_SIZE - CHUNK_SIZE)
+    return NULL;
+  if ((ch = (chunk_t*) chunks_alloc(n, fresh)) == NULL)
+    return NULL;
+  ch->arena = NULL;
+  ch->nchunks = n;
+  return (char*) ch + AR_PAGE_SIZE;
+}
+
+
+static void* arena_malloc(size_t size, chpl_bool* fresh) {
+  arena_t* a;
+  void* p;
+
+  *fresh = false;
+  if (size <= MAX_SMALL)
+    return arena_alloc_small(get_arena(), size_class[(size + ALIGNMENT - 1)
+                                                    / ALIGNMENT]);
+  if (size > MAX_LARGE)
+    return huge_alloc(size, fresh);
+
+  a = get_arena();
+  pthread_mutex_lock(&a->lock);
+  p = arena_alloc_pages(a, (size + AR_PAGE_SIZE - 1) >> AR_PAGE_SHIFT,
+                        PAGE_LARGE);
+  pthread_mutex_unlock(&a->lock);
+  return p;
+}
+
+
+void* chpl_arena_malloc(size_t size) {
+  chpl_bool fresh;
+  return arena_malloc(size, &fresh);
+}
+
+
+void* chpl_arena_calloc(size_t n, size_t size) {
+  size_t total = n * size;
+  chpl_bool fresh;
+  void* p;
+
+  if (size != 0 && total / size != n)
+    return NULL;
+  if ((p = arena_malloc(total, &fresh)) != NULL && !fresh)
+    memset(p, 0, total);
+  return p;
+}
+
+
+void* chpl_arena_realloc(void* ptr, size_t size) {
+  size_t old_size;
+  void* p;
+
+  if (ptr == NULL)
+    return chpl_arena_malloc(size);
+
+  //
+  // Stay put if the new size still fits and wouldn't waste more than
+  // half of the block.
+  //
+  old_size = usable_size(ptr);
+  if (size <= old_size && size > old_size / 2)
+    return ptr;
+
+  if ((p = chpl_arena_malloc(size)) == NULL)
+    return NULL;
+  memcpy(p, ptr, (size < old_size) ? size : old_size);
+  chpl_arena_free(ptr);
+  return p;
+}
+
+
+void chpl_arena_free(void* ptr) {
+  chunk_t* ch;
+  arena_t* a;
+  size_t start;
+
+  if (ptr == NULL)
+    return;
+
+  ch = CHUNK_OF(ptr);
+  if ((a = ch->arena) == NULL) {
+    chunks_free(ch, ch->nchunks);
+    return;
+  }
+
+  pthread_mutex_lock(&a->lock);
+  start = ch->run_start[PAGE_OF(ch, ptr)];
+  if (ch->page_kind[start] == PAGE_SMALL)
+    arena_free_small(a, ch, start, ptr);
+  else
+    arena_free_pages(a, ch, start);
+  pthread_mutex_unlock(&a->lock);
+}
+
+
+size_t chpl_arena_usable_size(void* ptr) {
+  return (ptr == NULL) ? 0 : usable_size(ptr);
+}
+
+
+static void init_heap(void* base, size_t size) {
+  uintptr_t lo = ((uintptr_t) base + CHUNK_SIZE - 1) & ~(CHUNK_SIZE - 1);
+  uintptr_t hi = ((uintptr_t) base + size) & ~(CHUNK_SIZE - 1);
+  size_t map_chunks;
+
+  if (hi <= lo + 2 * CHUNK_SIZE)
+    chpl_internal_error("shared heap is too small for CHPL_MEM=arena");
+
+  heap_chunks = (char*) lo;
+  heap_nchunks = (hi - lo) / CHUNK_SIZE;
+  heap_chunk_used = (uint8_t*) heap_chunks;
+  map_chunks = (heap_nchunks + CHUNK_SIZE - 1) / CHUNK_SIZE;
+  memset(heap_chunk_used, 0, heap_nchunks);
+  memset(heap_chunk_used, 1, map_chunks);
+  heap_hint = map_chunks;
+}
+
+
+void chpl_mem_layerInit(void) {
+  void*  heap_base;
+  size_t heap_size;
+  char*  p;
+  size_t s;
+  int    i;
+
+  chpl_comm_desired_shared_heap(&heap_base, &heap_size);
+  if (heap_base != NULL && heap_size != 0)
+    init_heap(heap_base, heap_size);
+
+  for (i = 0, s = 0; i < NUM_CLASSES; i++) {
+    size_t pages = (32 * class_size[i] + AR_PAGE_SIZE - 1) / AR_PAGE_SIZE;
+    class_pages[i] = (pages > MAX_RUN_PAGES) ? MAX_RUN_PAGES : pages;
+    for (; s <= class_size[i] / ALIGNMENT; s++)
+      size_class[s] = i;
+  }
+
+  //
+  // By default use an arena per CPU, so that threads rarely share one.
+  //
+  if ((p = getenv("CHPL_RT_MEM_ARENAS")) == NULL
+      || sscanf(p, "%d", &num_arenas) != 1)
+    num_arenas = (int) sysconf(_SC_NPROCESSORS_ONLN);
+  if (num_arenas < 1)
+    num_arenas = 1;
+  if (num_arenas > MAX_ARENAS)
+    num_arenas = MAX_ARENAS;
+  for (i = 0; i < num_arenas; i++)
+    pthread_mutex_init(&arenas[i].lock, NULL);
+
+  CHPL_TLS_INIT(thread_arena);
+}
+
+
+void chpl_mem_layerExit(void) { }
@@ -19,21 +19,240 @@
 
 #include "chplrt.h"
 
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdint.h>
 #include <string.h>
 
 #include "chpl-comm.h"
+#include "chpl-env.h"
 #include "chpl-mem.h"
+#include "chpl-thread-local-storage.h"
 #include "chplmemtrack.h"
 #include "chpltypes.h"
 #include "error.h"
 #include "dlmalloc.h"
 
+//
+// These are provided by dlmalloc but not declared in its header.
+//
+size_t mspace_usable_size(void* mem);
+size_t mspace_bulk_free(mspace msp, void* array[], size_t nelem);
+
 mspace chpl_dlmalloc_heap;
 
 
+//
+// Per-thread caches.
+//
+// The mspace is shared by every thread on the locale and serializes
+// on a single lock, which makes small allocations very contended
+// when many tasks allocate at once.  To avoid that, each thread keeps
+// free lists of small blocks, one per size class.  Allocation and
+// free of small blocks normally touch only the calling thread's
+// lists.  Empty lists are refilled with a batch of blocks carved from
+// the mspace in one locked call, and a list that grows too long hands
+// a batch back to the mspace, again in one locked call.
+//
+// Cached blocks are ordinary mspace chunks, so they can be passed to
+// mspace_realloc() or mspace_free() no matter which thread holds them.
+// A freed block's size class comes from its usable size, rounded down
+// to a class boundary, so any block on a list is at least as big as
+// the class size.  Setting CHPL_RT_MEM_THREAD_CACHE=0 turns the caches
+// off and sends everything directly to the mspace.
+//
+#define TC_GRAIN        16
+#define TC_NUM_CLASSES  32
+#define TC_MAX_SIZE     (TC_GRAIN * TC_NUM_CLASSES)
+#define TC_MAX_BATCH    64
+#define TC_MIN_BATCH    8
+#define TC_BATCH_BYTES  4096
+
+typedef struct tc_block_s {
+  struct tc_block_s* next;
+} tc_block_t;
+
+typedef struct {
+  tc_block_t* head[TC_NUM_CLASSES];
+  int count[TC_NUM_CLASSES];
+} thread_cache_t;
+
+static chpl_bool use_thread_cache = false;
+
+// As in chpl-cache.c, we reach the per-thread cache through
+// __thread if possible, and also register it with a pthread key
+// so that we can flush it back to the mspace when the thread exits.
+CHPL_TLS_DECL(thread_cache_t*, thread_cache);
+static pthread_key_t thread_cache_exit_key;
+
+
+static inline int tc_class_size(int c) {
+  return (c + 1) * TC_GRAIN;
+}
+
+
+static inline int tc_batch(int c) {
+  int n = TC_BATCH_BYTES / tc_class_size(c);
+  if (n < TC_MIN_BATCH)
+    n = TC_MIN_BATCH;
+  if (n > TC_MAX_BATCH)
+    n = TC_MAX_BATCH;
+  return n;
+}
+
+
+static void tc_release(thread_cache_t* tc, int c, int n) {
+  void* blocks[TC_MAX_BATCH];
+  int i;
+
+  while (n > 0) {
+    int m = (n < TC_MAX_BATCH) ? n : TC_MAX_BATCH;
+    for (i = 0; i < m; i++) {
+      tc_block_t* b = tc->head[c];
+      tc->head[c] = b->next;
+      blocks[i] = b;
+    }
+    tc->count[c] -= m;
+    n -= m;
+    mspace_bulk_free(chpl_dlmalloc_heap, blocks, m);
+  }
+}
+
+
+static void tc_destroy(void* arg) {
+  thread_cache_t* tc = (thread_cache_t*) arg;
+  int c;
+
+  // Frees done by later thread-exit destructors must not find this.
+  CHPL_TLS_SET(thread_cache, NULL);
+  for (c = 0; c < TC_NUM_CLASSES; c++)
+    tc_release(tc, c, tc->count[c]);
+  mspace_free(chpl_dlmalloc_heap, tc);
+}
+
+
+static thread_cache_t* tc_get(void) {
+  thread_cache_t* tc = CHPL_TLS_GET(thread_cache);
+  if (tc == NULL) {
+    tc = (thread_cache_t*) mspace_calloc(chpl_dlmalloc_heap, 1, sizeof(*tc));
+    if (tc == NULL)
+      return NULL;
+    CHPL_TLS_SET(thread_cache, tc);
+    pthread_setspecific(thread_cache_exit_key, tc);
+  }
+  return tc;
+}
+
+
+static void tc_refill(thread_cache_t* tc, int c) {
+  size_t sizes[TC_MAX_BATCH];
+  void*  blocks[TC_MAX_BATCH];
+  int    n = tc_batch(c);
+  int    i;
+
+  for (i = 0; i < n; i++)
+    sizes[i] = tc_class_size(c);
+  if (mspace_independent_comalloc(chpl_dlmalloc_heap, n, sizes, blocks)
+      == NULL)
+    return;
+  for (i = n - 1; i >= 0; i--) {
+    tc_block_t* b = (tc_block_t*) blocks[i];
+    b->next = tc->head[c];
+    tc->head[c] = b;
+  }
+  tc->count[c] += n;
+}
+
+
+static inline void* tc_alloc(size_t size) {
+  thread_cache_t* tc;
+  tc_block_t* b;
+  int c;
+
+  if (!use_thread_cache || size > TC_MAX_SIZE)
+    return NULL;
+  if ((tc = tc_get()) == NULL)
+    return NULL;
+  c = (size == 0) ? 0 : (int) ((size - 1) / TC_GRAIN);
+  if (tc->head[c] == NULL) {
+    tc_refill(tc, c);
+    if (tc->head[c] == NULL)
+      return NULL;
+  }
+  b = tc->head[c];
+  tc->head[c] = b->next;
+  tc->count[c]--;
+  return b;
+}
+
+
+static inline chpl_bool tc_free(void* ptr) {
+  thread_cache_t* tc;
+  tc_block_t* b;
+  size_t usable;
+  int c;
+
+  if (!use_thread_cache)
+    return false;
+  usable = mspace_usable_size(ptr);
+  if (usable < TC_GRAIN || usable > TC_MAX_SIZE + TC_GRAIN - 1)
+    return false;
+  if ((tc = tc_get()) == NULL)
+    return false;
+  c = (int) (usable / TC_GRAIN) - 1;
+  b = (tc_block_t*) ptr;
+  b->next = tc->head[c];
+  tc->head[c] = b;
+  if (++tc->count[c] > 2 * tc_batch(c))
+    tc_release(tc, c, tc_batch(c));
+  return true;
+}
+
+
+void* chpl_dlmalloc_calloc(size_t n, size_t size) {
+  size_t total = n * size;
+  void* p;
+
+  if (size != 0 && total / size != n)
+    return NULL;
+  if ((p = tc_alloc(total)) != NULL) {
+    memset(p, 0, total);
+    return p;
+  }
+  return mspace_calloc(chpl_dlmalloc_heap, n, size);
+}
+
+
+void* chpl_dlmalloc_malloc(size_t size) {
+  void* p;
+
+  if ((p = tc_alloc(size)) != NULL)
+    return p;
+  return mspace_malloc(chpl_dlmalloc_heap, size);
+}
+
+
+void* chpl_dlmalloc_realloc(void* ptr, size_t size) {
+  if (ptr == NULL)
+    return chpl_dlmalloc_malloc(size);
+  return mspace_realloc(chpl_dlmalloc_heap, ptr, size);
+}
+
+
+void chpl_dlmalloc_free(void* ptr) {
+  if (ptr == NULL)
+    return;
+  if (!tc_free(ptr))
+    mspace_free(chpl_dlmalloc_heap, ptr);
+}
+
+
+size_t chpl_dlmalloc_usable_size(void* ptr) {
+  return mspace_usable_size(ptr);
+}
+
+
 void chpl_mem_layerInit(void) {
   void*  heap_base;
   size_t heap_size;
@@ -43,9 +262,13 @@ void chpl_mem_layerInit(void) {
     chpl_dlmalloc_heap = create_mspace(0, 1);
   else
     chpl_dlmalloc_heap = create_mspace_with_base(heap_base, heap_size, 1);
+
+  if (chpl_env_rt_get_bool("CHPL_RT_MEM_THREAD_CACHE", true)) {
+    CHPL_TLS_INIT(thread_cache);
+    if (pthread_key_create(&thread_cache_exit_key, tc_destroy) == 0)
+      use_thread_cache = true;
+  }
 }
 
 
 void chpl_mem_layerExit(void) { }
-
-
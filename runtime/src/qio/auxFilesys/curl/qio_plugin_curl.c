@@ -18,6 +18,8 @@
  */
 
 #include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
 #ifndef CHPL_RT_UNIT_TEST
 #include "chplrt.h"
 #endif
@@ -32,6 +34,41 @@ struct str_t {
   size_t size;
 };
 
+// Reads from a URL that accepts byte ranges go through a cache of fixed
+// size blocks kept with the handle. On a miss we fetch the missing blocks
+// for the whole read along with some readahead, coalescing neighbouring
+// blocks into a few range requests which are run in parallel on a curl
+// multi handle. The handle's lock is not held during a fetch: the blocks
+// being fetched are marked, and a read that needs one of them waits for
+// it while reads of other cached blocks go ahead. These are tuned with
+// environment variables:
+//   CHPL_RT_QIO_CURL_BLOCK_SIZE   bytes per block
+//   CHPL_RT_QIO_CURL_CACHE_BLOCKS blocks cached per handle (0 disables the cache)
+//   CHPL_RT_QIO_CURL_READAHEAD    blocks fetched beyond the end of a read
+//   CHPL_RT_QIO_CURL_PARALLEL     most range requests in flight for one fetch
+#define CURL_DEFAULT_BLOCK_SIZE (256*1024)
+#define CURL_DEFAULT_CACHE_BLOCKS 32
+#define CURL_DEFAULT_READAHEAD 4
+#define CURL_DEFAULT_PARALLEL 4
+
+struct curl_block_t {
+  int64_t   block;     // index of the block held here, or -1
+  char*     data;
+  uint64_t  last_used;
+  int       fetching;  // data is being fetched; wait for it
+};
+
+// One range request filling a run of consecutive blocks
+struct curl_range_t {
+  CURL*     curl;
+  struct curl_block_t** slots; // blocks to fill, in order
+  size_t    block_size;
+  int64_t   start;     // offset of the first byte
+  size_t    len;       // number of bytes asked for
+  size_t    received;
+  CURLcode  result;
+};
+
 // Since a curl handle does not hold where it has read to, we need to do this here.
 // As well, since we can many times request byte-ranges (for HTTP/HTTPS) we keep
 // track of that here as well.
@@ -45,6 +82,18 @@ struct curl_handle {
   //       channels for Curl.
   size_t      current_offset; // The current offset in the file
   int         seekable;       // Can we request byteranges from this URL?
+
+  // block cache, used when seekable and length != -1
+  qio_lock_t  lock;           // protects the cache and multi, but is not
+                              // held while fetching
+  CURLM*      multi;          // for fetching ranges in parallel; reuses
+                              // connections. NULL while a fetch has it.
+  struct curl_block_t* cache;
+  int         cache_blocks;
+  size_t      block_size;
+  int         readahead;
+  int         parallel;
+  uint64_t    tick;           // for least recently used replacement
 };
 
 // Since the callback is called many times from a call to curl_easy_perform, and
@@ -87,7 +136,7 @@ size_t buf_writer(char* ptr_data, size_t size, size_t nmemb, void* userdata)
   // single iovbuf. So we need to go from one iovbuf to the other
   while (realsize > ret->vec[ret->curr].iov_len*size - ret->amt_read)  {
     // This cast to char* is to get rid "subscript of pointer to incomplete type" warnings
-    chpl_memcpy(&(((char*)ret->vec[ret->curr].iov_base)[ret->amt_read]), ptr_data, ret->vec[ret->curr].iov_len*size - ret->amt_read);
+    qio_memcpy(&(((char*)ret->vec[ret->curr].iov_base)[ret->amt_read]), ptr_data, ret->vec[ret->curr].iov_len*size - ret->amt_read);
     ret->total_read += (ret->vec[ret->curr].iov_len*size - ret->amt_read);
     realsize -= ret->vec[ret->curr].iov_len*size - ret->amt_read;
     ptr_data = &(ptr_data[(ret->vec[ret->curr].iov_len*size - ret->amt_read)]);
@@ -103,7 +152,7 @@ size_t buf_writer(char* ptr_data, size_t size, size_t nmemb, void* userdata)
   // The amount of data that we have been given by curl is <= to the amount of space
   // that we have left in this iovbuf. So we can simply read it all in.
   if (realsize <= (ret->vec[ret->curr].iov_len*size - ret->amt_read)) {
-    chpl_memcpy(&(((char*)ret->vec[ret->curr].iov_base)[ret->amt_read]), ptr_data, realsize);
+    qio_memcpy(&(((char*)ret->vec[ret->curr].iov_base)[ret->amt_read]), ptr_data, realsize);
     ret->total_read += realsize;
     ret->amt_read += realsize;
     // We have fully populated this iovbuf
@@ -136,7 +185,7 @@ size_t read_data(void *ptr, size_t size, size_t nmemb, void *userp)
 
   // We can upload more than one iovbuf at once, so do it.
   while (realsize > ret->vec[ret->curr].iov_len*size - ret->amt_read)  {
-    chpl_memcpy(ptr, &(((char*)ret->vec[ret->curr].iov_base)[ret->amt_read]), ret->vec[ret->curr].iov_len*size - ret->amt_read);
+    qio_memcpy(ptr, &(((char*)ret->vec[ret->curr].iov_base)[ret->amt_read]), ret->vec[ret->curr].iov_len*size - ret->amt_read);
     ret->total_read += (ret->vec[ret->curr].iov_len*size - ret->amt_read);
     realsize -= ret->vec[ret->curr].iov_len*size - ret->amt_read;
     ptr = &(((char*)ptr)[(ret->vec[ret->curr].iov_len*size - ret->amt_read)]);
@@ -151,7 +200,7 @@ size_t read_data(void *ptr, size_t size, size_t nmemb, void *userp)
   // The amount of data that we need to hand to curl is <= the amount of space
   // that we have left in this iovbuf, so we have to be careful not to exceed it
   if (realsize <= (ret->vec[ret->curr].iov_len*size - ret->amt_read)) {
-    chpl_memcpy(ptr, &(((char*)ret->vec[ret->curr].iov_base)[ret->amt_read]), realsize);
+    qio_memcpy(ptr, &(((char*)ret->vec[ret->curr].iov_base)[ret->amt_read]), realsize);
     ret->total_read += realsize;
     ret->amt_read += realsize;
     // We have fully read this iovbuf
@@ -177,13 +226,334 @@ size_t chpl_curl_write_string(void *contents, size_t size, size_t nmemb, void *u
     return 0;
   }
 
-  chpl_memcpy(&(str->mem[str->size]), contents, realsize);
+  qio_memcpy(&(str->mem[str->size]), contents, realsize);
   str->size += realsize;
   str->mem[str->size] = 0;
 
   return realsize;
 }
 
+static
+int curl_getenv_int(const char* name, int def, int min, int max)
+{
+  const char* env = getenv(name);
+  int v;
+
+  if( ! env || ! *env ) return def;
+  v = atoi(env);
+  if( v < min || v > max ) return def;
+  return v;
+}
+
+// Curl write callback for a range request.
+static
+size_t range_writer(char* ptr_data, size_t size, size_t nmemb, void* userdata)
+{
+  struct curl_range_t* r = (struct curl_range_t*) userdata;
+  size_t realsize = size*nmemb;
+  size_t done = 0;
+  size_t b, within, amt;
+
+  while (done < realsize && r->received < r->len) {
+    b = r->received / r->block_size;
+    within = r->received % r->block_size;
+    amt = r->block_size - within;
+    if (amt > realsize - done) amt = realsize - done;
+    if (amt > r->len - r->received) amt = r->len - r->received;
+    qio_memcpy(r->slots[b]->data + within, ptr_data + done, amt);
+    done += amt;
+    r->received += amt;
+  }
+
+  // More than we asked for (the server ignored the range), so stop.
+  if (done < realsize)
+    return 0;
+  return realsize;
+}
+
+static
+struct curl_block_t* curl_cache_find(curl_handle* h, int64_t block)
+{
+  int i;
+  for (i = 0; i < h->cache_blocks; i++) {
+    if (h->cache[i].block == block) {
+      h->cache[i].last_used = h->tick;
+      return &h->cache[i];
+    }
+  }
+  return NULL;
+}
+
+// Pick the least recently used block to replace, but never one that was
+// used during this fetch (which all have last_used == tick) or one that
+// is still being fetched. Returns NULL if there is no such block.
+static
+struct curl_block_t* curl_cache_victim(curl_handle* h)
+{
+  struct curl_block_t* victim = NULL;
+  int i;
+  for (i = 0; i < h->cache_blocks; i++) {
+    if (h->cache[i].last_used == h->tick) continue;
+    if (h->cache[i].fetching) continue;
+    if (h->cache[i].block == -1) return &h->cache[i];
+    if (victim == NULL || h->cache[i].last_used < victim->last_used)
+      victim = &h->cache[i];
+  }
+  return victim;
+}
+
+// Wait for another task to finish fetching a block. Call with h->lock
+// held; it is dropped while waiting, so look the block up again after.
+static
+void curl_cache_wait(curl_handle* h)
+{
+  qio_unlock(&h->lock);
+  chpl_task_yield();
+  qio_lock(&h->lock);
+}
+
+// Fetch those of blocks first..first+nblocks-1 (nblocks <= cache_blocks)
+// that are neither in the cache nor being fetched by another task.
+// Call with h->lock held. The missing blocks are marked as being fetched
+// and the lock is dropped while curl runs, so other tasks can read
+// other blocks in the meantime; the lock is held again on return.
+// Blocks that could not be given a slot are left alone; the caller
+// waits for a slot and tries again.
+static
+qioerr curl_fetch_blocks(curl_handle* h, int64_t first, int64_t nblocks)
+{
+  struct curl_block_t** slots = NULL;
+  struct curl_range_t* ranges = NULL;
+  CURLM* multi = NULL;
+  int64_t nmissing = 0;
+  int64_t per_range;
+  int64_t end = h->length;
+  int nranges = 0;
+  int running = 0;
+  int64_t i;
+  int j;
+  char range[64];
+  long code;
+  CURLMsg* msg;
+  int msgs_left;
+  qioerr err_out = 0;
+
+  h->tick++;
+
+  slots = (struct curl_block_t**) qio_calloc(nblocks, sizeof(struct curl_block_t*));
+  ranges = (struct curl_range_t*) qio_calloc(nblocks, sizeof(struct curl_range_t));
+  if (slots == NULL || ranges == NULL) {
+    err_out = QIO_ENOMEM;
+    goto done;
+  }
+
+  // Find (or make room for) each block, and claim the missing ones
+  for (i = 0; i < nblocks; i++) {
+    if (curl_cache_find(h, first + i) == NULL) {
+      struct curl_block_t* slot = curl_cache_victim(h);
+      if (slot == NULL) {
+        nblocks = i;
+        break;
+      }
+      if (slot->data == NULL) {
+        slot->data = (char*) qio_malloc(h->block_size);
+        if (slot->data == NULL) {
+          err_out = QIO_ENOMEM;
+          goto done;
+        }
+      }
+      slot->block = first + i;
+      slot->last_used = h->tick;
+      slot->fetching = 1;
+      slots[i] = slot;
+      nmissing++;
+    }
+  }
+
+  if (nmissing == 0)
+    goto done;
+
+  // Use the handle's multi handle unless another fetch has it
+  multi = h->multi;
+  h->multi = NULL;
+  if (multi == NULL) {
+    multi = curl_multi_init();
+    if (multi == NULL) {
+      QIO_GET_CONSTANT_ERROR(err_out, ENOMEM, "Unable to create curl multi handle");
+      goto done;
+    }
+  }
+
+  // Coalesce runs of missing blocks into range requests, splitting them
+  // so that up to h->parallel requests share the work.
+  per_range = (nmissing + h->parallel - 1) / h->parallel;
+  for (i = 0; i < nblocks; i++) {
+    int64_t start = (first + i) * (int64_t) h->block_size;
+    size_t len = (end - start < (int64_t) h->block_size) ? (size_t) (end - start) : h->block_size;
+    if (slots[i] == NULL) continue;
+    if (nranges == 0 || slots[i-1] == NULL ||
+        ranges[nranges-1].len >= (size_t) per_range * h->block_size) {
+      ranges[nranges].slots = &slots[i];
+      ranges[nranges].block_size = h->block_size;
+      ranges[nranges].start = start;
+      ranges[nranges].len = 0;
+      nranges++;
+    }
+    ranges[nranges-1].len += len;
+  }
+
+  for (j = 0; j < nranges; j++) {
+    struct curl_range_t* r = &ranges[j];
+    r->curl = curl_easy_duphandle(h->curl);
+    if (r->curl == NULL) {
+      QIO_GET_CONSTANT_ERROR(err_out, ENOMEM, "Unable to create curl handle");
+      goto done;
+    }
+    snprintf(range, sizeof(range), "%lld-%lld",
+             (long long) r->start, (long long) (r->start + r->len - 1));
+    curl_easy_setopt(r->curl, CURLOPT_RESUME_FROM_LARGE, (curl_off_t) 0);
+    curl_easy_setopt(r->curl, CURLOPT_RANGE, range);
+    curl_easy_setopt(r->curl, CURLOPT_NOBODY, 0L);
+    curl_easy_setopt(r->curl, CURLOPT_UPLOAD, 0L);
+    curl_easy_setopt(r->curl, CURLOPT_WRITEFUNCTION, range_writer);
+    curl_easy_setopt(r->curl, CURLOPT_WRITEDATA, r);
+    curl_easy_setopt(r->curl, CURLOPT_PRIVATE, r);
+    r->result = CURLE_OK;
+    curl_multi_add_handle(multi, r->curl);
+  }
+
+  qio_unlock(&h->lock);
+
+  do {
+    if (curl_multi_perform(multi, &running) != CURLM_OK) break;
+    if (running) curl_multi_wait(multi, NULL, 0, 1000, NULL);
+  } while (running);
+
+  while ((msg = curl_multi_info_read(multi, &msgs_left)) != NULL) {
+    struct curl_range_t* r = NULL;
+    if (msg->msg != CURLMSG_DONE) continue;
+    curl_easy_getinfo(msg->easy_handle, CURLINFO_PRIVATE, (char**) &r);
+    if (r) r->result = msg->data.result;
+  }
+
+  for (j = 0; j < nranges && err_out == 0; j++) {
+    struct curl_range_t* r = &ranges[j];
+    code = 0;
+    curl_easy_getinfo(r->curl, CURLINFO_RESPONSE_CODE, &code);
+    // A server sending the whole file for a range starting at 0 is fine.
+    if (r->result != CURLE_OK && !(r->result == CURLE_WRITE_ERROR && r->start == 0)) {
+      QIO_GET_CONSTANT_ERROR(err_out, EIO, "Unable to read range from URL");
+    } else if (code == 200 && r->start != 0) {
+      QIO_GET_CONSTANT_ERROR(err_out, EIO, "URL does not support byte ranges");
+    } else if (r->received != r->len) {
+      QIO_GET_CONSTANT_ERROR(err_out, EIO, "Short read from URL");
+    }
+  }
+
+  for (j = 0; j < nranges; j++) {
+    curl_multi_remove_handle(multi, ranges[j].curl);
+    curl_easy_cleanup(ranges[j].curl);
+    ranges[j].curl = NULL;
+  }
+
+  // Ignore an error from qio_lock; we have to publish the blocks anyway.
+  qio_lock(&h->lock);
+
+done:
+  // Publish the blocks, or give the slots back if the fetch failed
+  if (slots) {
+    for (i = 0; i < nblocks; i++) {
+      if (slots[i]) {
+        if (err_out) slots[i]->block = -1;
+        slots[i]->fetching = 0;
+      }
+    }
+  }
+  if (ranges) {
+    for (j = 0; j < nranges; j++) {
+      if (ranges[j].curl) {
+        curl_multi_remove_handle(multi, ranges[j].curl);
+        curl_easy_cleanup(ranges[j].curl);
+      }
+    }
+  }
+  if (multi) {
+    if (h->multi == NULL) h->multi = multi;
+    else curl_multi_cleanup(multi);
+  }
+  qio_free(ranges);
+  qio_free(slots);
+  return err_out;
+}
+
+// preadv through the block cache
+static
+qioerr curl_preadv_cached(curl_handle* h, const struct iovec *vector, int count, off_t offset, ssize_t* num_read_out)
+{
+  int64_t want = sys_iov_total_bytes(vector, count);
+  int64_t pos = offset;
+  int64_t block, last, last_block;
+  ssize_t total = 0;
+  size_t iov_off = 0;
+  size_t within, avail, room, n;
+  struct curl_block_t* slot;
+  qioerr err_out = 0;
+  int i = 0;
+
+  err_out = qio_lock(&h->lock);
+  if (err_out) return err_out;
+
+  STARTING_SLOW_SYSCALL;
+
+  h->tick++;
+  last_block = (h->length - 1) / (int64_t) h->block_size;
+  while (i < count && pos < h->length) {
+    room = vector[i].iov_len - iov_off;
+    if (room == 0) {
+      i++;
+      iov_off = 0;
+      continue;
+    }
+
+    block = pos / h->block_size;
+    within = pos % h->block_size;
+    slot = curl_cache_find(h, block);
+    if (slot == NULL) {
+      last = (offset + want - 1) / (int64_t) h->block_size + h->readahead;
+      if (last > last_block) last = last_block;
+      if (last - block + 1 > h->cache_blocks) last = block + h->cache_blocks - 1;
+      err_out = curl_fetch_blocks(h, block, last - block + 1);
+      if (err_out) break;
+      slot = curl_cache_find(h, block);
+    }
+    if (slot == NULL || slot->fetching) {
+      // Another task is fetching it, or every slot is busy
+      curl_cache_wait(h);
+      h->tick++;
+      continue;
+    }
+
+    avail = h->block_size - within;
+    if ((int64_t) avail > h->length - pos) avail = h->length - pos;
+    n = (avail < room) ? avail : room;
+    qio_memcpy((char*) vector[i].iov_base + iov_off, slot->data + within, n);
+    pos += n;
+    total += n;
+    iov_off += n;
+  }
+
+  if (err_out == 0 && total == 0 && want != 0)
+    err_out = qio_int_to_err(EEOF);
+
+  *num_read_out = total;
+
+  DONE_SLOW_SYSCALL;
+
+  qio_unlock(&h->lock);
+
+  return err_out;
+}
+
 static
 qioerr  curl_preadv_internal(void* file, const struct iovec *vector, int count, off_t offset, ssize_t* num_read_out, void* fs)
 {
@@ -193,6 +563,16 @@ qioerr  curl_preadv_internal(void* file, const struct iovec *vector, int count,
   struct curl_iovec_t write_vec;
   curl_handle* local_handle = to_curl_handle(file);
 
+  if (local_handle->cache_blocks > 0) {
+    if (offset != -1)
+      return curl_preadv_cached(local_handle, vector, count, offset, num_read_out);
+    // readv continues from where the last one stopped
+    err_out = curl_preadv_cached(local_handle, vector, count, local_handle->current_offset, &got_total);
+    local_handle->current_offset += got_total;
+    *num_read_out = got_total;
+    return err_out;
+  }
+
   STARTING_SLOW_SYSCALL;
 
   got_total = 0;
@@ -341,6 +721,7 @@ qioerr curl_open(void** fd, const char* path, int* flags, mode_t mode, qio_hint_
 {
   qioerr err_out = 0;
   int rc = 0;
+  int i;
   // Curl expects (NEEDS) this to be a double
   double filelength;
   curl_handle* fl = (curl_handle*)qio_calloc(sizeof(curl_handle), 1);
@@ -393,10 +774,31 @@ qioerr curl_open(void** fd, const char* path, int* flags, mode_t mode, qio_hint_
   if (to_curl_handle(fl)->seekable)
     *flags |= QIO_FDFLAG_SEEKABLE;
 
+  // Set up the block cache when we can request byte ranges of a known length
+  if (to_curl_handle(fl)->seekable && to_curl_handle(fl)->length != -1) {
+    fl->block_size = curl_getenv_int("CHPL_RT_QIO_CURL_BLOCK_SIZE", CURL_DEFAULT_BLOCK_SIZE, 4096, 1 << 30);
+    fl->cache_blocks = curl_getenv_int("CHPL_RT_QIO_CURL_CACHE_BLOCKS", CURL_DEFAULT_CACHE_BLOCKS, 0, 1 << 16);
+    fl->readahead = curl_getenv_int("CHPL_RT_QIO_CURL_READAHEAD", CURL_DEFAULT_READAHEAD, 0, 1 << 16);
+    fl->parallel = curl_getenv_int("CHPL_RT_QIO_CURL_PARALLEL", CURL_DEFAULT_PARALLEL, 1, 64);
+    if (fl->cache_blocks > 0) {
+      fl->cache = (struct curl_block_t*) qio_calloc(fl->cache_blocks, sizeof(struct curl_block_t));
+      if (fl->cache == NULL) {
+        err_out = QIO_ENOMEM;
+        goto error;
+      }
+      for (i = 0; i < fl->cache_blocks; i++)
+        fl->cache[i].block = -1;
+      err_out = qio_lock_init(&fl->lock);
+      if (err_out) goto error;
+    }
+  }
+
   *fd = fl;
   return err_out;
 
 error:
+  if (fl->curl) curl_easy_cleanup(fl->curl);
+  qio_free(fl->cache);
   qio_free(fl);
   return err_out;
 }
@@ -405,9 +807,19 @@ static
 qioerr curl_close(void* fl, void* fs)
 {
   qioerr err_out = 0;
+  curl_handle* h = to_curl_handle(fl);
+  int i;
 
   STARTING_SLOW_SYSCALL;
-  curl_easy_cleanup(to_curl_handle(fl)->curl);
+  if (h->cache) {
+    for (i = 0; i < h->cache_blocks; i++)
+      qio_free(h->cache[i].data);
+    qio_free(h->cache);
+    qio_lock_destroy(&h->lock);
+  }
+  if (h->multi)
+    curl_multi_cleanup(h->multi);
+  curl_easy_cleanup(h->curl);
   qio_free(fl);
   DONE_SLOW_SYSCALL;
 
@@ -0,0 +1,964 @@
+/*
+ * Copyright 2004-2015 Cray Inc.
+ * Other additional copyright holders may be indicated within.
+ *
+ * The entirety of this work is licensed under the Apache License,
+ * Version 2.0 (the "License"); you may not use this file except
+ * in compliance with the License.
+ *
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string.h>
+#include <stdlib.h>
+#include <pthread.h>
+#ifndef CHPL_RT_UNIT_TEST
+#include "chplrt.h"
+#endif
+
+#include "qio_plugin_gzip.h"
+#include <zlib.h>
+
+#define to_gzip_file(f) ((gzip_file*)f)
+
+// Each block is a gzip member with a fixed 18 byte header (carrying the
+// 'BC' extra field) and the usual 8 byte CRC32/ISIZE trailer.
+#define GZIP_BLOCK_HEADER_SIZE 18
+#define GZIP_BLOCK_FOOTER_SIZE 8
+// No block may be larger than this, compressed or not.
+#define GZIP_MAX_BLOCK_SIZE 0x10000
+
+#define GZIP_CACHE_SLOTS 4
+#define GZIP_DEFAULT_THREADS 4
+#define GZIP_MAX_THREADS 64
+#define GZIP_STREAM_CHUNK (64*1024)
+
+// An empty block marks the end of a file written by this plugin (this is
+// also the end-of-file marker from BGZF). Its first 16 bytes double as
+// the header we write for every block.
+static const unsigned char gzip_eof_block[28] = {
+  0x1f, 0x8b, 0x08, 0x04, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0xff, 0x06, 0x00, 0x42, 0x43, 0x02, 0x00,
+  0x1b, 0x00, 0x03, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x00
+};
+
+typedef struct gzip_block_s {
+  int64_t  coff;  // offset of the gzip member in the file
+  int64_t  uoff;  // offset of its data in the uncompressed stream
+  uint32_t csize; // size of the gzip member
+  uint32_t usize; // size of the data it holds
+} gzip_block_t;
+
+typedef struct gzip_cache_slot_s {
+  int64_t block;       // index of the cached block, or -1
+  unsigned char* data; // its decompressed data
+} gzip_cache_slot_t;
+
+// A compressed file is opened in one of three ways:
+//  - for writing, where data is gathered into blocks which are compressed
+//    (several at a time) and appended to the file;
+//  - for reading with a block index, when every gzip member in the file
+//    has a 'BC' field. These files are seekable and can be read with
+//    preadv from many tasks at once;
+//  - for reading as a stream, for any other gzip (or zlib) file. These
+//    can only be read from the start with readv.
+struct gzip_file {
+  // The compressed file is a local file (fd) unless the gzip file was
+  // opened over another plugin, whose functions and file are kept here.
+  fd_t        fd;
+  const qio_file_functions_t* inner;
+  void*       inner_fs;
+  void*       inner_file;
+  off_t       inner_offset; // for reading it with preadv alone
+
+  char*       pathnm;
+  int         writing;
+  int         streaming;
+  qio_lock_t  lock;   // protects the cache, the stream and the write state
+  off_t       current_offset;
+
+  // reading with a block index
+  gzip_block_t* blocks;
+  int64_t     nblocks;
+  int64_t     length; // uncompressed length
+  gzip_cache_slot_t cache[GZIP_CACHE_SLOTS];
+  int         next_slot;
+
+  // reading as a stream
+  z_stream    strm;
+  unsigned char* inbuf;
+  int         in_member; // have we started inflating a member?
+  int         at_eof;    // have we read everything from fd?
+
+  // writing
+  int         nthreads; // blocks compressed at once
+  int         level;    // zlib compression level
+  unsigned char* pending; // nthreads blocks of data not yet compressed
+  size_t      pending_len;
+  unsigned char* compressed; // nthreads compressed blocks
+  int64_t     written;  // uncompressed bytes accepted so far
+};
+
+static inline
+void gzip_put16(unsigned char* p, uint32_t v)
+{
+  p[0] = v & 0xff;
+  p[1] = (v >> 8) & 0xff;
+}
+
+static inline
+void gzip_put32(unsigned char* p, uint32_t v)
+{
+  gzip_put16(p, v);
+  gzip_put16(p + 2, v >> 16);
+}
+
+static inline
+uint32_t gzip_get16(const unsigned char* p)
+{
+  return p[0] | ((uint32_t) p[1] << 8);
+}
+
+static inline
+uint32_t gzip_get32(const unsigned char* p)
+{
+  return gzip_get16(p) | (gzip_get16(p + 2) << 16);
+}
+
+// These access the compressed file, through the inner plugin if there
+// is one. Like the system calls, they return EEOF at the end of the file.
+static
+qioerr gzip_inner_pread(gzip_file* fl, void* buf, size_t len, off_t offset, ssize_t* got)
+{
+  struct iovec iov;
+
+  if( ! fl->inner ) return qio_int_to_err(sys_pread(fl->fd, buf, len, offset, got));
+
+  iov.iov_base = buf;
+  iov.iov_len = len;
+  return fl->inner->preadv(fl->inner_file, &iov, 1, offset, got, fl->inner_fs);
+}
+
+static
+qioerr gzip_inner_read(gzip_file* fl, void* buf, size_t len, ssize_t* got)
+{
+  struct iovec iov;
+  qioerr err;
+
+  if( ! fl->inner ) return qio_int_to_err(sys_read(fl->fd, buf, len, got));
+
+  iov.iov_base = buf;
+  iov.iov_len = len;
+  if( fl->inner->readv )
+    return fl->inner->readv(fl->inner_file, &iov, 1, got, fl->inner_fs);
+
+  err = fl->inner->preadv(fl->inner_file, &iov, 1, fl->inner_offset, got, fl->inner_fs);
+  if( ! err ) fl->inner_offset += *got;
+  return err;
+}
+
+static
+qioerr gzip_inner_length(gzip_file* fl, int64_t* len_out)
+{
+  struct stat stats;
+  err_t rc;
+
+  if( fl->inner ) return fl->inner->filelength(fl->inner_file, len_out, fl->inner_fs);
+
+  rc = sys_fstat(fl->fd, &stats);
+  *len_out = stats.st_size;
+  return qio_int_to_err(rc);
+}
+
+static
+qioerr gzip_pread_full(gzip_file* fl, void* buf, size_t len, off_t offset)
+{
+  ssize_t got;
+  size_t total = 0;
+  qioerr err;
+
+  while( total < len ) {
+    err = gzip_inner_pread(fl, (char*) buf + total, len - total, offset + total, &got);
+    if( qio_err_to_int(err) == EEOF || (! err && got == 0) )
+      QIO_RETURN_CONSTANT_ERROR(EINVAL, "truncated gzip block");
+    if( err ) return err;
+    total += got;
+  }
+  return 0;
+}
+
+static
+qioerr gzip_write_full(gzip_file* fl, const void* buf, size_t len)
+{
+  struct iovec iov;
+  ssize_t got;
+  size_t total = 0;
+  qioerr err;
+
+  while( total < len ) {
+    if( fl->inner ) {
+      iov.iov_base = (char*) buf + total;
+      iov.iov_len = len - total;
+      err = fl->inner->writev(fl->inner_file, &iov, 1, &got, fl->inner_fs);
+    } else {
+      err = qio_int_to_err(sys_write(fl->fd, (const char*) buf + total, len - total, &got));
+    }
+    if( err ) return err;
+    total += got;
+  }
+  return 0;
+}
+
+// Compress len <= QIO_GZIP_BLOCK_SIZE bytes into a complete block at out,
+// which has room for GZIP_MAX_BLOCK_SIZE bytes. Returns the size of the
+// block or -1 if zlib fails.
+static
+ssize_t gzip_compress_block(unsigned char* out, const unsigned char* in, size_t len, int level)
+{
+  z_stream zs;
+  size_t csize;
+  int rc;
+
+  while( 1 ) {
+    memset(&zs, 0, sizeof(zs));
+    if( deflateInit2(&zs, level, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) != Z_OK )
+      return -1;
+    zs.next_in = (Bytef*) in;
+    zs.avail_in = len;
+    zs.next_out = out + GZIP_BLOCK_HEADER_SIZE;
+    zs.avail_out = GZIP_MAX_BLOCK_SIZE - GZIP_BLOCK_HEADER_SIZE - GZIP_BLOCK_FOOTER_SIZE;
+    rc = deflate(&zs, Z_FINISH);
+    deflateEnd(&zs);
+    if( rc == Z_STREAM_END ) break;
+    // Incompressible data might not fit; storing it always does.
+    if( level == 0 || (rc != Z_OK && rc != Z_BUF_ERROR) ) return -1;
+    level = 0;
+  }
+
+  csize = GZIP_BLOCK_HEADER_SIZE + zs.total_out + GZIP_BLOCK_FOOTER_SIZE;
+  memcpy(out, gzip_eof_block, GZIP_BLOCK_HEADER_SIZE - 2);
+  gzip_put16(out + GZIP_BLOCK_HEADER_SIZE - 2, csize - 1);
+  gzip_put32(out + csize - 8, crc32(crc32(0L, Z_NULL, 0), in, len));
+  gzip_put32(out + csize - 4, len);
+  return csize;
+}
+
+// Decompress an indexed block into out, which has room for b->usize bytes.
+static
+qioerr gzip_decompress_block(gzip_file* fl, const gzip_block_t* b, unsigned char* out)
+{
+  unsigned char* buf;
+  uint32_t hsize;
+  z_stream zs;
+  qioerr err;
+  int rc;
+
+  buf = (unsigned char*) qio_malloc(b->csize);
+  if( ! buf ) return QIO_ENOMEM;
+
+  err = gzip_pread_full(fl, buf, b->csize, b->coff);
+  if( err ) goto done;
+
+  // The index was built from this header, so the sizes are sane.
+  hsize = 12 + gzip_get16(buf + 10);
+
+  memset(&zs, 0, sizeof(zs));
+  if( inflateInit2(&zs, -15) != Z_OK ) {
+    err = QIO_ENOMEM;
+    goto done;
+  }
+  zs.next_in = buf + hsize;
+  zs.avail_in = b->csize - hsize - GZIP_BLOCK_FOOTER_SIZE;
+  zs.next_out = out;
+  zs.avail_out = b->usize;
+  rc = inflate(&zs, Z_FINISH);
+  inflateEnd(&zs);
+
+  if( rc != Z_STREAM_END || zs.total_out != b->usize ||
+      crc32(crc32(0L, Z_NULL, 0), out, b->usize) !=
+        gzip_get32(buf + b->csize - 8) ) {
+    QIO_GET_CONSTANT_ERROR(err, EINVAL, "corrupt gzip block");
+  }
+
+done:
+  qio_free(buf);
+  return err;
+}
+
+// Find the blocks of a file where every gzip member has a 'BC' field.
+// Sets *indexed_out to 0 (and builds nothing) for any other file.
+static
+qioerr gzip_build_index(gzip_file* fl, int* indexed_out)
+{
+  unsigned char hdr[GZIP_BLOCK_HEADER_SIZE];
+  unsigned char* extra = NULL;
+  const unsigned char* xfield;
+  unsigned char trailer[4];
+  int64_t size, off, uoff;
+  int64_t nalloc = 0;
+  gzip_block_t* tmp;
+  uint32_t xlen, slen, i, csize, usize;
+  int found;
+  qioerr err;
+
+  *indexed_out = 0;
+
+  err = gzip_inner_length(fl, &size);
+  if( err ) return err;
+
+  off = 0;
+  uoff = 0;
+  while( off < size ) {
+    if( size - off < GZIP_BLOCK_HEADER_SIZE + GZIP_BLOCK_FOOTER_SIZE ) goto not_indexed;
+    err = gzip_pread_full(fl, hdr, GZIP_BLOCK_HEADER_SIZE, off);
+    if( err ) goto error;
+
+    // Only FEXTRA may be set; the 'BC' field can be anywhere in it.
+    if( hdr[0] != 0x1f || hdr[1] != 0x8b || hdr[2] != 8 || hdr[3] != 4 )
+      goto not_indexed;
+    xlen = gzip_get16(hdr + 10);
+    xfield = hdr + 12;
+    if( 12 + xlen > GZIP_BLOCK_HEADER_SIZE ) {
+      qio_free(extra);
+      extra = (unsigned char*) qio_malloc(xlen);
+      if( ! extra ) {
+        err = QIO_ENOMEM;
+        goto error;
+      }
+      err = gzip_pread_full(fl, extra, xlen, off + 12);
+      if( err ) goto not_indexed;
+      xfield = extra;
+    }
+
+    found = 0;
+    csize = 0;
+    for( i = 0; i + 4 <= xlen; i += 4 + slen ) {
+      slen = gzip_get16(xfield + i + 2);
+      if( xfield[i] == 'B' && xfield[i + 1] == 'C' && slen == 2 && i + 6 <= xlen ) {
+        csize = gzip_get16(xfield + i + 4) + 1;
+        found = 1;
+      }
+    }
+    if( ! found || csize < 12 + xlen + GZIP_BLOCK_FOOTER_SIZE || off + csize > size )
+      goto not_indexed;
+
+    err = gzip_pread_full(fl, trailer, 4, off + csize - 4);
+    if( err ) goto error;
+    usize = gzip_get32(trailer);
+    if( usize > GZIP_MAX_BLOCK_SIZE ) goto not_indexed;
+
+    // Empty blocks (like the end-of-file marker) have nothing to index.
+    if( usize > 0 ) {
+      if( fl->nblocks == nalloc ) {
+        nalloc = nalloc ? 2 * nalloc : 64;
+        tmp = (gzip_block_t*) qio_realloc(fl->blocks, nalloc * sizeof(gzip_block_t));
+        if( ! tmp ) {
+          err = QIO_ENOMEM;
+          goto error;
+        }
+        fl->blocks = tmp;
+      }
+      fl->blocks[fl->nblocks].coff = off;
+      fl->blocks[fl->nblocks].uoff = uoff;
+      fl->blocks[fl->nblocks].csize = csize;
+      fl->blocks[fl->nblocks].usize = usize;
+      fl->nblocks++;
+    }
+
+    off += csize;
+    uoff += usize;
+  }
+
+  fl->length = uoff;
+  *indexed_out = 1;
+  qio_free(extra);
+  return 0;
+
+not_indexed:
+  err = 0;
+error:
+  qio_free(extra);
+  qio_free(fl->blocks);
+  fl->blocks = NULL;
+  fl->nblocks = 0;
+  return err;
+}
+
+// Returns the index of the block holding offset, or nblocks.
+static
+int64_t gzip_find_block(gzip_file* fl, int64_t offset)
+{
+  int64_t lo = 0;
+  int64_t hi = fl->nblocks;
+  int64_t mid;
+
+  if( offset < 0 || offset >= fl->length ) return fl->nblocks;
+
+  // find the last block starting at or before offset
+  while( hi - lo > 1 ) {
+    mid = lo + (hi - lo) / 2;
+    if( fl->blocks[mid].uoff <= offset ) lo = mid;
+    else hi = mid;
+  }
+  return lo;
+}
+
+// Copy n bytes starting at skip from a cached block, if it is cached.
+static
+int gzip_cache_get(gzip_file* fl, int64_t block, size_t skip, size_t n, char* dst)
+{
+  int found = 0;
+  int i;
+
+  if( qio_lock(&fl->lock) ) return 0;
+  for( i = 0; i < GZIP_CACHE_SLOTS; i++ ) {
+    if( fl->cache[i].block == block ) {
+      memcpy(dst, fl->cache[i].data + skip, n);
+      found = 1;
+      break;
+    }
+  }
+  qio_unlock(&fl->lock);
+  return found;
+}
+
+// Put *data (holding block) into the cache, returning the evicted buffer
+// (possibly NULL) in *data.
+static
+void gzip_cache_put(gzip_file* fl, int64_t block, unsigned char** data)
+{
+  gzip_cache_slot_t* slot;
+  unsigned char* evicted;
+
+  if( qio_lock(&fl->lock) ) return;
+  slot = &fl->cache[fl->next_slot];
+  fl->next_slot = (fl->next_slot + 1) % GZIP_CACHE_SLOTS;
+  evicted = slot->data;
+  slot->data = *data;
+  slot->block = block;
+  *data = evicted;
+  qio_unlock(&fl->lock);
+}
+
+// Blocks are decompressed straight into the caller's buffer when they
+// fit there entirely. Only the partial blocks at either end of a read go
+// through the cache, which is what keeps channels reading neighbouring
+// regions in parallel from decompressing their shared block twice.
+static
+qioerr gzip_preadv(void* file, const struct iovec* vector, int count, off_t offset, ssize_t* num_read_out, void* fs)
+{
+  gzip_file* fl = to_gzip_file(file);
+  unsigned char* data = NULL;
+  const gzip_block_t* b;
+  int64_t block;
+  ssize_t total = 0;
+  size_t iov_off = 0;
+  size_t skip, avail, room, n;
+  char* dst;
+  qioerr err = 0;
+  int i = 0;
+
+  STARTING_SLOW_SYSCALL;
+
+  block = gzip_find_block(fl, offset);
+  while( i < count && block < fl->nblocks ) {
+    room = vector[i].iov_len - iov_off;
+    if( room == 0 ) {
+      i++;
+      iov_off = 0;
+      continue;
+    }
+
+    b = &fl->blocks[block];
+    skip = offset + total - b->uoff;
+    avail = b->usize - skip;
+    dst = (char*) vector[i].iov_base + iov_off;
+    n = (avail < room) ? avail : room;
+
+    if( skip == 0 && n == b->usize ) {
+      err = gzip_decompress_block(fl, b, (unsigned char*) dst);
+      if( err ) break;
+    } else if( ! gzip_cache_get(fl, block, skip, n, dst) ) {
+      if( ! data ) {
+        data = (unsigned char*) qio_malloc(GZIP_MAX_BLOCK_SIZE);
+        if( ! data ) {
+          err = QIO_ENOMEM;
+          break;
+        }
+      }
+      err = gzip_decompress_block(fl, b, data);
+      if( err ) break;
+      memcpy(dst, data + skip, n);
+      gzip_cache_put(fl, block, &data);
+    }
+
+    total += n;
+    iov_off += n;
+    if( n == avail ) block++;
+  }
+
+  qio_free(data);
+
+  if( err == 0 && total == 0 && sys_iov_total_bytes(vector, count) != 0 )
+    err = qio_int_to_err(EEOF);
+
+  *num_read_out = total;
+
+  DONE_SLOW_SYSCALL;
+
+  return err;
+}
+
+// Files without a block index are inflated as they are read. A file may
+// hold several gzip members one after another, as produced by cat.
+static
+qioerr gzip_readv(void* file, const struct iovec* vector, int count, ssize_t* num_read_out, void* fs)
+{
+  gzip_file* fl = to_gzip_file(file);
+  ssize_t total = 0;
+  ssize_t got;
+  qioerr err = 0;
+  int zrc;
+  int i;
+
+  if( ! fl->streaming ) {
+    err = gzip_preadv(file, vector, count, fl->current_offset, &total, fs);
+    fl->current_offset += total;
+    *num_read_out = total;
+    return err;
+  }
+
+  err = qio_lock(&fl->lock);
+  if( err ) return err;
+
+  STARTING_SLOW_SYSCALL;
+
+  for( i = 0; i < count; i++ ) {
+    fl->strm.next_out = (Bytef*) vector[i].iov_base;
+    fl->strm.avail_out = vector[i].iov_len;
+    while( fl->strm.avail_out > 0 ) {
+      if( fl->strm.avail_in == 0 && ! fl->at_eof ) {
+        err = gzip_inner_read(fl, fl->inbuf, GZIP_STREAM_CHUNK, &got);
+        if( qio_err_to_int(err) == EEOF || (! err && got == 0) ) {
+          err = 0;
+          fl->at_eof = 1;
+          got = 0;
+        } else if( err ) {
+          break;
+        }
+        fl->strm.next_in = fl->inbuf;
+        fl->strm.avail_in = got;
+      }
+      if( fl->strm.avail_in == 0 && fl->at_eof ) {
+        if( fl->in_member ) QIO_GET_CONSTANT_ERROR(err, EINVAL, "truncated gzip file");
+        break;
+      }
+
+      fl->in_member = 1;
+      zrc = inflate(&fl->strm, Z_NO_FLUSH);
+      if( zrc == Z_STREAM_END ) {
+        // Get ready for another member, if there is one.
+        inflateReset(&fl->strm);
+        fl->in_member = 0;
+      } else if( zrc != Z_OK ) {
+        QIO_GET_CONSTANT_ERROR(err, EINVAL, "corrupt gzip data");
+        break;
+      }
+    }
+    total += vector[i].iov_len - fl->strm.avail_out;
+    if( err || fl->strm.avail_out > 0 ) break;
+  }
+
+  if( err == 0 && total == 0 && sys_iov_total_bytes(vector, count) != 0 )
+    err = qio_int_to_err(EEOF);
+
+  fl->current_offset += total;
+  *num_read_out = total;
+
+  DONE_SLOW_SYSCALL;
+
+  qio_unlock(&fl->lock);
+
+  return err;
+}
+
+typedef struct gzip_compress_job_s {
+  gzip_file* fl;
+  int block;     // which pending block to compress
+  ssize_t size;  // compressed size, or -1 on error
+  pthread_t thread;
+  int started;   // is a thread running this job?
+} gzip_compress_job_t;
+
+static
+void* gzip_compress_worker(void* arg)
+{
+  gzip_compress_job_t* job = (gzip_compress_job_t*) arg;
+  gzip_file* fl = job->fl;
+  size_t start = (size_t) job->block * QIO_GZIP_BLOCK_SIZE;
+  size_t len = fl->pending_len - start;
+
+  if( len > QIO_GZIP_BLOCK_SIZE ) len = QIO_GZIP_BLOCK_SIZE;
+  job->size = gzip_compress_block(fl->compressed + (size_t) job->block * GZIP_MAX_BLOCK_SIZE,
+                                  fl->pending + start, len, fl->level);
+  return NULL;
+}
+
+// Compress the pending data (at most nthreads blocks) and append it to
+// the file. The blocks are compressed in parallel but always written in
+// order. Call with fl->lock held.
+static
+qioerr gzip_flush_pending(gzip_file* fl)
+{
+  gzip_compress_job_t jobs[GZIP_MAX_THREADS];
+  int nblocks;
+  int j;
+  qioerr err = 0;
+
+  if( fl->pending_len == 0 ) return 0;
+
+  nblocks = (fl->pending_len + QIO_GZIP_BLOCK_SIZE - 1) / QIO_GZIP_BLOCK_SIZE;
+
+  for( j = 0; j < nblocks; j++ ) {
+    jobs[j].fl = fl;
+    jobs[j].block = j;
+    // This thread compresses block 0 itself.
+    jobs[j].started = j > 0 &&
+      pthread_create(&jobs[j].thread, NULL, gzip_compress_worker, &jobs[j]) == 0;
+  }
+  gzip_compress_worker(&jobs[0]);
+  for( j = 1; j < nblocks; j++ ) {
+    if( jobs[j].started ) pthread_join(jobs[j].thread, NULL);
+    else gzip_compress_worker(&jobs[j]);
+  }
+
+  for( j = 0; j < nblocks; j++ ) {
+    if( jobs[j].size < 0 ) {
+      QIO_GET_CONSTANT_ERROR(err, EINVAL, "unable to compress gzip block");
+      break;
+    }
+    err = gzip_write_full(fl, fl->compressed + (size_t) j * GZIP_MAX_BLOCK_SIZE, jobs[j].size);
+    if( err ) break;
+  }
+
+  fl->pending_len = 0;
+  return err;
+}
+
+static
+qioerr gzip_writev(void* file, const struct iovec* iov, int iovcnt, ssize_t* num_written_out, void* fs)
+{
+  gzip_file* fl = to_gzip_file(file);
+  size_t capacity = (size_t) fl->nthreads * QIO_GZIP_BLOCK_SIZE;
+  ssize_t total = 0;
+  size_t done, n;
+  qioerr err;
+  int i;
+
+  err = qio_lock(&fl->lock);
+  if( err ) return err;
+
+  STARTING_SLOW_SYSCALL;
+
+  for( i = 0; i < iovcnt && ! err; i++ ) {
+    done = 0;
+    while( done < iov[i].iov_len ) {
+      n = iov[i].iov_len - done;
+      if( n > capacity - fl->pending_len ) n = capacity - fl->pending_len;
+      memcpy(fl->pending + fl->pending_len, (char*) iov[i].iov_base + done, n);
+      fl->pending_len += n;
+      done += n;
+      total += n;
+      if( fl->pending_len == capacity ) {
+        err = gzip_flush_pending(fl);
+        if( err ) break;
+      }
+    }
+  }
+
+  fl->written += total;
+  *num_written_out = total;
+
+  DONE_SLOW_SYSCALL;
+
+  qio_unlock(&fl->lock);
+
+  return err;
+}
+
+static
+int gzip_getenv_int(const char* name, int def, int min, int max)
+{
+  const char* env = getenv(name);
+  int v;
+
+  if( ! env || ! *env ) return def;
+  v = atoi(env);
+  if( v < min || v > max ) return def;
+  return v;
+}
+
+static
+void gzip_free(gzip_file* fl)
+{
+  int i;
+
+  for( i = 0; i < GZIP_CACHE_SLOTS; i++ ) qio_free(fl->cache[i].data);
+  qio_free(fl->blocks);
+  qio_free(fl->inbuf);
+  qio_free(fl->pending);
+  qio_free(fl->compressed);
+  qio_free(fl->pathnm);
+  qio_free(fl);
+}
+
+// fs is a qio_gzip_fs_t naming the plugin that holds the compressed
+// file, or NULL for a local file. Only the open uses it.
+static
+qioerr gzip_open(void** fd, const char* path, int* flags, mode_t mode, qio_hint_t iohints, void* fs)
+{
+  qio_gzip_fs_t* layer = (qio_gzip_fs_t*) fs;
+  qioerr err_out = 0;
+  gzip_file* fl;
+  int inner_flags;
+  int indexed = 0;
+  int rc;
+  int i;
+
+  rc = *flags | ~O_ACCMODE;
+  rc &= O_ACCMODE;
+  if( rc == O_RDWR )
+    QIO_RETURN_CONSTANT_ERROR(EINVAL, "gzip files cannot be opened for both reading and writing");
+
+  fl = (gzip_file*) qio_calloc(sizeof(gzip_file), 1);
+  if( ! fl ) return QIO_ENOMEM;
+  fl->fd = -1;
+  for( i = 0; i < GZIP_CACHE_SLOTS; i++ ) fl->cache[i].block = -1;
+
+  fl->pathnm = qio_strdup(path);
+  if( ! fl->pathnm ) {
+    err_out = QIO_ENOMEM;
+    goto error;
+  }
+
+  if( layer && layer->inner ) {
+    if( (rc == O_WRONLY && ! layer->inner->writev) ||
+        (rc != O_WRONLY && ! layer->inner->readv && ! layer->inner->preadv) ) {
+      QIO_GET_CONSTANT_ERROR(err_out, ENOTSUP, "gzip cannot be used with this file system in this mode");
+      goto error;
+    }
+    inner_flags = *flags;
+    err_out = layer->inner->open(&fl->inner_file, path, &inner_flags, mode, iohints, layer->inner_fs);
+    if( err_out ) goto error;
+    fl->inner = layer->inner;
+    fl->inner_fs = layer->inner_fs;
+  } else {
+    err_out = qio_int_to_err(sys_open(path, *flags, mode, &fl->fd));
+    if( err_out ) goto error;
+  }
+
+  // Not seekable unless we specify otherwise
+  *flags &= ~QIO_FDFLAG_SEEKABLE;
+
+  if( rc == O_WRONLY ) {
+    fl->writing = 1;
+    fl->nthreads = gzip_getenv_int("CHPL_RT_QIO_GZIP_THREADS", GZIP_DEFAULT_THREADS, 1, GZIP_MAX_THREADS);
+    fl->level = gzip_getenv_int("CHPL_RT_QIO_GZIP_LEVEL", Z_DEFAULT_COMPRESSION, 0, 9);
+    fl->pending = (unsigned char*) qio_malloc((size_t) fl->nthreads * QIO_GZIP_BLOCK_SIZE);
+    fl->compressed = (unsigned char*) qio_malloc((size_t) fl->nthreads * GZIP_MAX_BLOCK_SIZE);
+    if( ! fl->pending || ! fl->compressed ) {
+      err_out = QIO_ENOMEM;
+      goto error;
+    }
+    *flags |= QIO_FDFLAG_WRITEABLE;
+  } else {
+    // Finding the blocks needs a file that can be read at any offset.
+    // Some plugins (curl without range requests) only find out that
+    // they cannot do that when they try; those files are streamed.
+    if( ! fl->inner || (fl->inner->preadv && fl->inner->filelength) ) {
+      err_out = gzip_build_index(fl, &indexed);
+      if( err_out && fl->inner ) err_out = 0;
+      if( err_out ) goto error;
+    }
+
+    if( indexed ) {
+      *flags |= QIO_FDFLAG_SEEKABLE;
+    } else {
+      fl->streaming = 1;
+      fl->inbuf = (unsigned char*) qio_malloc(GZIP_STREAM_CHUNK);
+      if( ! fl->inbuf ) {
+        err_out = QIO_ENOMEM;
+        goto error;
+      }
+      // 15 + 32 accepts either a gzip or a zlib header
+      if( inflateInit2(&fl->strm, 15 + 32) != Z_OK ) {
+        err_out = QIO_ENOMEM;
+        goto error;
+      }
+    }
+    *flags |= QIO_FDFLAG_READABLE;
+  }
+
+  err_out = qio_lock_init(&fl->lock);
+  if( err_out ) {
+    if( fl->streaming ) inflateEnd(&fl->strm);
+    goto error;
+  }
+
+  *fd = fl;
+  return 0;
+
+error:
+  if( fl->inner ) fl->inner->close(fl->inner_file, fl->inner_fs);
+  else if( fl->fd != -1 ) sys_close(fl->fd);
+  gzip_free(fl);
+  return err_out;
+}
+
+static
+qioerr gzip_close(void* file, void* fs)
+{
+  gzip_file* fl = to_gzip_file(file);
+  qioerr err_out = 0;
+  qioerr err;
+
+  STARTING_SLOW_SYSCALL;
+
+  if( fl->writing ) {
+    err_out = gzip_flush_pending(fl);
+    if( ! err_out ) err_out = gzip_write_full(fl, gzip_eof_block, sizeof(gzip_eof_block));
+  }
+  if( fl->streaming ) inflateEnd(&fl->strm);
+
+  if( fl->inner ) err = fl->inner->close(fl->inner_file, fl->inner_fs);
+  else err = qio_int_to_err(sys_close(fl->fd));
+  if( ! err_out ) err_out = err;
+
+  DONE_SLOW_SYSCALL;
+
+  qio_lock_destroy(&fl->lock);
+  gzip_free(fl);
+
+  return err_out;
+}
+
+// Writing a short block here is fine; readers handle blocks of any size.
+static
+qioerr gzip_fsync(void* file, void* fs)
+{
+  gzip_file* fl = to_gzip_file(file);
+  qioerr err = 0;
+
+  if( fl->writing ) {
+    err = qio_lock(&fl->lock);
+    if( err ) return err;
+    err = gzip_flush_pending(fl);
+    qio_unlock(&fl->lock);
+    if( err ) return err;
+  }
+
+  if( fl->inner ) {
+    if( ! fl->inner->fsync ) return 0;
+    return fl->inner->fsync(fl->inner_file, fl->inner_fs);
+  }
+  return qio_int_to_err(sys_fsync(fl->fd));
+}
+
+// Offsets are in the uncompressed data, so only files with a block
+// index can seek.
+static
+qioerr gzip_seek(void* file, off_t offset, int whence, off_t* offset_out, void* fs)
+{
+  gzip_file* fl = to_gzip_file(file);
+
+  if( fl->writing || fl->streaming )
+    QIO_RETURN_CONSTANT_ERROR(ESPIPE, "Unable to seek: gzip file has no block index");
+
+  switch (whence) {
+    case SEEK_CUR:
+      fl->current_offset += offset;
+      break;
+    case SEEK_END:
+      fl->current_offset = fl->length + offset;
+      break;
+    case SEEK_SET:
+      fl->current_offset = offset;
+      break;
+  }
+
+  *offset_out = fl->current_offset;
+  return 0;
+}
+
+static
+qioerr gzip_getpath(void* file, const char** string_out, void* fs)
+{
+  *string_out = qio_strdup(to_gzip_file(file)->pathnm);
+  if( ! *string_out ) return QIO_ENOMEM;
+  return 0;
+}
+
+static
+qioerr gzip_getlength(void* file, int64_t* len_out, void* fs)
+{
+  gzip_file* fl = to_gzip_file(file);
+
+  if( fl->writing ) {
+    *len_out = fl->written;
+  } else if( fl->streaming ) {
+    // This will set initial length to 0 in QIO
+    *len_out = 0;
+    QIO_RETURN_CONSTANT_ERROR(ENOTSUP, "Unable to get length of gzip file without a block index");
+  } else {
+    *len_out = fl->length;
+  }
+  return 0;
+}
+
+static
+int gzip_get_fs_type(void* file, void* fs)
+{
+  return FTYPE_GZIP;
+}
+
+qio_file_functions_t gzip_function_struct = {
+    &gzip_writev,    // writev
+    &gzip_readv,     // readv
+    NULL,            // pwritev
+    &gzip_preadv,    // preadv
+    &gzip_close,     // close
+    &gzip_open,      // open
+    &gzip_seek,      // seek
+    &gzip_getlength, // filelength
+    &gzip_getpath,   // getpath
+    &gzip_fsync,     // fsync
+    NULL,            // getcwd
+    &gzip_get_fs_type, // get_fs_type
+    NULL,            // get_chunk
+    NULL,            // get_locales_for_region
+};
+
+const qio_file_functions_ptr_t gzip_function_struct_ptr = &gzip_function_struct;
+
+qioerr gzip_file_open_access_usr(qio_file_t** file_out, const char* path, const char* access, qio_hint_t iohints, const qio_style_t* style, void* fs, const qio_file_functions_t* s)
+{
+  qio_gzip_fs_t layer;
+  qioerr err;
+
+  layer.inner = s;
+  layer.inner_fs = fs;
+  err = qio_file_open_access_usr(file_out, path, access, iohints, style, &layer, &gzip_function_struct);
+  // gzip_open copied the layer into the gzip_file, so don't leave the
+  // file pointing at it once it goes out of scope.
+  if( ! err ) (*file_out)->fs_info = NULL;
+  return err;
+}
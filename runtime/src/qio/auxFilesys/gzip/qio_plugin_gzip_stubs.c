@@ -0,0 +1,80 @@
+/*
+ * Copyright 2004-2015 Cray Inc.
+ * Other additional copyright holders may be indicated within.
+ * 
+ * The entirety of this work is licensed under the Apache License,
+ * Version 2.0 (the "License"); you may not use this file except
+ * in compliance with the License.
+ * 
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string.h>
+
+#ifndef CHPL_RT_UNIT_TEST
+#include "chplrt.h"
+#endif
+
+#include "qio_plugin_gzip.h"
+
+#define GZIP_ERROR(ret){\
+  chpl_internal_error("No gzip Support");\
+  return ret;\
+}
+
+const qio_file_functions_ptr_t gzip_function_struct_ptr = &gzip_function_struct;
+
+qioerr gzip_file_open_access_usr(qio_file_t** file_out, const char* path, const char* access, qio_hint_t iohints, const qio_style_t* style, void* fs, const qio_file_functions_t* s) GZIP_ERROR(0)
+
+static
+qioerr gzip_readv(void* file, const struct iovec *vector, int count, ssize_t* num_read_out, void* fs) GZIP_ERROR(0)
+
+static
+qioerr gzip_preadv(void* file, const struct iovec *vector, int count, off_t offset, ssize_t* num_read_out, void* fs) GZIP_ERROR(0)
+
+static
+qioerr gzip_writev(void* fl, const struct iovec* iov, int iovcnt, ssize_t* num_written_out, void* fs) GZIP_ERROR(0)
+
+static
+qioerr gzip_open(void** fd, const char* path, int* flags, mode_t mode, qio_hint_t iohints, void* fs) GZIP_ERROR(0)
+
+static
+qioerr gzip_close(void* fl, void* fs) GZIP_ERROR(0)
+
+static
+qioerr gzip_seek(void* fl, off_t offset, int whence, off_t* offset_out, void* fs) GZIP_ERROR(0)
+
+static
+qioerr gzip_getpath(void* file, const char** string_out, void* fs) GZIP_ERROR(0)
+
+static
+qioerr gzip_getlength(void* fl, int64_t* len_out, void* fs) GZIP_ERROR(0)
+
+static
+qioerr gzip_fsync(void* fl, void* fs) GZIP_ERROR(0)
+
+static
+int gzip_get_fs_type(void* fl, void* fs) GZIP_ERROR(0)
+
+qio_file_functions_t gzip_function_struct = {
+    &gzip_writev,
+    &gzip_readv,
+    NULL,
+    &gzip_preadv,
+    &gzip_close,
+    &gzip_open,
+    &gzip_seek,
+    &gzip_getlength,
+    &gzip_getpath,
+    &gzip_fsync,
+    NULL,
+    &gzip_get_fs_type,
+};
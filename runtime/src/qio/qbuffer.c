@@ -531,7 +531,7 @@ void qbuffer_trim_back(qbuffer_t* buf, int64_t remove_bytes)
         qbytes_t* bytes = qbp->bytes;
         // starts entirely after new_end, remove the chunk.
         // Remove it from the deque
-        deque_pop_front(sizeof(qbuffer_part_t), &buf->deque);
+        deque_pop_back(sizeof(qbuffer_part_t), &buf->deque);
         // release the bytes.
         qbytes_release(bytes);
       } else {
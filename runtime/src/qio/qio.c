@@ -37,6 +37,7 @@
 
 #include "qio.h"
 #include "qbuffer.h"
+#include "qio_async.h"
 
 #include "error.h"
 
@@ -60,12 +61,31 @@
 ssize_t qio_too_small_for_default_mmap = 16*1024;
 ssize_t qio_too_large_for_default_mmap = 64*1024*((size_t)1024*1024);
 ssize_t qio_mmap_chunk_iobufs = 128; // mmap 128 iobufs at a time (8M)
+ssize_t qio_pipeline_iobufs = -1; // -1: from CHPL_RT_QIO_PIPELINE_DEPTH or 4
 
 // Future - possibly set this based on ulimit?
 ssize_t qio_initial_mmap_max = 8*1024*1024;
 bool qio_allow_default_mmap = true;
 
 #ifdef _chplrt_H_
+// Called by a task other than the bias task before it locks x for the
+// first time. Waits for the bias task to let go, then switches x to
+// always using the sync variable.
+static
+void _qio_lock_revoke_bias(qio_lock_t* x)
+{
+  while( 1 ) {
+    int32_t state = atomic_load_explicit_int_least32_t(&x->bias_state,
+                                                       memory_order_acquire);
+    if( state == QIO_LOCK_BIAS_REVOKED ) return;
+    if( state == QIO_LOCK_BIAS_FREE &&
+        atomic_compare_exchange_strong_explicit_int_least32_t(
+          &x->bias_state, QIO_LOCK_BIAS_FREE, QIO_LOCK_BIAS_REVOKED,
+          memory_order_acq_rel) ) return;
+    chpl_task_yield();
+  }
+}
+
 qioerr qio_lock(qio_lock_t* x) {
   // recursive mutex based on glibc pthreads implementation
   int64_t id = chpl_task_getId();
@@ -79,6 +99,19 @@ qioerr qio_lock(qio_lock_t* x) {
     return 0;
   }
 
+  if( x->bias == id ) {
+    // fast path for the creating task, until the bias is revoked.
+    if( atomic_compare_exchange_strong_explicit_int_least32_t(
+          &x->bias_state, QIO_LOCK_BIAS_FREE, QIO_LOCK_BIAS_HELD,
+          memory_order_acquire) ) {
+      x->count = 1;
+      x->owner = id;
+      return 0;
+    }
+  } else {
+    _qio_lock_revoke_bias(x);
+  }
+
   // we have to get the mutex.
   chpl_sync_lock(&x->sv);
 
@@ -102,6 +135,17 @@ void qio_unlock(qio_lock_t* x) {
   }
 
   x->owner = NULL_OWNER;
+
+  if( x->bias == id &&
+      atomic_load_explicit_int_least32_t(&x->bias_state,
+                                         memory_order_relaxed) ==
+        QIO_LOCK_BIAS_HELD ) {
+    // we took it on the fast path.
+    atomic_store_explicit_int_least32_t(&x->bias_state, QIO_LOCK_BIAS_FREE,
+                                        memory_order_release);
+    return;
+  }
+
   chpl_sync_unlock(&x->sv);
 }
 #endif
@@ -383,6 +427,230 @@ error:
   return err;
 }
 
+// Positional I/O through the asynchronous engine. The region is split
+// into requests of about qbytes_iobuf_size bytes which are all issued
+// before waiting on any of them, so the chunks are in flight together.
+// As with qio_preadv/qio_pwritev, the count returned covers only the
+// leading bytes that were transferred without a gap.
+static
+qioerr _qio_async_rwv(qio_file_t* file, qio_aio_op_t op, qbuffer_t* buf, qbuffer_iter_t start, qbuffer_iter_t end, int64_t seek_to_offset, ssize_t* num_out)
+{
+  ssize_t total = 0;
+  int64_t num_bytes = qbuffer_iter_num_bytes(start, end);
+  ssize_t num_parts = qbuffer_iter_num_parts(start, end);
+  struct iovec* iov = NULL;
+  qio_aio_req_t* reqs = NULL;
+  size_t iovcnt;
+  size_t i, j;
+  ssize_t nreqs, nsubmitted, r;
+  int64_t req_bytes, off;
+  err_t serr, first_err;
+  ssize_t got;
+  int short_io;
+  MAYBE_STACK_SPACE(struct iovec, iov_onstack);
+  MAYBE_STACK_SPACE(qio_aio_req_t, reqs_onstack);
+  qioerr err;
+
+  if( num_bytes < 0 || num_parts < 0 || num_parts > INT_MAX ) {
+    QIO_RETURN_CONSTANT_ERROR(EINVAL, "range outside of buffer");
+  }
+
+  if( file->fd == -1 ) {
+    // Only fd-backed files use the async engine.
+    if( op == QIO_AIO_READ )
+      return qio_preadv(file, buf, start, end, seek_to_offset, num_out);
+    else
+      return qio_pwritev(file, buf, start, end, seek_to_offset, num_out);
+  }
+
+  MAYBE_STACK_ALLOC(struct iovec, num_parts, iov, iov_onstack);
+  // There are never more requests than iovecs.
+  MAYBE_STACK_ALLOC(qio_aio_req_t, num_parts, reqs, reqs_onstack);
+  if( ! iov || ! reqs ) {
+    err = QIO_ENOMEM;
+    goto error;
+  }
+
+  err = qbuffer_to_iov(buf, start, end, num_parts, iov, NULL, &iovcnt);
+  if( err ) goto error;
+
+  // Group consecutive iovecs into requests and submit them.
+  nreqs = 0;
+  nsubmitted = 0;
+  off = seek_to_offset;
+  serr = 0;
+  for( i = 0; i < iovcnt; i = j ) {
+    req_bytes = iov[i].iov_len;
+    for( j = i + 1; j < iovcnt && j - i < IOV_MAX; j++ ) {
+      if( req_bytes + (int64_t) iov[j].iov_len > qbytes_iobuf_size ) break;
+      req_bytes += iov[j].iov_len;
+    }
+    qio_aio_req_init(&reqs[nreqs], op, file->fd, &iov[i], j - i, off);
+    off += req_bytes;
+    serr = qio_aio_submit(&reqs[nreqs]);
+    nreqs++;
+    if( serr ) break;
+    nsubmitted++;
+  }
+
+  // Wait for everything we submitted, even after an error, since
+  // the requests refer to our iovecs.
+  first_err = 0;
+  short_io = 0;
+  for( r = 0; r < nsubmitted; r++ ) {
+    err_t rerr = qio_aio_wait(&reqs[r], &got);
+    if( short_io || first_err ) continue;
+    total += got;
+    if( rerr ) first_err = rerr;
+    else if( got != sys_iov_total_bytes(reqs[r].iov, reqs[r].iovcnt) ) short_io = 1;
+  }
+  if( ! first_err && ! short_io && serr ) first_err = serr;
+  if( first_err == EEOF && total > 0 ) first_err = 0;
+  err = qio_int_to_err(first_err);
+
+error:
+  MAYBE_STACK_FREE(reqs, reqs_onstack);
+  MAYBE_STACK_FREE(iov, iov_onstack);
+
+  *num_out = total;
+
+  return err;
+}
+
+qioerr qio_async_preadv(qio_file_t* file, qbuffer_t* buf, qbuffer_iter_t start, qbuffer_iter_t end, int64_t seek_to_offset, ssize_t* num_read)
+{
+  return _qio_async_rwv(file, QIO_AIO_READ, buf, start, end, seek_to_offset, num_read);
+}
+
+qioerr qio_async_pwritev(qio_file_t* file, qbuffer_t* buf, qbuffer_iter_t start, qbuffer_iter_t end, int64_t seek_to_offset, ssize_t* num_written)
+{
+  return _qio_async_rwv(file, QIO_AIO_WRITE, buf, start, end, seek_to_offset, num_written);
+}
+
+// Returns the direct I/O descriptor for a file, opening it on first
+// use, or -1 if direct I/O is not available for this file (e.g. the
+// file system does not support O_DIRECT). The file is opened a second
+// time so that the unaligned pieces of a transfer can still go through
+// file->fd and the page cache.
+static
+fd_t _qio_file_direct_fd(qio_file_t* f)
+{
+  const char* path = NULL;
+  int flags;
+  fd_t fd = -1;
+  err_t err;
+  qioerr qerr;
+
+  qerr = qio_lock(&f->lock);
+  if( qerr ) return -1;
+
+  if( f->direct_fd == -1 ) {
+    f->direct_fd = -2;
+
+    if( (f->fdflags & QIO_FDFLAG_READABLE) &&
+        (f->fdflags & QIO_FDFLAG_WRITEABLE) ) flags = O_RDWR;
+    else if( f->fdflags & QIO_FDFLAG_WRITEABLE ) flags = O_WRONLY;
+    else flags = O_RDONLY;
+
+    if( f->fd != -1 && ! qio_file_path_for_fd(f->fd, &path) && path ) {
+#ifdef O_DIRECT
+      err = sys_open(path, flags | O_DIRECT, 0, &fd);
+#else
+      err = sys_open(path, flags, 0, &fd);
+#ifdef F_NOCACHE
+      if( ! err ) {
+        int rc;
+        err = sys_fcntl_long(fd, F_NOCACHE, 1, &rc);
+        if( err ) sys_close(fd);
+      }
+#else
+      if( ! err ) sys_close(fd);
+      err = ENOSYS;
+#endif
+#endif
+      if( ! err ) f->direct_fd = fd;
+    }
+    qio_free((void*) path);
+  }
+
+  fd = f->direct_fd;
+  qio_unlock(&f->lock);
+
+  return (fd >= 0) ? fd : -1;
+}
+
+// Positional I/O for QIO_HINT_DIRECT channels. The page-aligned middle
+// of each part goes through the direct descriptor; an unaligned head
+// or tail (which only happens at the ends of a channel) and any piece
+// the direct descriptor refuses go through file->fd. The channel
+// allocates its buffer space so that memory alignment matches file
+// offset alignment (see _buffered_allocate_bufferspace).
+static
+qioerr _qio_direct_rw(qio_file_t* file, int writing, qbuffer_t* buf, qbuffer_iter_t start, qbuffer_iter_t end, ssize_t* num_out)
+{
+  int64_t align = sys_page_size();
+  fd_t dfd = _qio_file_direct_fd(file);
+  ssize_t total = 0;
+  err_t err = 0;
+
+  if( dfd == -1 ) {
+    if( writing )
+      return qio_pwritev(file, buf, start, end, start.offset, num_out);
+    else
+      return qio_preadv(file, buf, start, end, start.offset, num_out);
+  }
+
+  while( qbuffer_iter_num_bytes(start, end) > 0 ) {
+    qbytes_t* bytes;
+    int64_t skip, len;
+    int64_t a, b, mid_a, mid_b;
+    int64_t pieces[3][2];
+    int i;
+
+    qbuffer_iter_get(start, end, &bytes, &skip, &len);
+    a = start.offset;
+    b = a + len;
+    mid_a = (a + align - 1) / align * align;
+    mid_b = b / align * align;
+    if( mid_b < mid_a ||
+        ((intptr_t) VOID_PTR_ADD(bytes->data, skip + (mid_a - a))) % align ) {
+      mid_a = mid_b = b;
+    }
+    pieces[0][0] = a; pieces[0][1] = mid_a;
+    pieces[1][0] = mid_a; pieces[1][1] = mid_b;
+    pieces[2][0] = mid_b; pieces[2][1] = b;
+
+    for( i = 0; i < 3 && ! err; i++ ) {
+      int64_t off = pieces[i][0];
+      int64_t n = pieces[i][1] - off;
+      void* ptr = VOID_PTR_ADD(bytes->data, skip + (off - a));
+      fd_t fd = (i == 1) ? dfd : file->fd;
+      ssize_t got = 0;
+
+      if( n == 0 ) continue;
+
+      if( writing ) err = sys_pwrite(fd, ptr, n, off, &got);
+      else err = sys_pread(fd, ptr, n, off, &got);
+      if( err == EINVAL && fd == dfd ) {
+        // e.g. a file system that wants a larger alignment.
+        if( writing ) err = sys_pwrite(file->fd, ptr, n, off, &got);
+        else err = sys_pread(file->fd, ptr, n, off, &got);
+      }
+
+      total += got;
+      if( ! err && got != n ) break;
+    }
+
+    if( err || i < 3 ) break;
+    qbuffer_iter_advance(buf, &start, len);
+  }
+
+  if( err == EEOF && total > 0 ) err = 0;
+  *num_out = total;
+
+  return qio_int_to_err(err);
+}
+
 qioerr qio_recv(fd_t sockfd, qbuffer_t* buf, qbuffer_iter_t start, qbuffer_iter_t end, int flags,
               sys_sockaddr_t* src_addr_out, /* can be NULL */
               void* ancillary_out, socklen_t* ancillary_len_inout, /* can be NULL */
@@ -540,6 +808,7 @@ qio_hint_t choose_io_method(qio_file_t* file, qio_hint_t hints, qio_hint_t defau
           method = QIO_METHOD_FREADFWRITE;
         } else if( fdflags & QIO_FDFLAG_SEEKABLE ) {
           if( hints & QIO_HINT_NOREUSE ) method = QIO_METHOD_PREADPWRITE;
+          else if( (hints | default_hints) & QIO_HINT_DIRECT ) method = QIO_METHOD_PREADPWRITE;
           else if( hints & QIO_HINT_CACHED ) method = QIO_METHOD_MMAP;
           else {
             // default case
@@ -563,6 +832,13 @@ qio_hint_t choose_io_method(qio_file_t* file, qio_hint_t hints, qio_hint_t defau
     } else {
       // method already chosen in hints.
     }
+
+    // The asynchronous method only does positional I/O on a file
+    // descriptor; otherwise use the nearest synchronous method.
+    if( method == QIO_METHOD_ASYNC ) {
+      if( isfilestar ) method = QIO_METHOD_FREADFWRITE;
+      else if( !(fdflags & QIO_FDFLAG_SEEKABLE) ) method = QIO_METHOD_READWRITE;
+    }
   }
 
   // Always use fread/fwrite with FILE*
@@ -591,18 +867,9 @@ qioerr qio_fadvise_for_hints(qio_file_t* file)
   qioerr err;
 
   if( file->hints & QIO_HINT_DIRECT ) {
-    int rc;
-    long arg;
-    // Set O_DIRECT on our fd.
-    err = qio_int_to_err(sys_fcntl(file->fd, F_GETFL, &rc));
-    if( err ) return err;
-
-    arg = rc;
-#ifdef O_DIRECT
-    arg |= O_DIRECT;
-#endif
-    err = qio_int_to_err(sys_fcntl_long(file->fd, F_SETFL, arg, &rc));
-    if( err ) return err;
+    // Direct I/O uses its own descriptor (see _qio_file_direct_fd)
+    // so that unaligned pieces can still go through this one.
+    err = 0;
   } else {
     err = 0;
 #if (_XOPEN_SOURCE >= 600 || _POSIX_C_SOURCE >= 200112L)
@@ -707,6 +974,67 @@ qioerr qio_mmap_initial(qio_file_t* file)
   return 0;
 }
 
+qioerr qio_file_map_array(qio_file_t* f, int64_t offset, int64_t len, int writeable, int shared, qio_hint_t hints, void** data_out)
+{
+  int64_t skip = offset % sys_page_size();
+  int prot = PROT_READ;
+  int flags = shared ? MAP_SHARED : MAP_PRIVATE;
+  struct stat stats;
+  void* data = NULL;
+  qioerr err;
+
+  *data_out = NULL;
+
+  if( f->fd == -1 ) QIO_RETURN_CONSTANT_ERROR(ENOSYS, "mapping requires a file descriptor");
+  if( offset < 0 || len <= 0 ) QIO_RETURN_CONSTANT_ERROR(EINVAL, "bad region to map");
+  if( len + skip > SSIZE_MAX ) return QIO_ENOMEM;
+
+  if( writeable ) prot |= PROT_WRITE;
+
+#ifdef MAP_POPULATE
+  if( hints & QIO_HINT_CACHED ) flags |= MAP_POPULATE;
+#endif
+
+  // Pages past the end of the file can't be accessed. A writeable
+  // shared map extends the file; otherwise that's an error.
+  err = qio_int_to_err(sys_fstat(f->fd, &stats));
+  if( err ) return err;
+  if( stats.st_size < offset + len ) {
+    if( writeable && shared ) {
+      err = qio_int_to_err(sys_ftruncate(f->fd, offset + len));
+      if( err ) return err;
+    } else {
+      QIO_RETURN_CONSTANT_ERROR(EEOF, "region to map is past the end of the file");
+    }
+  }
+
+  // mmap needs a page-aligned file offset.
+  err = qio_int_to_err(sys_mmap(NULL, len + skip, prot, flags, f->fd, offset - skip, &data));
+  if( err ) return err;
+
+  // The advice is only a hint, so failing to give it is not an error.
+  (void) qio_madvise_for_hints(data, len + skip, hints);
+
+  *data_out = VOID_PTR_ADD(data, skip);
+  return 0;
+}
+
+qioerr qio_file_unmap_array(void* data, int64_t len, int sync)
+{
+  int64_t skip = ((intptr_t) data) % sys_page_size();
+  void* start = VOID_PTR_ADD(data, -skip);
+  err_t err = 0;
+  err_t unmap_err;
+
+  if( ! data ) return 0;
+
+  if( sync ) err = sys_msync(start, len + skip, MS_SYNC);
+  unmap_err = sys_munmap(start, len + skip);
+  if( ! err ) err = unmap_err;
+
+  return qio_int_to_err(err);
+}
+
 
 qioerr qio_file_init(qio_file_t** file_out, FILE* fp, fd_t fd, qio_hint_t iohints, const qio_style_t* style, int usefilestar)
 {
@@ -805,6 +1133,7 @@ qioerr qio_file_init(qio_file_t** file_out, FILE* fp, fd_t fd, qio_hint_t iohint
   DO_INIT_REFCNT(file);
   file->fp = fp;
   file->fd = fd;
+  file->direct_fd = -1;
   file->use_fp = usefilestar;
   file->buf = NULL;
   file->fdflags = fdflags;
@@ -900,6 +1229,7 @@ qioerr qio_file_init_usr(qio_file_t** file_out, void* file_info, qio_hint_t iohi
   DO_INIT_REFCNT(file);
   file->fp = NULL;
   file->fd = -1;
+  file->direct_fd = -1;
   file->use_fp = 0;
   file->buf = NULL;
   file->fdflags = (qio_fdflag_t) flags;
@@ -976,6 +1306,12 @@ qioerr _qio_file_do_close(qio_file_t* f)
     f->hints &= ~QIO_HINT_OWNED;
   }
 
+  if( f->direct_fd >= 0 ) {
+    // Always ours, even if fd is not.
+    err = qio_int_to_err(sys_close(f->direct_fd));
+    f->direct_fd = -1;
+  }
+
   if( f->fd >= 0 ) {
     if (f->hints & QIO_HINT_OWNED)
       err = qio_int_to_err(sys_close(f->fd));
@@ -1189,6 +1525,7 @@ qioerr qio_file_open_mem_ext(qio_file_t** file_out, qbuffer_t* buf, qio_fdflag_t
   DO_INIT_REFCNT(file); // initialized to 1.
   file->fp = NULL;
   file->fd = -1;
+  file->direct_fd = -1;
   file->fdflags = fdflags;
   file->hints = choose_io_method(file, iohints, 0, qbuffer_len(file->buf),
                                  (fdflags & QIO_FDFLAG_READABLE) > 0,
@@ -1384,6 +1721,65 @@ qioerr qio_file_length(qio_file_t* f, int64_t *len_out)
   return err;
 }
 
+// Positional I/O of a whole region without a channel. Used when
+// different locales move different parts of one region of a file.
+qioerr qio_file_pwrite_amt(qio_file_t* f, const void* ptr, ssize_t len, int64_t offset)
+{
+  ssize_t num;
+  err_t err = 0;
+
+  if( f->fd == -1 ) QIO_RETURN_CONSTANT_ERROR(ENOSYS, "no fd");
+
+  while( len > 0 ) {
+    num = 0;
+    err = sys_pwrite(f->fd, ptr, len, offset, &num);
+    if( err ) break;
+    ptr = VOID_PTR_ADD(ptr, num);
+    len -= num;
+    offset += num;
+  }
+
+  return qio_int_to_err(err);
+}
+
+qioerr qio_file_identity(qio_file_t* f, int64_t* dev_out, int64_t* ino_out)
+{
+  struct stat stats;
+  err_t err;
+
+  *dev_out = -1;
+  *ino_out = -1;
+
+  if( f->fp ) err = sys_fstat(fileno(f->fp), &stats);
+  else if( f->fd != -1 ) err = sys_fstat(f->fd, &stats);
+  else QIO_RETURN_CONSTANT_ERROR(ENOSYS, "no fd");
+
+  if( ! err ) {
+    *dev_out = stats.st_dev;
+    *ino_out = stats.st_ino;
+  }
+  return qio_int_to_err(err);
+}
+
+qioerr qio_file_pread_amt(qio_file_t* f, void* ptr, ssize_t len, int64_t offset)
+{
+  ssize_t num;
+  err_t err = 0;
+
+  if( f->fd == -1 ) QIO_RETURN_CONSTANT_ERROR(ENOSYS, "no fd");
+
+  while( len > 0 ) {
+    num = 0;
+    err = sys_pread(f->fd, ptr, len, offset, &num);
+    if( err ) break;
+    ptr = VOID_PTR_ADD(ptr, num);
+    len -= num;
+    offset += num;
+  }
+
+  return qio_int_to_err(err);
+}
+
 /* CHANNELS ----------------------------- */
 static
 qioerr _qio_channel_init(qio_channel_t* ch, qio_chtype_t type)
@@ -1750,6 +2146,220 @@ qioerr qio_channel_path_offset(const int threadsafe, qio_channel_t* ch, const ch
   return err;
 }
 
+// Read-ahead and write-behind pipelining.
+//
+// A pipelined channel keeps up to qio_pipeline_iobufs requests in
+// flight on the asynchronous engine, one per buffer part. For reading,
+// the parts being read are the space the channel buffer already keeps
+// past av_end, so data is made available by moving av_end over a
+// completed request. For writing, parts that _qio_buffered_behind
+// removes from the front of the buffer stay retained by the request
+// writing them out. Requests always complete in the order they were
+// issued as far as the channel is concerned.
+typedef struct qio_pipe_req_s {
+  qio_aio_req_t req;
+  struct iovec iov;
+  qbytes_t* bytes; // retained until the request is reaped
+} qio_pipe_req_t;
+
+typedef struct qio_pipeline_s {
+  ssize_t depth;
+  ssize_t head; // slot of the oldest request in flight
+  ssize_t count;
+  int eof; // a read-ahead came back short; stop reading ahead
+  qioerr err; // write-behind error, reported until the channel closes
+  qio_pipe_req_t reqs[1]; // really depth of them
+} qio_pipeline_t;
+
+static
+ssize_t _qio_pipeline_depth(void)
+{
+  if( qio_pipeline_iobufs < 0 ) {
+    const char* env = getenv("CHPL_RT_QIO_PIPELINE_DEPTH");
+    ssize_t depth = 4;
+    if( env ) depth = atoi(env);
+    if( depth < 0 ) depth = 0;
+    qio_pipeline_iobufs = depth;
+  }
+  return qio_pipeline_iobufs;
+}
+
+// Returns the pipeline for a channel that should have one, or NULL.
+// Only buffered channels doing positional I/O in one direction are
+// pipelined: always with QIO_METHOD_ASYNC, and with
+// QIO_METHOD_PREADPWRITE when QIO_HINT_SEQUENTIAL is given.
+static
+qio_pipeline_t* _qio_channel_pipeline(qio_channel_t* ch)
+{
+  qio_method_t method = (qio_method_t) (ch->hints & QIO_METHODMASK);
+  int readable = (ch->flags & QIO_FDFLAG_READABLE) != 0;
+  int writeable = (ch->flags & QIO_FDFLAG_WRITEABLE) != 0;
+  ssize_t depth;
+  qio_pipeline_t* pipe;
+
+  if( ch->pipe ) return ch->pipe;
+
+  if( !( method == QIO_METHOD_ASYNC ||
+         (method == QIO_METHOD_PREADPWRITE &&
+          (ch->hints & QIO_HINT_SEQUENTIAL)) ) ) return NULL;
+  if( (ch->hints & QIO_CHTYPEMASK) != QIO_CH_BUFFERED ) return NULL;
+  if( ch->hints & QIO_HINT_DIRECT ) return NULL;
+  if( readable == writeable ) return NULL;
+  if( ch->file == NULL || ch->file->fd == -1 ) return NULL;
+
+  depth = _qio_pipeline_depth();
+  if( depth == 0 ) return NULL;
+
+  pipe = (qio_pipeline_t*) qio_calloc(1, sizeof(qio_pipeline_t) +
+                                         (depth - 1) * sizeof(qio_pipe_req_t));
+  if( ! pipe ) return NULL;
+  pipe->depth = depth;
+
+  ch->pipe = pipe;
+  return pipe;
+}
+
+// Starts I/O on len bytes of a buffer part at the given file offset.
+static
+qioerr _qio_pipeline_submit(qio_channel_t* ch, qio_pipeline_t* pipe, qio_aio_op_t op, qbytes_t* bytes, int64_t skip, int64_t len, int64_t offset)
+{
+  qio_pipe_req_t* r = &pipe->reqs[(pipe->head + pipe->count) % pipe->depth];
+  err_t err;
+
+  r->iov.iov_base = VOID_PTR_ADD(bytes->data, skip);
+  r->iov.iov_len = len;
+  r->bytes = bytes;
+  qio_aio_req_init(&r->req, op, ch->file->fd, &r->iov, 1, offset);
+
+  err = qio_aio_submit(&r->req);
+  if( err ) return qio_int_to_err(err);
+
+  qbytes_retain(bytes);
+  pipe->count++;
+  return 0;
+}
+
+// Waits for the oldest request and removes it from the pipeline.
+// For a write, also finishes a short write and records any error.
+static
+err_t _qio_pipeline_reap(qio_pipeline_t* pipe, ssize_t* num_out)
+{
+  qio_pipe_req_t* r = &pipe->reqs[pipe->head];
+  ssize_t num = 0;
+  err_t err;
+
+  err = qio_aio_wait(&r->req, &num);
+
+  if( r->req.op == QIO_AIO_WRITE ) {
+    while( !err && num < (ssize_t) r->iov.iov_len ) {
+      ssize_t more = 0;
+      err = sys_pwrite(r->req.fd, VOID_PTR_ADD(r->iov.iov_base, num),
+                       r->iov.iov_len - num, r->req.offset + num, &more);
+      num += more;
+    }
+    if( err && ! pipe->err ) pipe->err = qio_int_to_err(err);
+  }
+
+  qbytes_release(r->bytes);
+  r->bytes = NULL;
+  pipe->head = (pipe->head + 1) % pipe->depth;
+  pipe->count--;
+
+  *num_out = num;
+  return err;
+}
+
+// Wait for everything in flight. Any read-ahead data is dropped
+// (it stays in the buffer past av_end as unread space).
+static
+void _qio_pipeline_drain(qio_pipeline_t* pipe)
+{
+  ssize_t num;
+
+  while( pipe->count > 0 ) {
+    (void) _qio_pipeline_reap(pipe, &num);
+  }
+}
+
+static
+void _qio_channel_free_pipeline(qio_channel_t* ch)
+{
+  if( ch->pipe ) {
+    _qio_pipeline_drain(ch->pipe);
+    qio_free(ch->pipe);
+    ch->pipe = NULL;
+  }
+}
+
+// Move av_end over completed read-ahead until amt more bytes are
+// available or nothing more is in flight. Decrements *amt_inout.
+static
+void _qio_pipeline_take_readahead(qio_channel_t* ch, qio_pipeline_t* pipe, int64_t* amt_inout)
+{
+  int64_t amt = *amt_inout;
+  ssize_t num;
+  ssize_t len;
+  err_t err;
+
+  while( amt > 0 && pipe->count > 0 ) {
+    len = pipe->reqs[pipe->head].iov.iov_len;
+    assert( pipe->reqs[pipe->head].req.offset == ch->av_end );
+    err = _qio_pipeline_reap(pipe, &num);
+    if( err ) num = 0;
+    ch->av_end += num;
+    amt -= num;
+    if( num < len ) {
+      // End of file or an error. Anything after this isn't contiguous;
+      // the synchronous path will retry from av_end and report it.
+      pipe->eof = 1;
+      _qio_pipeline_drain(pipe);
+    }
+  }
+
+  *amt_inout = amt;
+}
+
+// Start reading the parts after the data we have, up to the depth.
+static
+void _qio_pipeline_readahead(qio_channel_t* ch, qio_pipeline_t* pipe)
+{
+  int64_t next;
+  int64_t len;
+  qbytes_t* tmp;
+  qioerr err;
+
+  if( pipe->eof ) return;
+
+  if( pipe->count == 0 ) {
+    // Unread space left past av_end isn't in parts we can use.
+    int64_t extra = qbuffer_end_offset(&ch->buf) - ch->av_end;
+    if( extra > 0 ) qbuffer_trim_back(&ch->buf, extra);
+    if( qbuffer_end_offset(&ch->buf) != ch->av_end ) return;
+  }
+
+  next = qbuffer_end_offset(&ch->buf);
+
+  while( pipe->count < pipe->depth ) {
+    if( next >= ch->end_pos ) break;
+
+    err = qbytes_create_iobuf(&tmp);
+    if( err ) break;
+    len = tmp->len;
+    if( len > ch->end_pos - next ) len = ch->end_pos - next;
+
+    err = qbuffer_append(&ch->buf, tmp, 0, len);
+    if( !err ) {
+      err = _qio_pipeline_submit(ch, pipe, QIO_AIO_READ, tmp, 0, len, next);
+      if( err ) qbuffer_trim_back(&ch->buf, len);
+    }
+    // the buffer and the request hold their own references.
+    qbytes_release(tmp);
+    if( err ) break;
+
+    next += len;
+  }
+}
+
 qioerr _qio_channel_final_flush_unlocked(qio_channel_t* ch)
 {
   qioerr err = 0;
@@ -1806,6 +2416,9 @@ qioerr _qio_channel_final_flush_unlocked(qio_channel_t* ch)
   // set end_pos to the current position.
   ch->end_pos = qio_channel_offset_unlocked(ch);
 
+  // Nothing may be in flight into or out of the buffer.
+  _qio_channel_free_pipeline(ch);
+
   if( qbuffer_is_initialized(&ch->buf) ) {
     // Destroy the buffer.
     err = qbuffer_destroy(&ch->buf);
@@ -1906,16 +2519,28 @@ qioerr _buffered_allocate_bufferspace(qio_channel_t* ch, int64_t amt, int64_t ma
   int64_t left = amt;
   int64_t max_left = max_amt;
   int64_t uselen;
+  int64_t skip;
+  int64_t align = 0;
   qbytes_t* tmp;
   qioerr err;
 
+  // For direct I/O, start each iobuf at the same offset within a page
+  // as the file position it holds, so that whole pages of the file
+  // are also whole pages of memory.
+  if( ch->hints & QIO_HINT_DIRECT ) align = sys_page_size();
+
   // allocate some space!
   while( left > 0 ) {
     err = qbytes_create_iobuf(&tmp);
     if( err ) goto error;
-    uselen = tmp->len;
+    skip = 0;
+    if( align ) {
+      skip = qbuffer_end_offset(&ch->buf) % align;
+      if( skip >= tmp->len ) skip = 0;
+    }
+    uselen = tmp->len - skip;
     if( uselen > max_left ) uselen = max_left;
-    err = qbuffer_append(&ch->buf, tmp, 0, uselen);
+    err = qbuffer_append(&ch->buf, tmp, skip, uselen);
     // qbuffer_append retains tmp, so we can release our local reference.
     // If there was an error, then it is not retained anywhere, so it is
     // reclaimed here.
@@ -2205,6 +2830,7 @@ qioerr _buffered_read_atleast(qio_channel_t* ch, int64_t amt)
   int return_eof = 0;
   qioerr err;
   qio_method_t method = (qio_method_t) (ch->hints & QIO_METHODMASK);
+  qio_pipeline_t* pipe;
 
   err = _qio_channel_needbuffer_unlocked(ch);
   if( err ) return err;
@@ -2221,6 +2847,18 @@ qioerr _buffered_read_atleast(qio_channel_t* ch, int64_t amt)
     return_eof = 1;
   }
 
+  pipe = _qio_channel_pipeline(ch);
+  if( pipe ) {
+    _qio_pipeline_take_readahead(ch, pipe, &amt);
+    if( amt <= 0 ) {
+      _qio_pipeline_readahead(ch, pipe);
+      if( return_eof ) return QIO_EEOF;
+      else return 0;
+    }
+    max_amt = INT64_MAX;
+    if( ch->end_pos < INT64_MAX ) max_amt = ch->end_pos - ch->av_end;
+  }
+
   //printf("Allocating bufferspace %lli\n", (long long int) amt);
   err = _buffered_allocate_bufferspace(ch, amt, max_amt);
   if( err ) return err;
@@ -2242,7 +2880,13 @@ qioerr _buffered_read_atleast(qio_channel_t* ch, int64_t amt)
         err = qio_readv(ch->file, &ch->buf, read_start, read_end, &num_read);
         break;
       case QIO_METHOD_PREADPWRITE:
-        err = qio_preadv(ch->file, &ch->buf, read_start, read_end, read_start.offset, &num_read);
+        if( ch->hints & QIO_HINT_DIRECT )
+          err = _qio_direct_rw(ch->file, 0, &ch->buf, read_start, read_end, &num_read);
+        else
+          err = qio_preadv(ch->file, &ch->buf, read_start, read_end, read_start.offset, &num_read);
+        break;
+      case QIO_METHOD_ASYNC:
+        err = qio_async_preadv(ch->file, &ch->buf, read_start, read_end, read_start.offset, &num_read);
         break;
       case QIO_METHOD_FREADFWRITE:
         err = qio_freadv(ch->file->fp, &ch->buf, read_start, read_end, &num_read);
@@ -2265,6 +2909,8 @@ qioerr _buffered_read_atleast(qio_channel_t* ch, int64_t amt)
 
   if( err ) return err;
 
+  if( pipe ) _qio_pipeline_readahead(ch, pipe);
+
   if( return_eof ) return QIO_EEOF;
   else return 0;
 }
@@ -2424,6 +3070,7 @@ qioerr _qio_buffered_behind(qio_channel_t* ch, int flushall)
   qioerr err;
   ssize_t num_written;
   qio_method_t method = (qio_method_t) (ch->hints & QIO_METHODMASK);
+  qio_pipeline_t* pipe = _qio_channel_pipeline(ch);
 
   // If we are a FILE* type buffer, we want to automatically
   // flush after every write, so that C I/O can be intermixed
@@ -2454,12 +3101,28 @@ qioerr _qio_buffered_behind(qio_channel_t* ch, int flushall)
   //fprintf(stderr, "starting write\n");
   //debug_print_qbuffer(&ch->buf);
 
-  if(ch->hints & QIO_HINT_DIRECT) {
-    // Round out the data to write to the end of the current chunk.
-    qbuffer_iter_ceil_part(&ch->buf, &write_end);
-  }
+  if( pipe && (ch->flags & QIO_FDFLAG_WRITEABLE) ) {
+    // Write each part behind; the pipeline holds on to the parts.
+    while( qbuffer_iter_num_bytes(write_start, write_end) > 0 ) {
+      qbytes_t* bytes;
+      int64_t skip;
+      int64_t len;
 
-  if(ch->flags & QIO_FDFLAG_WRITEABLE) {
+      if( pipe->err ) {
+        err = pipe->err;
+        goto error;
+      }
+      if( pipe->count == pipe->depth ) {
+        (void) _qio_pipeline_reap(pipe, &num_written);
+        continue;
+      }
+
+      qbuffer_iter_get(write_start, write_end, &bytes, &skip, &len);
+      err = _qio_pipeline_submit(ch, pipe, QIO_AIO_WRITE, bytes, skip, len, write_start.offset);
+      if( err ) goto error;
+      qbuffer_iter_advance(&ch->buf, &write_start, len);
+    }
+  } else if(ch->flags & QIO_FDFLAG_WRITEABLE) {
     while( qbuffer_iter_num_bytes(write_start, write_end) > 0 ) {
       QIO_GET_CONSTANT_ERROR(err, EINVAL, "write method not implemented");
       num_written = 0;
@@ -2468,7 +3131,13 @@ qioerr _qio_buffered_behind(qio_channel_t* ch, int flushall)
           err = qio_writev(ch->file, &ch->buf, write_start, write_end, &num_written);
           break;
         case QIO_METHOD_PREADPWRITE:
-          err = qio_pwritev(ch->file, &ch->buf, write_start, write_end, write_start.offset, &num_written);
+          if( ch->hints & QIO_HINT_DIRECT )
+            err = _qio_direct_rw(ch->file, 1, &ch->buf, write_start, write_end, &num_written);
+          else
+            err = qio_pwritev(ch->file, &ch->buf, write_start, write_end, write_start.offset, &num_written);
+          break;
+        case QIO_METHOD_ASYNC:
+          err = qio_async_pwritev(ch->file, &ch->buf, write_start, write_end, write_start.offset, &num_written);
           break;
         case QIO_METHOD_FREADFWRITE:
           err = qio_fwritev(ch->file->fp, &ch->buf, write_start, write_end, &num_written);
@@ -2488,6 +3157,10 @@ qioerr _qio_buffered_behind(qio_channel_t* ch, int flushall)
   } else {
     // just pretend like we wrote it; in fact we just deallocate
     // the buffer space below.
+    if( pipe && pipe->count > 0 && write_end.offset > ch->av_end ) {
+      // Skipping past the read-ahead; don't keep it around.
+      _qio_pipeline_drain(pipe);
+    }
     write_start = write_end;
   }
 
@@ -2505,6 +3178,12 @@ error:
   //debug_print_qbuffer(&ch->buf);
 
 done:
+  if( pipe && (ch->flags & QIO_FDFLAG_WRITEABLE) ) {
+    // A flush waits for the writes behind to finish.
+    if( flushall ) _qio_pipeline_drain(pipe);
+    if( !err ) err = pipe->err;
+  }
+
   if( !err ) {
     _qio_buffered_setup_cached(ch);
   }
@@ -2693,6 +3372,14 @@ qioerr _qio_unbuffered_write(qio_channel_t* ch, const void* ptr, ssize_t len_in,
         case QIO_METHOD_PREADPWRITE:
           err = qio_int_to_err(sys_pwrite(ch->file->fd, ptr, len, _right_mark_start(ch), &num_written));
           break;
+        case QIO_METHOD_ASYNC:
+          {
+            struct iovec one;
+            one.iov_base = (void*) ptr;
+            one.iov_len = len;
+            err = qio_int_to_err(qio_aio_pwritev(ch->file->fd, &one, 1, _right_mark_start(ch), &num_written));
+          }
+          break;
         case QIO_METHOD_FREADFWRITE:
           if( ch->file->fp ) {
             num_written_u = fwrite(ptr, 1, len, ch->file->fp);
@@ -2765,7 +3452,8 @@ qioerr _qio_unbuffered_read(qio_channel_t* ch, void* ptr, ssize_t len_in, ssize_
   len = len_in;
 
   if( ch->file->mmap &&
-      (method == QIO_METHOD_PREADPWRITE || method == QIO_METHOD_MMAP) &&
+      (method == QIO_METHOD_PREADPWRITE || method == QIO_METHOD_MMAP ||
+       method == QIO_METHOD_ASYNC) &&
       _right_mark_start(ch) + len <= ch->file->mmap->len) {
     // As long as we're using an I/O method that seeks on every read,
     // copy the data out of the mmap.
@@ -2783,6 +3471,14 @@ qioerr _qio_unbuffered_read(qio_channel_t* ch, void* ptr, ssize_t len_in, ssize_
         case QIO_METHOD_PREADPWRITE:
           err = qio_int_to_err(sys_pread(ch->file->fd, ptr, len, _right_mark_start(ch), &num_read));
           break;
+        case QIO_METHOD_ASYNC:
+          {
+            struct iovec one;
+            one.iov_base = ptr;
+            one.iov_len = len;
+            err = qio_int_to_err(qio_aio_preadv(ch->file->fd, &one, 1, _right_mark_start(ch), &num_read));
+          }
+          break;
         case QIO_METHOD_FREADFWRITE:
           if( ch->file->fp ) {
             num_read_u = fread(ptr, 1, len, ch->file->fp);
@@ -3567,6 +4263,111 @@ qioerr qio_channel_advance(const int threadsafe, qio_channel_t* ch, int64_t nbyt
   return err;
 }
 
+// Only positional methods; read/write would need the fd moved too.
+static
+int _qio_channel_can_skip_external(qio_channel_t* ch)
+{
+  qio_method_t method = (qio_method_t) (ch->hints & QIO_METHODMASK);
+
+  return ch->mark_cur == 0 &&
+         (method == QIO_METHOD_PREADPWRITE || method == QIO_METHOD_MMAP ||
+          method == QIO_METHOD_ASYNC) &&
+         ch->file != NULL && ch->file->fd != -1;
+}
+
+qioerr qio_channel_external_file(const int threadsafe, qio_channel_t* ch, const char** path_out, int64_t* dev_out, int64_t* ino_out)
+{
+  qioerr err;
+
+  *path_out = NULL;
+  *dev_out = -1;
+  *ino_out = -1;
+
+  if( threadsafe ) {
+    err = qio_lock(&ch->lock);
+    if( err ) {
+      return err;
+    }
+  }
+
+  if( ! _qio_channel_can_skip_external(ch) ) {
+    QIO_GET_CONSTANT_ERROR(err, ENOSYS, "channel cannot skip for external I/O");
+    goto unlock;
+  }
+
+  err = qio_file_identity(ch->file, dev_out, ino_out);
+  if( err ) goto unlock;
+
+  err = qio_file_path(ch->file, path_out);
+
+unlock:
+  if( threadsafe ) {
+    qio_unlock(&ch->lock);
+  }
+
+  return err;
+}
+
+qioerr qio_channel_skip_external(const int threadsafe, qio_channel_t* ch, int64_t nbytes, const char** path_out, int64_t* offset_out)
+{
+  int64_t start;
+  qioerr err;
+
+  *path_out = NULL;
+  *offset_out = -1;
+
+  if( nbytes < 0 )
+    QIO_RETURN_CONSTANT_ERROR(EINVAL, "negative count");
+
+  if( threadsafe ) {
+    err = qio_lock(&ch->lock);
+    if( err ) {
+      return err;
+    }
+  }
+
+  if( ! _qio_channel_can_skip_external(ch) ) {
+    QIO_GET_CONSTANT_ERROR(err, ENOSYS, "channel cannot skip for external I/O");
+    goto unlock;
+  }
+
+  // Everything before the region has to be in the file first.
+  err = _qio_channel_flush_unlocked(ch);
+  if( err ) goto unlock;
+
+  start = qio_channel_offset_unlocked(ch);
+  if( start + nbytes > ch->end_pos ) {
+    QIO_GET_CONSTANT_ERROR(err, EINVAL, "region is past the end of the channel");
+    goto unlock;
+  }
+
+  err = qio_file_path(ch->file, path_out);
+  if( err ) goto unlock;
+
+  // Drop anything buffered (unwritten space or read-ahead data), since
+  // the region is about to be transferred by someone else.
+  if( ch->pipe ) _qio_pipeline_drain(ch->pipe);
+  if( qbuffer_is_initialized(&ch->buf) ) {
+    qbuffer_trim_back(&ch->buf, qbuffer_end_offset(&ch->buf) -
+                                qbuffer_start_offset(&ch->buf));
+    qbuffer_reposition(&ch->buf, start + nbytes);
+  }
+  ch->cached_cur = NULL;
+  ch->cached_start = NULL;
+  ch->cached_end = NULL;
+  ch->mark_stack[0] = start + nbytes;
+  ch->av_end = start + nbytes;
+
+  *offset_out = start;
+
+unlock:
+  if( threadsafe ) {
+    qio_unlock(&ch->lock);
+  }
+
+  return err;
+}
+
 /* Handle I/O of bits at a time */
 void _qio_channel_write_bits_cached_realign(qio_channel_t* restrict ch, uint64_t v, int8_t nbits)
 {
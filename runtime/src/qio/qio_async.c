@@ -0,0 +1,503 @@
+/*
+ * Copyright 2004-2015 Cray Inc.
+ * Other additional copyright holders may be indicated within.
+ * 
+ * The entirety of this work is licensed under the Apache License,
+ * Version 2.0 (the "License"); you may not use this file except
+ * in compliance with the License.
+ * 
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#ifndef CHPL_RT_UNIT_TEST
+#include "chplrt.h"
+#include "chpl-tasks.h"
+#endif
+
+#include "qio_async.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+#if defined(__NR_io_uring_setup) && defined(__NR_io_uring_enter)
+#define QIO_AIO_HAS_URING 1
+#endif
+#endif
+#endif
+
+#ifndef QIO_AIO_HAS_URING
+#define QIO_AIO_HAS_URING 0
+#endif
+
+#define QIO_AIO_DEFAULT_THREADS 4
+#define QIO_AIO_URING_ENTRIES 64
+
+typedef enum {
+  QIO_AIO_ENGINE_NONE = 0,
+  QIO_AIO_ENGINE_URING,
+  QIO_AIO_ENGINE_THREADS,
+} qio_aio_engine_t;
+
+static pthread_once_t aio_once = PTHREAD_ONCE_INIT;
+static qio_aio_engine_t aio_engine = QIO_AIO_ENGINE_NONE;
+
+static inline
+void aio_yield(void)
+{
+#ifdef CHPL_RT_UNIT_TEST
+  sched_yield();
+#else
+  chpl_task_yield();
+#endif
+}
+
+static
+void aio_complete(qio_aio_req_t* req, ssize_t result, err_t err)
+{
+  if( err == 0 && result == 0 && req->op == QIO_AIO_READ &&
+      sys_iov_total_bytes(req->iov, req->iovcnt) != 0 ) {
+    err = EEOF;
+  }
+  req->result = result;
+  req->err = err;
+  // The waiter may reuse req as soon as it sees done.
+  atomic_store_explicit_int_least32_t(&req->done, 1, memory_order_release);
+}
+
+static
+void aio_run_sync(qio_aio_req_t* req)
+{
+  ssize_t num = 0;
+  err_t err;
+
+  if( req->op == QIO_AIO_READ ) {
+    err = sys_preadv(req->fd, req->iov, req->iovcnt, req->offset, &num);
+  } else {
+    err = sys_pwritev(req->fd, req->iov, req->iovcnt, req->offset, &num);
+  }
+  // sys_preadv already reports EEOF.
+  req->result = num;
+  req->err = err;
+  atomic_store_explicit_int_least32_t(&req->done, 1, memory_order_release);
+}
+
+
+// ---------------------------------------------------------------------
+// io_uring engine
+//
+// The rings are driven directly with the io_uring_setup and
+// io_uring_enter system calls.  Submission is serialized by sq_lock.
+// There is no completion thread: any task waiting on a request drains
+// the completion queue (whoever gets cq_lock) and marks the requests
+// it finds done.
+// ---------------------------------------------------------------------
+
+#if QIO_AIO_HAS_URING
+
+static struct {
+  int fd;
+  unsigned sq_entries;
+  unsigned* sq_head;
+  unsigned* sq_tail;
+  unsigned* sq_mask;
+  unsigned* sq_array;
+  struct io_uring_sqe* sqes;
+  unsigned cq_entries;
+  unsigned* cq_head;
+  unsigned* cq_tail;
+  unsigned* cq_mask;
+  struct io_uring_cqe* cqes;
+  pthread_mutex_t sq_lock;
+  pthread_mutex_t cq_lock;
+  unsigned inflight; // updated with __atomic builtins
+} uring;
+
+static
+int uring_enter(unsigned to_submit, unsigned min_complete, unsigned flags)
+{
+  return (int) syscall(__NR_io_uring_enter, uring.fd, to_submit,
+                       min_complete, flags, NULL, 0);
+}
+
+static
+int uring_init(void)
+{
+  struct io_uring_params p;
+  size_t sq_len, cq_len, sqe_len;
+  void* sq;
+  void* cq;
+  void* sqes;
+  int fd;
+
+  memset(&p, 0, sizeof(p));
+  fd = (int) syscall(__NR_io_uring_setup, QIO_AIO_URING_ENTRIES, &p);
+  if( fd < 0 ) return 0;
+
+  sq_len = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+  cq_len = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+  sqe_len = p.sq_entries * sizeof(struct io_uring_sqe);
+
+  sq = mmap(NULL, sq_len, PROT_READ|PROT_WRITE, MAP_SHARED|MAP_POPULATE,
+            fd, IORING_OFF_SQ_RING);
+  cq = mmap(NULL, cq_len, PROT_READ|PROT_WRITE, MAP_SHARED|MAP_POPULATE,
+            fd, IORING_OFF_CQ_RING);
+  sqes = mmap(NULL, sqe_len, PROT_READ|PROT_WRITE, MAP_SHARED|MAP_POPULATE,
+              fd, IORING_OFF_SQES);
+  if( sq == MAP_FAILED || cq == MAP_FAILED || sqes == MAP_FAILED ) {
+    if( sq != MAP_FAILED ) munmap(sq, sq_len);
+    if( cq != MAP_FAILED ) munmap(cq, cq_len);
+    if( sqes != MAP_FAILED ) munmap(sqes, sqe_len);
+    close(fd);
+    return 0;
+  }
+
+  uring.fd = fd;
+  uring.sq_entries = p.sq_entries;
+  uring.sq_head = (unsigned*) ((char*) sq + p.sq_off.head);
+  uring.sq_tail = (unsigned*) ((char*) sq + p.sq_off.tail);
+  uring.sq_mask = (unsigned*) ((char*) sq + p.sq_off.ring_mask);
+  uring.sq_array = (unsigned*) ((char*) sq + p.sq_off.array);
+  uring.sqes = (struct io_uring_sqe*) sqes;
+  uring.cq_entries = p.cq_entries;
+  uring.cq_head = (unsigned*) ((char*) cq + p.cq_off.head);
+  uring.cq_tail = (unsigned*) ((char*) cq + p.cq_off.tail);
+  uring.cq_mask = (unsigned*) ((char*) cq + p.cq_off.ring_mask);
+  uring.cqes = (struct io_uring_cqe*) ((char*) cq + p.cq_off.cqes);
+  uring.inflight = 0;
+  pthread_mutex_init(&uring.sq_lock, NULL);
+  pthread_mutex_init(&uring.cq_lock, NULL);
+
+  return 1;
+}
+
+// Hand any queued but not yet consumed entries to the kernel.
+// Call with sq_lock held.
+static
+void uring_flush_locked(void)
+{
+  unsigned tail = *uring.sq_tail;
+  unsigned head = __atomic_load_n(uring.sq_head, __ATOMIC_ACQUIRE);
+
+  if( tail != head ) {
+    // EINTR/EAGAIN/EBUSY leave the entries queued; the next flush
+    // (from a later submit or from a waiter) will retry.
+    (void) uring_enter(tail - head, 0, 0);
+  }
+}
+
+// Returns 0 if queued, EAGAIN if the rings are full.
+static
+err_t uring_submit(qio_aio_req_t* req)
+{
+  struct io_uring_sqe* sqe;
+  unsigned tail, head, idx;
+
+  pthread_mutex_lock(&uring.sq_lock);
+
+  tail = *uring.sq_tail;
+  head = __atomic_load_n(uring.sq_head, __ATOMIC_ACQUIRE);
+  // Bound the requests in flight by the CQ size so completions
+  // can never overflow the completion ring.
+  if( tail - head >= uring.sq_entries ||
+      __atomic_load_n(&uring.inflight, __ATOMIC_RELAXED) >= uring.cq_entries ) {
+    pthread_mutex_unlock(&uring.sq_lock);
+    return EAGAIN;
+  }
+
+  idx = tail & *uring.sq_mask;
+  sqe = &uring.sqes[idx];
+  memset(sqe, 0, sizeof(*sqe));
+  sqe->opcode = (req->op == QIO_AIO_READ) ? IORING_OP_READV : IORING_OP_WRITEV;
+  sqe->fd = req->fd;
+  sqe->addr = (uint64_t) (uintptr_t) req->iov;
+  sqe->len = req->iovcnt;
+  sqe->off = (uint64_t) req->offset;
+  sqe->user_data = (uint64_t) (uintptr_t) req;
+  uring.sq_array[idx] = idx;
+
+  __atomic_fetch_add(&uring.inflight, 1, __ATOMIC_RELAXED);
+  __atomic_store_n(uring.sq_tail, tail + 1, __ATOMIC_RELEASE);
+
+  uring_flush_locked();
+
+  pthread_mutex_unlock(&uring.sq_lock);
+  return 0;
+}
+
+static
+void uring_poll(int enter)
+{
+  unsigned head, tail;
+
+  if( __atomic_load_n(uring.sq_head, __ATOMIC_ACQUIRE) !=
+      __atomic_load_n(uring.sq_tail, __ATOMIC_ACQUIRE) ) {
+    if( pthread_mutex_trylock(&uring.sq_lock) == 0 ) {
+      uring_flush_locked();
+      pthread_mutex_unlock(&uring.sq_lock);
+    }
+  } else if( enter ) {
+    // Give the kernel a chance to run deferred completion work
+    // for requests submitted from this thread.  Does not block.
+    (void) uring_enter(0, 0, IORING_ENTER_GETEVENTS);
+  }
+
+  if( pthread_mutex_trylock(&uring.cq_lock) != 0 ) return;
+
+  head = *uring.cq_head;
+  tail = __atomic_load_n(uring.cq_tail, __ATOMIC_ACQUIRE);
+  while( head != tail ) {
+    struct io_uring_cqe* cqe = &uring.cqes[head & *uring.cq_mask];
+    qio_aio_req_t* req = (qio_aio_req_t*) (uintptr_t) cqe->user_data;
+    int res = cqe->res;
+
+    head++;
+    __atomic_store_n(uring.cq_head, head, __ATOMIC_RELEASE);
+    __atomic_fetch_sub(&uring.inflight, 1, __ATOMIC_RELAXED);
+
+    if( res < 0 ) aio_complete(req, 0, -res);
+    else aio_complete(req, res, 0);
+  }
+
+  pthread_mutex_unlock(&uring.cq_lock);
+}
+
+#endif // QIO_AIO_HAS_URING
+
+
+// ---------------------------------------------------------------------
+// thread pool engine
+// ---------------------------------------------------------------------
+
+static struct {
+  pthread_mutex_t lock;
+  pthread_cond_t cond;
+  qio_aio_req_t* head;
+  qio_aio_req_t* tail;
+  int nthreads;
+} pool;
+
+static
+void* pool_worker(void* arg)
+{
+  qio_aio_req_t* req;
+
+  while( 1 ) {
+    pthread_mutex_lock(&pool.lock);
+    while( pool.head == NULL ) pthread_cond_wait(&pool.cond, &pool.lock);
+    req = pool.head;
+    pool.head = req->next;
+    if( pool.head == NULL ) pool.tail = NULL;
+    pthread_mutex_unlock(&pool.lock);
+
+    aio_run_sync(req);
+  }
+
+  return NULL;
+}
+
+static
+void pool_init(void)
+{
+  const char* env = getenv("CHPL_RT_QIO_ASYNC_THREADS");
+  int want = QIO_AIO_DEFAULT_THREADS;
+  pthread_attr_t attr;
+  pthread_t thread;
+  int i;
+
+  if( env && atoi(env) > 0 ) want = atoi(env);
+
+  pthread_mutex_init(&pool.lock, NULL);
+  pthread_cond_init(&pool.cond, NULL);
+  pool.head = NULL;
+  pool.tail = NULL;
+  pool.nthreads = 0;
+
+  pthread_attr_init(&attr);
+  pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+  for( i = 0; i < want; i++ ) {
+    if( pthread_create(&thread, &attr, pool_worker, NULL) != 0 ) break;
+    pool.nthreads++;
+  }
+  pthread_attr_destroy(&attr);
+}
+
+static
+void pool_submit(qio_aio_req_t* req)
+{
+  if( pool.nthreads == 0 ) {
+    // Could not start any helper threads; do the I/O right here.
+    aio_run_sync(req);
+    return;
+  }
+
+  req->next = NULL;
+  pthread_mutex_lock(&pool.lock);
+  if( pool.tail ) pool.tail->next = req;
+  else pool.head = req;
+  pool.tail = req;
+  pthread_cond_signal(&pool.cond);
+  pthread_mutex_unlock(&pool.lock);
+}
+
+
+// ---------------------------------------------------------------------
+// interface
+// ---------------------------------------------------------------------
+
+static
+void aio_init(void)
+{
+  const char* env = getenv("CHPL_RT_QIO_ASYNC");
+  int want_threads = (env && 0 == strcmp(env, "threads"));
+
+#if QIO_AIO_HAS_URING
+  if( !want_threads && uring_init() ) {
+    aio_engine = QIO_AIO_ENGINE_URING;
+    return;
+  }
+#else
+  (void) want_threads;
+#endif
+
+  pool_init();
+  aio_engine = QIO_AIO_ENGINE_THREADS;
+}
+
+static inline
+void aio_ensure_init(void)
+{
+  pthread_once(&aio_once, aio_init);
+}
+
+static inline
+void aio_poll(int enter)
+{
+#if QIO_AIO_HAS_URING
+  if( aio_engine == QIO_AIO_ENGINE_URING ) uring_poll(enter);
+#endif
+}
+
+const char* qio_aio_engine_name(void)
+{
+  aio_ensure_init();
+  return (aio_engine == QIO_AIO_ENGINE_URING) ? "uring" : "threads";
+}
+
+void qio_aio_req_init(qio_aio_req_t* req, qio_aio_op_t op, fd_t fd,
+                      const struct iovec* iov, int iovcnt, off_t offset)
+{
+  req->op = op;
+  req->fd = fd;
+  req->iov = iov;
+  req->iovcnt = iovcnt;
+  req->offset = offset;
+  req->result = 0;
+  req->err = 0;
+  atomic_init_int_least32_t(&req->done, 0);
+  req->next = NULL;
+}
+
+err_t qio_aio_submit(qio_aio_req_t* req)
+{
+  if( req->iovcnt < 0 || req->iovcnt > IOV_MAX ) return EINVAL;
+
+  aio_ensure_init();
+
+#if QIO_AIO_HAS_URING
+  if( aio_engine == QIO_AIO_ENGINE_URING ) {
+    // If the rings are full, help drain them and try again.
+    while( uring_submit(req) == EAGAIN ) {
+      uring_poll(1);
+      aio_yield();
+    }
+    return 0;
+  }
+#endif
+
+  pool_submit(req);
+  return 0;
+}
+
+int qio_aio_test(qio_aio_req_t* req)
+{
+  if( atomic_load_explicit_int_least32_t(&req->done, memory_order_acquire) )
+    return 1;
+  aio_poll(0);
+  return atomic_load_explicit_int_least32_t(&req->done, memory_order_acquire);
+}
+
+err_t qio_aio_wait(qio_aio_req_t* req, ssize_t* num_out)
+{
+  unsigned spins = 0;
+
+  while( ! atomic_load_explicit_int_least32_t(&req->done, memory_order_acquire) ) {
+    aio_poll((++spins & 63) == 0);
+    if( atomic_load_explicit_int_least32_t(&req->done, memory_order_acquire) )
+      break;
+    aio_yield();
+  }
+
+  *num_out = req->result;
+  return req->err;
+}
+
+static
+err_t aio_rw(qio_aio_op_t op, fd_t fd, const struct iovec* iov, int iovcnt, off_t offset, ssize_t* num_out)
+{
+  qio_aio_req_t req;
+  ssize_t total = 0;
+  ssize_t got;
+  err_t err = 0;
+  int i, niovs;
+
+  for( i = 0; i < iovcnt; i += niovs ) {
+    niovs = iovcnt - i;
+    if( niovs > IOV_MAX ) niovs = IOV_MAX;
+
+    qio_aio_req_init(&req, op, fd, &iov[i], niovs, offset + total);
+    err = qio_aio_submit(&req);
+    if( err ) break;
+    err = qio_aio_wait(&req, &got);
+    total += got;
+    if( err ) break;
+    if( got != sys_iov_total_bytes(&iov[i], niovs) ) break;
+  }
+
+  if( err == EEOF && total > 0 ) err = 0;
+
+  *num_out = total;
+  return err;
+}
+
+err_t qio_aio_preadv(fd_t fd, const struct iovec* iov, int iovcnt, off_t seek_to_offset, ssize_t* num_read_out)
+{
+  return aio_rw(QIO_AIO_READ, fd, iov, iovcnt, seek_to_offset, num_read_out);
+}
+
+err_t qio_aio_pwritev(fd_t fd, const struct iovec* iov, int iovcnt, off_t seek_to_offset, ssize_t* num_written_out)
+{
+  return aio_rw(QIO_AIO_WRITE, fd, iov, iovcnt, seek_to_offset, num_written_out);
+}
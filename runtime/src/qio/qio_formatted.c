@@ -884,6 +884,318 @@ qioerr qio_channel_scan_literal_2(const int threadsafe, qio_channel_t* ch, void*
   return qio_channel_scan_literal(threadsafe, ch, (const char*) match, len, skipws);
 }
 
+// Is c a delimiter? (memchr so that a '\0' in the data isn't one)
+static inline
+int _qio_is_delim(char c, const char* delims, size_t ndelims)
+{
+  return memchr(delims, c, ndelims) != NULL;
+}
+
+// Spaces and tabs around a field are ignored, unless they are delimiters.
+static inline
+int _qio_is_field_space(char c, const char* delims, size_t ndelims)
+{
+  return (c == ' ' || c == '\t') && ! _qio_is_delim(c, delims, ndelims);
+}
+
+static
+void _qio_free_fields(ssize_t nfields, const int8_t* types, const char** strs)
+{
+  ssize_t i;
+  for( i = 0; i < nfields; i++ ) {
+    if( types[i] == QIO_FIELD_STRING && strs[i] ) {
+      qio_free((void*) strs[i]);
+      strs[i] = NULL;
+    }
+  }
+}
+
+static
+qioerr _qio_store_field(const char* fs, const char* fe, int has_quotes,
+                        int type, int bits, int64_t* num, double* real,
+                        const char** str)
+{
+  char buf[128];
+  char* end;
+  ssize_t len = fe - fs;
+
+  if( type == QIO_FIELD_SKIP ) return 0;
+
+  if( type == QIO_FIELD_STRING ) {
+    char* s = (char*) qio_malloc(len + 1);
+    ssize_t i, j;
+    if( ! s ) return QIO_ENOMEM;
+    // "" in a quoted field is one "
+    for( i = 0, j = 0; i < len; i++ ) {
+      s[j++] = fs[i];
+      if( has_quotes && fs[i] == '"' ) i++;
+    }
+    s[j] = '\0';
+    *str = s;
+    return 0;
+  }
+
+  // An empty field leaves the value alone.
+  if( len == 0 ) return 0;
+  if( len >= (ssize_t) sizeof(buf) ) {
+    QIO_RETURN_CONSTANT_ERROR(EFORMAT, "numeric field too long");
+  }
+  memcpy(buf, fs, len);
+  buf[len] = '\0';
+
+  errno = 0;
+  if( type == QIO_FIELD_INT ) {
+    *num = strtoll(buf, &end, 10);
+  } else if( type == QIO_FIELD_UINT ) {
+    if( buf[0] == '-' ) {
+      QIO_RETURN_CONSTANT_ERROR(EFORMAT, "negative value in unsigned field");
+    }
+    *num = (int64_t) strtoull(buf, &end, 10);
+  } else if( type == QIO_FIELD_REAL ) {
+    *real = strtod(buf, &end);
+  } else {
+    QIO_RETURN_CONSTANT_ERROR(EINVAL, "bad field type");
+  }
+  if( end != buf + len ) {
+    QIO_RETURN_CONSTANT_ERROR(EFORMAT, "malformed number in field");
+  }
+  if( errno == ERANGE ) {
+    QIO_RETURN_CONSTANT_ERROR(ERANGE, "field value out of bounds");
+  }
+  // A narrower integer must fit in its field.
+  if( bits > 0 && bits < 64 ) {
+    if( type == QIO_FIELD_INT &&
+        (*num < -(INT64_C(1) << (bits - 1)) ||
+         *num > (INT64_C(1) << (bits - 1)) - 1) ) {
+      QIO_RETURN_CONSTANT_ERROR(ERANGE, "field value out of bounds");
+    }
+    if( type == QIO_FIELD_UINT &&
+        (uint64_t) *num > (UINT64_C(1) << bits) - 1 ) {
+      QIO_RETURN_CONSTANT_ERROR(ERANGE, "field value out of bounds");
+    }
+  }
+  return 0;
+}
+
+// Parse one record from [start,end). Returns the number of bytes it
+// used (including the newline), 0 if the record might continue past
+// end (which can only happen if !at_end), or -1 with *err_out set.
+static
+ssize_t _qio_parse_fields(const char* start, const char* end, int at_end,
+                          const char* delims, ssize_t nfields,
+                          const int8_t* types, const int8_t* bits,
+                          int64_t* nums, double* reals,
+                          const char** strs, qioerr* err_out)
+{
+  const char* p = start;
+  size_t ndelims = strlen(delims);
+  int space_delims = _qio_is_delim(' ', delims, ndelims) ||
+                     _qio_is_delim('\t', delims, ndelims);
+  ssize_t i;
+  qioerr err = 0;
+
+  // Skip blank lines (and with space delimiters, leading space).
+  while( 1 ) {
+    const char* q = p;
+    if( space_delims ) {
+      while( q < end && (*q == ' ' || *q == '\t') ) q++;
+      p = q;
+    }
+    if( q < end && *q == '\r' ) q++;
+    if( q < end && *q == '\n' ) p = q + 1;
+    else break;
+  }
+  if( p == end ) {
+    if( ! at_end ) return 0;
+    *err_out = QIO_EEOF;
+    return -1;
+  }
+
+  for( i = 0; i < nfields; i++ ) {
+    const char* fs;
+    const char* fe;
+    int has_quotes = 0;
+
+    while( p < end && _qio_is_field_space(*p, delims, ndelims) ) p++;
+
+    if( p < end && *p == '"' ) {
+      fs = ++p;
+      while( 1 ) {
+        if( p == end || (p + 1 == end && *p == '"' && ! at_end) ) {
+          if( ! at_end ) goto incomplete;
+          QIO_GET_CONSTANT_ERROR(err, EFORMAT, "unterminated quoted field");
+          goto error;
+        }
+        if( *p == '"' ) {
+          if( p + 1 < end && p[1] == '"' ) {
+            has_quotes = 1;
+            p += 2;
+            continue;
+          }
+          break;
+        }
+        p++;
+      }
+      fe = p++;
+      while( p < end && _qio_is_field_space(*p, delims, ndelims) ) p++;
+      if( p < end && *p == '\r' ) {
+        if( p + 1 == end && ! at_end ) goto incomplete;
+        if( p + 1 < end && p[1] == '\n' ) p++;
+      }
+    } else {
+      fs = p;
+      while( p < end && *p != '\n' && ! _qio_is_delim(*p, delims, ndelims) ) {
+        p++;
+      }
+      fe = p;
+      while( fe > fs && (fe[-1] == '\r' ||
+                         _qio_is_field_space(fe[-1], delims, ndelims)) ) {
+        fe--;
+      }
+    }
+
+    if( p == end && ! at_end ) goto incomplete;
+
+    if( i == nfields - 1 ) {
+      if( p < end && *p != '\n' ) {
+        // With space delimiters, trailing space is OK.
+        const char* q = p;
+        if( space_delims ) {
+          while( q < end && (*q == ' ' || *q == '\t' || *q == '\r') ) q++;
+          if( q == end && ! at_end ) goto incomplete;
+        }
+        if( q < end && *q != '\n' ) {
+          QIO_GET_CONSTANT_ERROR(err, EFORMAT, "too many fields in record");
+          goto error;
+        }
+        p = q;
+      }
+      if( p < end ) p++; // the newline
+    } else {
+      if( p == end || *p == '\n' ) {
+        QIO_GET_CONSTANT_ERROR(err, EFORMAT, "too few fields in record");
+        goto error;
+      }
+      if( ! _qio_is_delim(*p, delims, ndelims) ) {
+        QIO_GET_CONSTANT_ERROR(err, EFORMAT, "expected delimiter after field");
+        goto error;
+      }
+      if( *p == ' ' || *p == '\t' ) {
+        // runs of space delimiters count as one
+        while( p < end && (*p == ' ' || *p == '\t') &&
+               _qio_is_delim(*p, delims, ndelims) ) p++;
+        if( p == end && ! at_end ) goto incomplete;
+      } else {
+        p++;
+      }
+    }
+
+    err = _qio_store_field(fs, fe, has_quotes, types[i],
+                           bits ? bits[i] : 64,
+                           &nums[i], &reals[i], &strs[i]);
+    if( err ) goto error;
+  }
+
+  return p - start;
+
+incomplete:
+  _qio_free_fields(nfields, types, strs);
+  return 0;
+
+error:
+  _qio_free_fields(nfields, types, strs);
+  *err_out = err;
+  return -1;
+}
+
+qioerr qio_channel_scan_fields(const int threadsafe, qio_channel_t* restrict ch, const char* restrict delims, ssize_t nfields, const int8_t* restrict types, const int8_t* restrict bits, int64_t* restrict nums, double* restrict reals, const char** restrict strs)
+{
+  qioerr err = 0;
+  ssize_t used = 0;
+  char* buf = NULL;
+  ssize_t buf_len = 0;
+  ssize_t buf_max = 0;
+  int at_end = 0;
+  ssize_t i;
+
+  if( threadsafe ) {
+    err = qio_lock(&ch->lock);
+    if( err ) return err;
+  }
+
+  for( i = 0; i < nfields; i++ ) {
+    if( types[i] == QIO_FIELD_STRING ) strs[i] = NULL;
+  }
+
+  // Fast path: the whole record is in the cached part of the buffer.
+  if( ch->cached_cur && ch->cached_end ) {
+    used = _qio_parse_fields((const char*) ch->cached_cur,
+                             (const char*) ch->cached_end, 0,
+                             delims, nfields, types, bits, nums, reals, strs,
+                             &err);
+    if( used > 0 ) {
+      err = qio_channel_advance_unlocked(ch, used);
+      goto done;
+    }
+    if( used < 0 ) goto done;
+  }
+
+  // Otherwise, gather the record a line at a time and parse it again,
+  // until the parser is happy (a quoted field can contain newlines).
+  err = qio_channel_mark(false, ch);
+  if( err ) goto done;
+
+  while( 1 ) {
+    int32_t c;
+    while( ! at_end ) {
+      c = qio_channel_read_byte(false, ch);
+      if( c == - EEOF ) {
+        at_end = 1;
+        break;
+      }
+      if( c < 0 ) {
+        err = qio_int_to_err(-c);
+        break;
+      }
+      if( buf_len + 1 > buf_max ) {
+        ssize_t new_max = buf_max ? 2 * buf_max : 256;
+        char* new_buf = (char*) qio_realloc(buf, new_max);
+        if( ! new_buf ) {
+          err = QIO_ENOMEM;
+          break;
+        }
+        buf = new_buf;
+        buf_max = new_max;
+      }
+      buf[buf_len++] = (char) c;
+      if( c == '\n' ) break;
+    }
+    if( err ) break;
+
+    used = _qio_parse_fields(buf, buf + buf_len, at_end,
+                             delims, nfields, types, bits, nums, reals, strs,
+                             &err);
+    if( used != 0 ) break;
+  }
+
+  qio_channel_revert_unlocked(ch);
+  if( ! err && used > 0 ) {
+    err = qio_channel_advance_unlocked(ch, used);
+  }
+
+done:
+  if( buf ) qio_free(buf);
+  if( err && qio_err_to_int(err) != EEOF ) {
+    _qio_free_fields(nfields, types, strs);
+    _qio_channel_set_error_unlocked(ch, err);
+  }
+  if( threadsafe ) {
+    qio_unlock(&ch->lock);
+  }
+
+  return err;
+}
+
 
 qioerr qio_channel_print_literal(const int threadsafe, qio_channel_t* restrict ch, const char* restrict ptr, ssize_t len)
 {
@@ -1739,6 +2051,259 @@ error:
 }
 
 
+// Fast paths for scanning numbers written in the common style (decimal,
+// ASCII, '+' '-' '.' and 'e') straight out of the channel's cached
+// buffer. They return 0 without consuming anything if the number is not
+// entirely within the cached area or looks at all unusual; the caller
+// then uses _peek_number_unlocked and strtoull/strtod, which also
+// produce any errors.
+static inline
+int _qio_style_plain_decimal(qio_style_t* style, int real)
+{
+  if( !(style->base == 0 || style->base == 10) ) return 0;
+  if( style->positive_char != '+' || style->negative_char != '-' ) return 0;
+  if( real && (style->point_char != '.' ||
+               tolower(style->exponent_char) != 'e') ) return 0;
+  return 1;
+}
+
+static inline
+int _qio_is_digit(char c)
+{
+  return (unsigned char) (c - '0') < 10;
+}
+
+// Does p start a 0x 0o or 0b prefix? Leave those to the slow path.
+static inline
+int _qio_has_base_prefix(const char* p, const char* end)
+{
+  int c;
+  if( end - p < 2 || p[0] != '0' ) return 0;
+  c = tolower(p[1]);
+  return c == 'x' || c == 'o' || c == 'b';
+}
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+// Check and convert 8 ASCII digits at a time (loaded little endian).
+static inline
+int _qio_is_eight_digits(uint64_t v)
+{
+  return ((v & 0xF0F0F0F0F0F0F0F0ULL) |
+          (((v + 0x0606060606060606ULL) & 0xF0F0F0F0F0F0F0F0ULL) >> 4))
+         == 0x3333333333333333ULL;
+}
+
+static inline
+uint64_t _qio_parse_eight_digits(uint64_t v)
+{
+  const uint64_t mask = 0x000000FF000000FFULL;
+  const uint64_t mul1 = 100 + (1000000ULL << 32);
+  const uint64_t mul2 = 1 + (10000ULL << 32);
+
+  v -= 0x3030303030303030ULL;
+  v = (v * 10) + (v >> 8);
+  v = (((v & mask) * mul1) + (((v >> 16) & mask) * mul2)) >> 32;
+  return v;
+}
+#define QIO_SWAR_DIGITS 1
+#endif
+
+// Accumulate the digits starting at p into *acc, which wraps around if
+// there are more than 19. Returns a pointer to the first non-digit.
+static inline
+const char* _qio_scan_digits(const char* p, const char* end, uint64_t* acc)
+{
+  uint64_t v = *acc;
+
+#ifdef QIO_SWAR_DIGITS
+  while( end - p >= 8 ) {
+    uint64_t w;
+    memcpy(&w, p, 8);
+    if( ! _qio_is_eight_digits(w) ) break;
+    v = v * 100000000 + _qio_parse_eight_digits(w);
+    p += 8;
+  }
+#endif
+  while( p < end && _qio_is_digit(*p) ) {
+    v = v * 10 + (*p - '0');
+    p++;
+  }
+
+  *acc = v;
+  return p;
+}
+
+// Skip ASCII whitespace; returns NULL for anything else that isn't
+// plain ASCII, since that needs the multibyte-aware path.
+static inline
+const char* _qio_skip_space(const char* p, const char* end)
+{
+  while( p < end ) {
+    unsigned char c = *p;
+    if( c >= 0x80 ) return NULL;
+    if( ! isspace(c) ) return p;
+    p++;
+  }
+  return p;
+}
+
+static
+int _qio_scan_int_cached(qio_channel_t* restrict ch, int allow_pos_sign, int allow_neg_sign, unsigned long long* num_out, int* sign_out)
+{
+  const char* p = (const char*) ch->cached_cur;
+  const char* end = (const char*) ch->cached_end;
+  const char* start;
+  uint64_t num = 0;
+  int sign = 1;
+
+  if( qio_glocale_utf8 == 0 ) qio_set_glocale();
+  if( p == NULL || end == NULL || qio_glocale_utf8 <= 0 ) return 0;
+
+  p = _qio_skip_space(p, end);
+  if( p == NULL || p == end ) return 0;
+
+  if( allow_pos_sign && *p == '+' ) p++;
+  else if( allow_neg_sign && *p == '-' ) {
+    sign = -1;
+    p++;
+  }
+
+  if( ch->style.prefix_base && _qio_has_base_prefix(p, end) ) return 0;
+
+  start = p;
+  while( p < end && *p == '0' ) p++;
+  p = _qio_scan_digits(p, end, &num);
+
+  // No digits, too many to fit, or the number might continue past
+  // the cached area.
+  if( p == start || p == end ) return 0;
+  if( p - start > 19 ) {
+    const char* z = start;
+    while( *z == '0' ) z++;
+    if( p - z > 19 ) return 0;
+  }
+
+  ch->cached_cur = (void*) p;
+  *num_out = num;
+  *sign_out = sign;
+  return 1;
+}
+
+static
+int _qio_scan_float_cached(qio_channel_t* restrict ch, double* num_out)
+{
+  // Powers of ten that are exact as doubles.
+  static const double pow10[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+  };
+  const char* p = (const char*) ch->cached_cur;
+  const char* end = (const char*) ch->cached_end;
+  const char* start;
+  const char* q;
+  uint64_t w = 0;
+  int64_t ndigits = 0; // significant digits in w
+  int64_t nfraction = 0; // digits after the point
+  int64_t any_digits;
+  int64_t exp10 = 0;
+  int negative = 0;
+  double num;
+
+  if( qio_glocale_utf8 == 0 ) qio_set_glocale();
+  if( p == NULL || end == NULL || qio_glocale_utf8 <= 0 ) return 0;
+
+  p = _qio_skip_space(p, end);
+  if( p == NULL || p == end ) return 0;
+  start = p;
+
+  if( *p == '+' ) p++;
+  else if( *p == '-' ) {
+    negative = 1;
+    p++;
+  }
+
+  if( ch->style.prefix_base && _qio_has_base_prefix(p, end) ) return 0;
+
+  // Integer part; leading zeros are not significant.
+  q = p;
+  while( p < end && *p == '0' ) p++;
+  any_digits = p - q;
+  q = p;
+  p = _qio_scan_digits(p, end, &w);
+  ndigits = p - q;
+  any_digits += ndigits;
+
+  // Fraction part.
+  if( p < end && *p == '.' ) {
+    const char* frac = ++p;
+    if( ndigits == 0 ) {
+      while( p < end && *p == '0' ) p++;
+    }
+    q = p;
+    p = _qio_scan_digits(p, end, &w);
+    ndigits += p - q;
+    nfraction = p - frac;
+    any_digits += nfraction;
+  }
+  if( any_digits == 0 ) return 0;
+
+  // Exponent.
+  if( p < end && (*p == 'e' || *p == 'E') ) {
+    int64_t e = 0;
+    int esign = 1;
+    p++;
+    if( p < end && *p == '+' ) p++;
+    else if( p < end && *p == '-' ) {
+      esign = -1;
+      p++;
+    }
+    q = p;
+    while( p < end && _qio_is_digit(*p) && p - q < 6 ) {
+      e = e * 10 + (*p - '0');
+      p++;
+    }
+    if( p == q || (p < end && _qio_is_digit(*p)) ) return 0;
+    exp10 = esign * e;
+  }
+
+  // The slow path decides what a second point or exponent means.
+  if( p >= end || *p == '.' || *p == 'e' || *p == 'E' ) return 0;
+
+  exp10 -= nfraction;
+
+#if defined(FLT_EVAL_METHOD) && FLT_EVAL_METHOD == 0
+  // Clinger's fast path: the mantissa and the power of ten are both
+  // exact doubles, so one multiply or divide rounds correctly.
+  if( ndigits <= 19 && w <= (1ULL << 53) && -22 <= exp10 && exp10 <= 22 ) {
+    num = (double) w;
+    if( exp10 < 0 ) num /= pow10[-exp10];
+    else num *= pow10[exp10];
+    *num_out = negative ? -num : num;
+    ch->cached_cur = (void*) p;
+    return 1;
+  }
+#endif
+
+  // Otherwise convert the text we found with strtod; the number is
+  // already delimited, so this skips the state machine and copying
+  // through the channel.
+  {
+    char buf[128];
+    char* end_conv;
+    ssize_t len = p - start;
+
+    if( len >= (ssize_t) sizeof(buf) ) return 0;
+    memcpy(buf, start, len);
+    buf[len] = '\0';
+    errno = 0;
+    num = strtod(buf, &end_conv);
+    if( end_conv != buf + len || errno == ERANGE ) return 0;
+    *num_out = num;
+    ch->cached_cur = (void*) p;
+    return 1;
+  }
+}
+
 qioerr qio_channel_scan_int(const int threadsafe, qio_channel_t* restrict ch, void* restrict out, size_t len, int issigned)
 {
   unsigned long long int num = 0;
@@ -1773,6 +2338,13 @@ qioerr qio_channel_scan_int(const int threadsafe, qio_channel_t* restrict ch, vo
   st.positive_char = tolower(style->positive_char);
   st.negative_char = tolower(style->negative_char);
 
+  if( _qio_style_plain_decimal(style, 0) &&
+      _qio_scan_int_cached(ch, st.allow_pos_sign, st.allow_neg_sign,
+                           &num, &sign) ) {
+    err = 0;
+    goto error;
+  }
+
   err = _peek_number_unlocked(ch, &st, &amount);
   if( qio_err_to_int(err) == EEOF && st.end > 0 ) err = 0; // we tolerate EOF if there's data.
   if( err ) goto error;
@@ -1926,6 +2498,12 @@ qioerr qio_channel_scan_float_or_imag(const int threadsafe, qio_channel_t* restr
   st.allow_i_after = needs_i;
   st.i_char = style->i_char;
 
+  if( ! needs_i && _qio_style_plain_decimal(style, 1) &&
+      _qio_scan_float_cached(ch, &num) ) {
+    err = 0;
+    goto error;
+  }
+
   err = _peek_number_unlocked(ch, &st, &amount);
   if( qio_err_to_int(err) == EEOF && st.end > 0 ) err = 0; // we tolerate EOF if there's data.
   if( err ) goto error;
@@ -2187,6 +2765,370 @@ int _ltoa(char* restrict dst, size_t size, uint64_t num, int isnegative,
   return i;
 }
 
+// Shortest round-trip digit generation for doubles (Grisu3, from
+// Loitsch, "Printing Floating-Point Numbers Quickly and Accurately with
+// Integers", PLDI 2010). It fails for about 0.5% of inputs, in which
+// case the callers use snprintf.
+typedef struct qio_diy_fp_s {
+  uint64_t f;
+  int e;
+} qio_diy_fp_t;
+
+// Normalized approximations of 10^k for k = -348, -340, ..., 340.
+static const struct {
+  uint64_t f;
+  int16_t e;
+  int16_t k;
+} qio_cached_powers[] = {
+  {0xfa8fd5a0081c0288ULL, -1220, -348},
+  {0xbaaee17fa23ebf76ULL, -1193, -340},
+  {0x8b16fb203055ac76ULL, -1166, -332},
+  {0xcf42894a5dce35eaULL, -1140, -324},
+  {0x9a6bb0aa55653b2dULL, -1113, -316},
+  {0xe61acf033d1a45dfULL, -1087, -308},
+  {0xab70fe17c79ac6caULL, -1060, -300},
+  {0xff77b1fcbebcdc4fULL, -1034, -292},
+  {0xbe5691ef416bd60cULL, -1007, -284},
+  {0x8dd01fad907ffc3cULL, -980, -276},
+  {0xd3515c2831559a83ULL, -954, -268},
+  {0x9d71ac8fada6c9b5ULL, -927, -260},
+  {0xea9c227723ee8bcbULL, -901, -252},
+  {0xaecc49914078536dULL, -874, -244},
+  {0x823c12795db6ce57ULL, -847, -236},
+  {0xc21094364dfb5637ULL, -821, -228},
+  {0x9096ea6f3848984fULL, -794, -220},
+  {0xd77485cb25823ac7ULL, -768, -212},
+  {0xa086cfcd97bf97f4ULL, -741, -204},
+  {0xef340a98172aace5ULL, -715, -196},
+  {0xb23867fb2a35b28eULL, -688, -188},
+  {0x84c8d4dfd2c63f3bULL, -661, -180},
+  {0xc5dd44271ad3cdbaULL, -635, -172},
+  {0x936b9fcebb25c996ULL, -608, -164},
+  {0xdbac6c247d62a584ULL, -582, -156},
+  {0xa3ab66580d5fdaf6ULL, -555, -148},
+  {0xf3e2f893dec3f126ULL, -529, -140},
+  {0xb5b5ada8aaff80b8ULL, -502, -132},
+  {0x87625f056c7c4a8bULL, -475, -124},
+  {0xc9bcff6034c13053ULL, -449, -116},
+  {0x964e858c91ba2655ULL, -422, -108},
+  {0xdff9772470297ebdULL, -396, -100},
+  {0xa6dfbd9fb8e5b88fULL, -369, -92},
+  {0xf8a95fcf88747d94ULL, -343, -84},
+  {0xb94470938fa89bcfULL, -316, -76},
+  {0x8a08f0f8bf0f156bULL, -289, -68},
+  {0xcdb02555653131b6ULL, -263, -60},
+  {0x993fe2c6d07b7facULL, -236, -52},
+  {0xe45c10c42a2b3b06ULL, -210, -44},
+  {0xaa242499697392d3ULL, -183, -36},
+  {0xfd87b5f28300ca0eULL, -157, -28},
+  {0xbce5086492111aebULL, -130, -20},
+  {0x8cbccc096f5088ccULL, -103, -12},
+  {0xd1b71758e219652cULL, -77, -4},
+  {0x9c40000000000000ULL, -50, 4},
+  {0xe8d4a51000000000ULL, -24, 12},
+  {0xad78ebc5ac620000ULL, 3, 20},
+  {0x813f3978f8940984ULL, 30, 28},
+  {0xc097ce7bc90715b3ULL, 56, 36},
+  {0x8f7e32ce7bea5c70ULL, 83, 44},
+  {0xd5d238a4abe98068ULL, 109, 52},
+  {0x9f4f2726179a2245ULL, 136, 60},
+  {0xed63a231d4c4fb27ULL, 162, 68},
+  {0xb0de65388cc8ada8ULL, 189, 76},
+  {0x83c7088e1aab65dbULL, 216, 84},
+  {0xc45d1df942711d9aULL, 242, 92},
+  {0x924d692ca61be758ULL, 269, 100},
+  {0xda01ee641a708deaULL, 295, 108},
+  {0xa26da3999aef774aULL, 322, 116},
+  {0xf209787bb47d6b85ULL, 348, 124},
+  {0xb454e4a179dd1877ULL, 375, 132},
+  {0x865b86925b9bc5c2ULL, 402, 140},
+  {0xc83553c5c8965d3dULL, 428, 148},
+  {0x952ab45cfa97a0b3ULL, 455, 156},
+  {0xde469fbd99a05fe3ULL, 481, 164},
+  {0xa59bc234db398c25ULL, 508, 172},
+  {0xf6c69a72a3989f5cULL, 534, 180},
+  {0xb7dcbf5354e9beceULL, 561, 188},
+  {0x88fcf317f22241e2ULL, 588, 196},
+  {0xcc20ce9bd35c78a5ULL, 614, 204},
+  {0x98165af37b2153dfULL, 641, 212},
+  {0xe2a0b5dc971f303aULL, 667, 220},
+  {0xa8d9d1535ce3b396ULL, 694, 228},
+  {0xfb9b7cd9a4a7443cULL, 720, 236},
+  {0xbb764c4ca7a44410ULL, 747, 244},
+  {0x8bab8eefb6409c1aULL, 774, 252},
+  {0xd01fef10a657842cULL, 800, 260},
+  {0x9b10a4e5e9913129ULL, 827, 268},
+  {0xe7109bfba19c0c9dULL, 853, 276},
+  {0xac2820d9623bf429ULL, 880, 284},
+  {0x80444b5e7aa7cf85ULL, 907, 292},
+  {0xbf21e44003acdd2dULL, 933, 300},
+  {0x8e679c2f5e44ff8fULL, 960, 308},
+  {0xd433179d9c8cb841ULL, 986, 316},
+  {0x9e19db92b4e31ba9ULL, 1013, 324},
+  {0xeb96bf6ebadf77d9ULL, 1039, 332},
+  {0xaf87023b9bf0ee6bULL, 1066, 340},
+};
+
+#define QIO_CACHED_POWERS_OFFSET 348
+#define QIO_CACHED_POWERS_STEP 8
+#define QIO_GRISU_MIN_TARGET_EXP (-60)
+
+// Multiply, keeping the upper 64 bits of the product (rounded).
+static inline
+qio_diy_fp_t _qio_diy_fp_mul(qio_diy_fp_t x, qio_diy_fp_t y)
+{
+  const uint64_t m32 = 0xFFFFFFFFULL;
+  uint64_t a = x.f >> 32, b = x.f & m32;
+  uint64_t c = y.f >> 32, d = y.f & m32;
+  uint64_t ac = a * c, bc = b * c, ad = a * d, bd = b * d;
+  uint64_t tmp = (bd >> 32) + (ad & m32) + (bc & m32);
+  qio_diy_fp_t r;
+
+  tmp += 1ULL << 31;
+  r.f = ac + (ad >> 32) + (bc >> 32) + (tmp >> 32);
+  r.e = x.e + y.e + 64;
+  return r;
+}
+
+static inline
+qio_diy_fp_t _qio_diy_fp_normalize(qio_diy_fp_t x)
+{
+  while( ! (x.f & (1ULL << 63)) ) {
+    x.f <<= 1;
+    x.e--;
+  }
+  return x;
+}
+
+// Move the last digit of buf down towards w while that's closer, and
+// check that the result is certainly the closest shortest one.
+static
+int _qio_grisu_round_weed(char* buf, int len, uint64_t dist_high_w,
+                          uint64_t unsafe, uint64_t rest,
+                          uint64_t ten_kappa, uint64_t unit)
+{
+  uint64_t small_dist = dist_high_w - unit;
+  uint64_t big_dist = dist_high_w + unit;
+
+  while( rest < small_dist &&
+         unsafe - rest >= ten_kappa &&
+         (rest + ten_kappa < small_dist ||
+          small_dist - rest >= rest + ten_kappa - small_dist) ) {
+    buf[len-1]--;
+    rest += ten_kappa;
+  }
+
+  if( rest < big_dist &&
+      unsafe - rest >= ten_kappa &&
+      (rest + ten_kappa < big_dist ||
+       big_dist - rest > rest + ten_kappa - big_dist) ) {
+    return 0;
+  }
+
+  return 2 * unit <= rest && rest <= unsafe - 4 * unit;
+}
+
+// Writes the shortest digits of the positive finite num (without a
+// terminating '\0') into buf, which must have room for 18, so that num
+// is digits * 10^(*k_out). Returns the number of digits, or 0 if Grisu3
+// can't be sure of the answer.
+static
+int _qio_grisu3(double num, char* buf, int* k_out)
+{
+  uint64_t bits;
+  qio_diy_fp_t w, m_plus, m_minus, c, too_low, too_high, one;
+  int biased_e, min_e, k, idx, kappa, len;
+  uint64_t unsafe, integrals, fractionals, divisor, unit;
+
+  memcpy(&bits, &num, sizeof(bits));
+  biased_e = (int) ((bits >> 52) & 0x7FF);
+  w.f = bits & 0xFFFFFFFFFFFFFULL;
+  if( biased_e ) {
+    w.f += 1ULL << 52;
+    w.e = biased_e - 1075;
+  } else {
+    w.e = -1074;
+  }
+
+  // Boundaries halfway to the neighboring doubles.
+  m_plus.f = (w.f << 1) + 1;
+  m_plus.e = w.e - 1;
+  m_plus = _qio_diy_fp_normalize(m_plus);
+  if( w.f == (1ULL << 52) && biased_e > 1 ) {
+    m_minus.f = (w.f << 2) - 1;
+    m_minus.e = w.e - 2;
+  } else {
+    m_minus.f = (w.f << 1) - 1;
+    m_minus.e = w.e - 1;
+  }
+  m_minus.f <<= m_minus.e - m_plus.e;
+  m_minus.e = m_plus.e;
+  w = _qio_diy_fp_normalize(w);
+
+  // Pick 10^-k so that w * 10^-k has a binary exponent in [-60,-32].
+  min_e = QIO_GRISU_MIN_TARGET_EXP - (w.e + 64);
+  k = (int) ceil((min_e + 63) * 0.30102999566398114);
+  idx = (QIO_CACHED_POWERS_OFFSET + k - 1) / QIO_CACHED_POWERS_STEP + 1;
+  c.f = qio_cached_powers[idx].f;
+  c.e = qio_cached_powers[idx].e;
+
+  w = _qio_diy_fp_mul(w, c);
+  m_minus = _qio_diy_fp_mul(m_minus, c);
+  m_plus = _qio_diy_fp_mul(m_plus, c);
+
+  // Each product may be off by one unit.
+  unit = 1;
+  too_low.f = m_minus.f - unit;
+  too_low.e = m_minus.e;
+  too_high.f = m_plus.f + unit;
+  too_high.e = m_plus.e;
+  unsafe = too_high.f - too_low.f;
+
+  one.e = w.e;
+  one.f = 1ULL << -one.e;
+  integrals = too_high.f >> -one.e;
+  fractionals = too_high.f & (one.f - 1);
+
+  divisor = 1;
+  kappa = 0;
+  if( integrals ) {
+    kappa = 1;
+    while( divisor * 10 <= integrals ) {
+      divisor *= 10;
+      kappa++;
+    }
+  }
+
+  len = 0;
+  while( kappa > 0 ) {
+    uint64_t rest;
+    buf[len++] = '0' + (char) (integrals / divisor);
+    integrals %= divisor;
+    kappa--;
+    rest = (integrals << -one.e) + fractionals;
+    if( rest < unsafe ) {
+      *k_out = -qio_cached_powers[idx].k + kappa;
+      if( ! _qio_grisu_round_weed(buf, len, too_high.f - w.f, unsafe, rest,
+                                  divisor << -one.e, unit) ) return 0;
+      return len;
+    }
+    divisor /= 10;
+  }
+
+  while( 1 ) {
+    fractionals *= 10;
+    unit *= 10;
+    unsafe *= 10;
+    buf[len++] = '0' + (char) (fractionals >> -one.e);
+    fractionals &= one.f - 1;
+    kappa--;
+    if( fractionals < unsafe ) {
+      *k_out = -qio_cached_powers[idx].k + kappa;
+      if( ! _qio_grisu_round_weed(buf, len, (too_high.f - w.f) * unit, unsafe,
+                                  fractionals, one.f, unit) ) return 0;
+      return len;
+    }
+  }
+}
+
+// Format the non-negative num like snprintf "%.*g" (or "%#.*g" if
+// showpoint) into buf, but without going through printf. Rounding the
+// shortest digits to precision digits gives the same answer as
+// rounding num itself, except when they end in exactly 5 (a tie we
+// can't break) or when precision is more than the 15 digits every
+// normal double can hold. Returns the length, or -1 when the caller
+// should use snprintf instead.
+static
+int _qio_format_g(char* buf, size_t buf_sz, double num, int precision,
+                  int uppercase, int showpoint)
+{
+  char digits[24];
+  int ndigits;
+  int k;
+  int x; // the exponent as %e would print it
+  int i, j;
+  int len;
+
+  if( precision < 0 ) precision = 6;
+  if( precision == 0 ) precision = 1;
+  if( precision > 15 || buf_sz < 32 || isnan(num) || isinf(num) ) return -1;
+  // Subnormals hold fewer than 15 digits.
+  if( num != 0.0 && num < DBL_MIN ) return -1;
+
+  if( num == 0.0 ) {
+    digits[0] = '0';
+    ndigits = 1;
+    x = 0;
+  } else {
+    ndigits = _qio_grisu3(num, digits, &k);
+    if( ndigits == 0 ) return -1;
+    while( ndigits > 1 && digits[ndigits-1] == '0' ) {
+      ndigits--;
+      k++;
+    }
+    x = k + ndigits - 1;
+
+    if( ndigits > precision ) {
+      if( digits[precision] == '5' && ndigits == precision + 1 ) return -1;
+      if( digits[precision] >= '5' ) {
+        for( i = precision - 1; i >= 0 && digits[i] == '9'; i-- ) {
+          digits[i] = '0';
+        }
+        if( i >= 0 ) {
+          digits[i]++;
+        } else {
+          // glibc prints e.g. %#.3g of 999.9 as 1.e+03, so leave
+          // that to snprintf.
+          if( showpoint ) return -1;
+          digits[0] = '1';
+          x++;
+        }
+      }
+      ndigits = precision;
+    }
+  }
+
+  // Pad out to precision digits; %g removes these again unless '#'.
+  for( ; ndigits < precision; ndigits++ ) digits[ndigits] = '0';
+  if( ! showpoint ) {
+    while( ndigits > 1 && digits[ndigits-1] == '0' ) ndigits--;
+  }
+
+  len = 0;
+  if( x < -4 || x >= precision ) {
+    // exponential notation
+    buf[len++] = digits[0];
+    if( ndigits > 1 || showpoint ) buf[len++] = '.';
+    for( i = 1; i < ndigits; i++ ) buf[len++] = digits[i];
+    buf[len++] = uppercase ? 'E' : 'e';
+    if( x < 0 ) {
+      buf[len++] = '-';
+      x = -x;
+    } else {
+      buf[len++] = '+';
+    }
+    if( x >= 100 ) buf[len++] = '0' + x / 100;
+    buf[len++] = '0' + (x / 10) % 10;
+    buf[len++] = '0' + x % 10;
+  } else if( x < 0 ) {
+    // 0.000ddd
+    buf[len++] = '0';
+    buf[len++] = '.';
+    for( i = -1; i > x; i-- ) buf[len++] = '0';
+    for( i = 0; i < ndigits; i++ ) buf[len++] = digits[i];
+  } else {
+    // ddd.ddd
+    for( i = 0, j = 0; i <= x; i++ ) {
+      buf[len++] = (j < ndigits) ? digits[j++] : '0';
+    }
+    if( j < ndigits || showpoint ) buf[len++] = '.';
+    for( ; j < ndigits; j++ ) buf[len++] = digits[j];
+  }
+
+  buf[len] = '\0';
+  return len;
+}
+
 // error codes:
 //  -1 for out of memory
 //  -2 for error in conversion
@@ -2265,6 +3207,11 @@ int _ftoa(char* restrict dst, size_t size, double num, int base, bool needs_i, c
             got = snprintf(buf, buf_sz, "%.*a", precision, num);
         }
       }
+    } else if( style->realfmt == 0 &&
+               (got = _qio_format_g(buf, buf_sz, num, precision,
+                                    style->uppercase,
+                                    style->showpoint)) >= 0 ) {
+      // formatted without snprintf
     } else if( style->realfmt == 0 ) {
       if( precision < 0 ) {
         if( style->uppercase ) {
@@ -25,6 +25,7 @@
 #include "chpl_rt_utils_static.h"
 #include "chplcgfns.h"
 #include "chpl-comm.h"
+#include "chpl-env.h"
 #include "chplexit.h"
 #include "chpl-locale-model.h"
 #include "chpl-mem.h"
@@ -32,6 +33,7 @@
 #include "chplsys.h"
 #include "error.h"
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <signal.h>
 #include <assert.h>
@@ -39,6 +41,10 @@
 #include <errno.h>
 #include <sys/time.h>
 #include <unistd.h>
+#ifdef CHPL_SYNC_USE_FUTEX
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#endif
 
 
 //
@@ -59,6 +65,9 @@ typedef struct task_pool_struct {
   c_string         filename;
   int              lineno;
   chpl_task_prvDataImpl_t chpl_data;
+  uint64_t         create_ns;    // task profiling: when created,
+  uint64_t         start_ns;     //   when started,
+  uint64_t         blocked_ns;   //   and time spent blocked so far
   task_pool_p      next;
   task_pool_p      prev;
 } task_pool_t;
@@ -142,6 +151,30 @@ static chpl_thread_mutex_t taskTable_lock;     // critical section lock
 
 static c_string idleTaskName = "|idle|";
 
+//
+// Task profiling.  When the CHPL_RT_TASK_PROFILE environment variable
+// is set, each locale keeps totals of the number of tasks, the time
+// they spent queued waiting for a thread, the time they spent running,
+// and how much of that they spent blocked on sync variables, for each
+// task creation site.  These are reported in chpl_task_exit().  Tasks
+// run serially by their creator are part of their creator, and aren't
+// counted separately.
+//
+typedef struct {
+  c_string filename;
+  int      lineno;
+  uint64_t count;
+  uint64_t wait_ns;
+  uint64_t run_ns;
+  uint64_t blocked_ns;
+} taskProfileSite_t;
+
+static chpl_bool do_taskProfile = false;
+static chpl_thread_mutex_t taskProfile_lock;   // critical section lock
+static taskProfileSite_t* taskProfile_sites;   // open-addressed hash table
+static int taskProfile_size;                   // number of table entries
+static int taskProfile_cnt;                    // number of entries in use
+
 static chpl_fn_p comm_task_fn;
 
 static void                    comm_task_wrapper(void*);
@@ -152,6 +185,9 @@ static task_pool_p             get_current_ptask(void);
 static void                    set_current_ptask(task_pool_p);
 static void                    report_locked_threads(void);
 static void                    report_all_tasks(void);
+static uint64_t                taskProfile_now(void);
+static void                    taskProfile_record(task_pool_p);
+static void                    taskProfile_report(void);
 static void                    SIGINT_handler(int sig);
 static void                    initializeLockReportForThread(void);
 static chpl_bool               set_block_loc(int, c_string);
@@ -172,7 +208,9 @@ static task_pool_p             add_to_task_pool(chpl_fn_p,
 //
 // Condition variable methods
 //
+#ifndef CHPL_SYNC_USE_FUTEX
 static void chpl_thread_condvar_init(chpl_thread_condvar_t* cv);
+#endif
 
 //
 // Sync variable methods
@@ -183,13 +221,78 @@ static void chpl_thread_sync_awaken(chpl_sync_aux_t *s);
 
 // Sync variables
 
+//
+// Bounds on the adaptive spin before blocking on a sync variable, in
+// calls to cpu_relax().  Each sync variable starts in the middle and
+// doubles its bound when spinning pays off and halves it when it
+// doesn't, so variables whose critical sections are short come to spin
+// long enough to avoid blocking while the others quickly stop wasting
+// cycles.
+//
+#define SYNC_SPIN_MIN      (1 << 4)
+#define SYNC_SPIN_INIT     (1 << 10)
+#define SYNC_SPIN_MAX      (1 << 14)
+
+static ___always_inline void cpu_relax(void) {
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+  __asm__ __volatile__("pause" ::: "memory");
+#elif defined(__GNUC__)
+  __asm__ __volatile__("" ::: "memory");
+#endif
+}
+
+//
+// Spin, with the lock released, waiting for the sync variable to reach
+// the desired state.  Between looks we back off exponentially so that
+// we don't keep stealing the cache line the other side needs to write.
+// Returns true if the state was reached within the spin bound.
+//
+static chpl_bool sync_spin_wait(chpl_sync_aux_t *s, chpl_bool want_full) {
+  int32_t total, delay, i;
+
+  for (total = 0, delay = 1;
+       total < s->spin_limit;
+       total += delay, delay = (delay < 64) ? delay * 2 : delay) {
+    for (i = 0; i < delay; i++)
+      cpu_relax();
+    if (s->is_full == want_full)
+      return true;
+  }
+
+  return false;
+}
+
 static void sync_wait_and_lock(chpl_sync_aux_t *s,
                                chpl_bool want_full,
                                int32_t lineno, c_string filename) {
   chpl_bool suspend_using_cond;
+  uint64_t block_start_ns = 0;
 
   chpl_thread_mutexLock(&s->lock);
 
+  if (s->is_full != want_full) {
+    chpl_bool spin_ok;
+
+    if (do_taskProfile)
+      block_start_ns = taskProfile_now();
+
+    chpl_thread_mutexUnlock(&s->lock);
+    spin_ok = sync_spin_wait(s, want_full);
+    chpl_thread_mutexLock(&s->lock);
+
+    //
+    // Adapt the spin bound to how well spinning worked this time.  We
+    // count it a success only if the state is still what we want now
+    // that we hold the lock again.
+    //
+    if (spin_ok && s->is_full == want_full) {
+      if (s->spin_limit < SYNC_SPIN_MAX)
+        s->spin_limit *= 2;
+    }
+    else if (s->spin_limit > SYNC_SPIN_MIN)
+      s->spin_limit /= 2;
+  }
+
   // If we're oversubscribing the hardware, we wait using conditionals
   // in order to ensure fairness and thus progress.  If we're not, we
   // can spin-wait.
@@ -238,6 +341,9 @@ static void sync_wait_and_lock(chpl_sync_aux_t *s,
       chpl_thread_mutexLock(&s->lock);
   }
 
+  if (block_start_ns != 0)
+    get_current_ptask()->blocked_ns += taskProfile_now() - block_start_ns;
+
   if (blockreport)
     progress_cnt++;
 }
@@ -260,6 +366,87 @@ void chpl_sync_waitEmptyAndLock(chpl_sync_aux_t *s,
   sync_wait_and_lock(s, false, lineno, filename);
 }
 
+#ifdef CHPL_SYNC_USE_FUTEX
+
+//
+// Park the calling thread until the sync variable is signaled or the
+// deadline (if any) passes.  Called and returns with the lock held.
+//
+static chpl_bool chpl_thread_sync_suspend(chpl_sync_aux_t *s,
+                                   struct timeval *deadline) {
+  volatile int32_t* word;
+  int32_t* waiters;
+  int32_t seq;
+  struct timespec ts, *tsp = NULL;
+  chpl_bool timed_out = false;
+
+  if (s->is_full) {
+    word = &s->signal_empty;
+    waiters = &s->empty_waiters;
+  }
+  else {
+    word = &s->signal_full;
+    waiters = &s->full_waiters;
+  }
+
+  if (deadline != NULL) {
+    struct timeval now;
+    int64_t usec;
+
+    gettimeofday(&now, NULL);
+    usec = ((int64_t) (deadline->tv_sec - now.tv_sec)) * 1000000
+           + (deadline->tv_usec - now.tv_usec);
+    if (usec <= 0)
+      return true;
+    ts.tv_sec  = usec / 1000000;
+    ts.tv_nsec = (usec % 1000000) * 1000;
+    tsp = &ts;
+  }
+
+  seq = *word;
+  (*waiters)++;
+  chpl_thread_mutexUnlock(&s->lock);
+
+  //
+  // If the sequence number changed after we sampled it the kernel
+  // returns EAGAIN immediately, which is just what we want.
+  //
+  if (syscall(SYS_futex, word, FUTEX_WAIT_PRIVATE, seq, tsp, NULL, 0) != 0
+      && errno == ETIMEDOUT)
+    timed_out = true;
+
+  chpl_thread_mutexLock(&s->lock);
+  (*waiters)--;
+
+  return timed_out;
+}
+
+//
+// Wake one thread waiting for the state the sync variable now has.
+// Called with the lock held.
+//
+static void chpl_thread_sync_awaken(chpl_sync_aux_t *s) {
+  volatile int32_t* word;
+  int32_t waiters;
+
+  if (s->is_full) {
+    word = &s->signal_full;
+    waiters = s->full_waiters;
+  }
+  else {
+    word = &s->signal_empty;
+    waiters = s->empty_waiters;
+  }
+
+  if (waiters > 0) {
+    (*word)++;
+    if (syscall(SYS_futex, word, FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0) < 0)
+      chpl_internal_error("futex wake failed");
+  }
+}
+
+#else // CHPL_SYNC_USE_FUTEX
+
 static chpl_bool chpl_thread_sync_suspend(chpl_sync_aux_t *s,
                                    struct timeval *deadline) {
   chpl_thread_condvar_t* cond;
@@ -284,6 +471,8 @@ static void chpl_thread_sync_awaken(chpl_sync_aux_t *s) {
     chpl_internal_error("pthread_cond_signal() failed");
 }
 
+#endif // CHPL_SYNC_USE_FUTEX
+
 void chpl_sync_markAndSignalFull(chpl_sync_aux_t *s) {
   s->is_full = true;
   chpl_thread_sync_awaken(s);
@@ -301,16 +490,26 @@ chpl_bool chpl_sync_isFull(void *val_ptr,
   return s->is_full;
 }
 
+#ifndef CHPL_SYNC_USE_FUTEX
 static void chpl_thread_condvar_init(chpl_thread_condvar_t* cv) {
   if (pthread_cond_init((pthread_cond_t*) cv, NULL))
     chpl_internal_error("pthread_cond_init() failed");
 }
+#endif
 
 void chpl_sync_initAux(chpl_sync_aux_t *s) {
   s->is_full = false;
   chpl_thread_mutexInit(&s->lock);
+#ifdef CHPL_SYNC_USE_FUTEX
+  s->signal_full = 0;
+  s->signal_empty = 0;
+  s->full_waiters = 0;
+  s->empty_waiters = 0;
+#else
   chpl_thread_condvar_init(&s->signal_full);
   chpl_thread_condvar_init(&s->signal_empty);
+#endif
+  s->spin_limit = SYNC_SPIN_INIT;
 }
 
 void chpl_sync_destroyAux(chpl_sync_aux_t *s) { }
@@ -359,10 +558,12 @@ void chpl_task_init(void) {
     tp->ptask->begun        = true;
     tp->ptask->filename     = "main program";
     tp->ptask->lineno       = 0;
+    tp->ptask->blocked_ns   = 0;
     tp->ptask->next         = NULL;
     tp->lockRprt            = NULL;
 
     // Set up task-private data for locale (architectural) support.
+    tp->ptask->chpl_data = (chpl_task_prvDataImpl_t) { .prvdata = { 0 } };
     tp->ptask->chpl_data.prvdata.serial_state = true;     // Set to false in chpl_task_callMain().
 
     chpl_thread_setPrivateData(tp);
@@ -378,6 +579,11 @@ void chpl_task_init(void) {
     signal(SIGINT, SIGINT_handler);
   }
 
+  if (chpl_env_rt_get_bool("CHPL_RT_TASK_PROFILE", false)) {
+    do_taskProfile = true;
+    chpl_thread_mutexInit(&taskProfile_lock);
+  }
+
   initialized = true;
 }
 
@@ -386,12 +592,18 @@ void chpl_task_exit(void) {
   if (!initialized)
     return;
 
+  if (do_taskProfile) {
+    do_taskProfile = false;
+    taskProfile_report();
+  }
+
   chpl_thread_exit();
 }
 
 
 void chpl_task_callMain(void (*chpl_main)(void)) {
   chpl_main();
+  chpl_task_freeLocals(&chpl_task_getPrvData()->local_data);
 }
 
 
@@ -456,11 +668,13 @@ static void comm_task_wrapper(void* arg) {
   tp->ptask->begun        = true;
   tp->ptask->filename     = "communication task";
   tp->ptask->lineno       = 0;
+  tp->ptask->blocked_ns   = 0;
   tp->ptask->next         = NULL;
 
   //
   // The comm (polling) task shouldn't really need this information.
   //
+  tp->ptask->chpl_data = (chpl_task_prvDataImpl_t) { .prvdata = { 0 } };
   tp->ptask->chpl_data.prvdata.serial_state = true;
 
   tp->lockRprt = NULL;
@@ -585,6 +799,11 @@ void chpl_task_processTaskList(chpl_task_list_p task_list) {
     nested_task.filename     = first_task->filename;
     nested_task.lineno       = first_task->lineno;
     nested_task.chpl_data    = curr_ptask->chpl_data;
+    nested_task.chpl_data.prvdata.local_data =
+      (chpl_task_localData_t) { 0, NULL };
+    nested_task.blocked_ns   = 0;
+    if (do_taskProfile)
+      nested_task.create_ns  = nested_task.start_ns = taskProfile_now();
 
     set_current_ptask(&nested_task);
 
@@ -611,6 +830,11 @@ void chpl_task_processTaskList(chpl_task_list_p task_list) {
 
     (*first_task->fun)(first_task->arg);
 
+    chpl_task_freeLocals(&nested_task.chpl_data.prvdata.local_data);
+
+    if (do_taskProfile)
+      taskProfile_record(&nested_task);
+
     // begin critical section
     chpl_thread_mutexLock(&extra_task_lock);
 
@@ -715,8 +939,16 @@ void chpl_task_executeTasksInList(chpl_task_list_p task_list) {
         if (blockreport)
           initializeLockReportForThread();
 
+        if (do_taskProfile)
+          nested_ptask->start_ns = taskProfile_now();
+
         (*task_to_run_fun)(task_to_run_arg);
 
+        chpl_task_freeLocals(&nested_ptask->chpl_data.prvdata.local_data);
+
+        if (do_taskProfile)
+          taskProfile_record(nested_ptask);
+
         if (do_taskReport) {
           chpl_thread_mutexLock(&taskTable_lock);
           chpldev_taskTable_set_active(curr_ptask->id);
@@ -1000,6 +1232,142 @@ static void report_all_tasks(void) {
 }
 
 
+//
+// Task profiling support.
+//
+static uint64_t taskProfile_now(void) {
+  struct timeval tv;
+  (void) gettimeofday(&tv, NULL);
+  return (uint64_t) tv.tv_sec * 1000000000 + (uint64_t) tv.tv_usec * 1000;
+}
+
+
+static size_t taskProfile_hash(c_string filename, int lineno, int size) {
+  return (((size_t) (intptr_t) filename >> 3) * 31 + (size_t) lineno)
+         & (size - 1);
+}
+
+
+// assumes taskProfile_lock has already been acquired!
+static taskProfileSite_t* taskProfile_find(c_string filename, int lineno) {
+  taskProfileSite_t* site;
+  size_t i;
+
+  if (4 * (taskProfile_cnt + 1) > 3 * taskProfile_size) {
+    taskProfileSite_t* old_sites = taskProfile_sites;
+    int old_size = taskProfile_size;
+    int j;
+
+    taskProfile_size = (old_size == 0) ? 64 : 2 * old_size;
+    taskProfile_sites = (taskProfileSite_t*)
+                        chpl_mem_allocManyZero(taskProfile_size,
+                                               sizeof(taskProfileSite_t),
+                                               CHPL_RT_MD_TASK_PROFILE_DATA,
+                                               0, 0);
+    for (j = 0; j < old_size; j++) {
+      if (old_sites[j].filename != NULL) {
+        i = taskProfile_hash(old_sites[j].filename, old_sites[j].lineno,
+                             taskProfile_size);
+        while (taskProfile_sites[i].filename != NULL)
+          i = (i + 1) & (taskProfile_size - 1);
+        taskProfile_sites[i] = old_sites[j];
+      }
+    }
+    if (old_sites != NULL)
+      chpl_mem_free(old_sites, 0, 0);
+  }
+
+  //
+  // Task creation sites are identified by the string literals the
+  // compiler generates for their filenames, so comparing pointers is
+  // enough.
+  //
+  i = taskProfile_hash(filename, lineno, taskProfile_size);
+  while ((site = &taskProfile_sites[i])->filename != NULL) {
+    if (site->filename == filename && site->lineno == lineno)
+      return site;
+    i = (i + 1) & (taskProfile_size - 1);
+  }
+
+  site->filename = filename;
+  site->lineno = lineno;
+  taskProfile_cnt++;
+  return site;
+}
+
+
+//
+// Add a finished task's times to the totals for its creation site.
+//
+static void taskProfile_record(task_pool_p ptask) {
+  uint64_t now = taskProfile_now();
+  taskProfileSite_t* site;
+
+  chpl_thread_mutexLock(&taskProfile_lock);
+
+  site = taskProfile_find(ptask->filename, ptask->lineno);
+  site->count++;
+  site->wait_ns += ptask->start_ns - ptask->create_ns;
+  site->run_ns += now - ptask->start_ns;
+  site->blocked_ns += ptask->blocked_ns;
+
+  chpl_thread_mutexUnlock(&taskProfile_lock);
+}
+
+
+static int taskProfile_cmp(const void* v1, const void* v2) {
+  const taskProfileSite_t* s1 = (const taskProfileSite_t*) v1;
+  const taskProfileSite_t* s2 = (const taskProfileSite_t*) v2;
+  uint64_t t1 = s1->wait_ns + s1->run_ns;
+  uint64_t t2 = s2->wait_ns + s2->run_ns;
+
+  return (t1 < t2) ? 1 : (t1 > t2) ? -1 : 0;
+}
+
+
+//
+// Print the task profile for this locale, busiest creation sites
+// first.  The total is queue wait plus run time; blocked time is the
+// part of the run time spent waiting on sync variables.
+//
+static void taskProfile_report(void) {
+  int i, j;
+
+  chpl_thread_mutexLock(&taskProfile_lock);
+
+  // compact the table to the front, so we can sort it
+  for (i = j = 0; i < taskProfile_size; i++) {
+    if (taskProfile_sites[i].filename != NULL)
+      taskProfile_sites[j++] = taskProfile_sites[i];
+  }
+  if (taskProfile_cnt > 0)
+    qsort(taskProfile_sites, taskProfile_cnt, sizeof(taskProfileSite_t),
+          taskProfile_cmp);
+
+  printf("Task profile for locale %d (times in seconds)\n", (int) chpl_nodeID);
+  printf("%10s %12s %12s %12s %12s  %s\n",
+         "tasks", "total", "queue wait", "run", "blocked", "created at");
+  for (i = 0; i < taskProfile_cnt; i++) {
+    taskProfileSite_t* site = &taskProfile_sites[i];
+    printf("%10" PRIu64 " %12.6f %12.6f %12.6f %12.6f  %s:%d\n",
+           site->count,
+           (site->wait_ns + site->run_ns) / 1e9,
+           site->wait_ns / 1e9,
+           site->run_ns / 1e9,
+           site->blocked_ns / 1e9,
+           site->filename, site->lineno);
+  }
+  fflush(stdout);
+
+  if (taskProfile_sites != NULL)
+    chpl_mem_free(taskProfile_sites, 0, 0);
+  taskProfile_sites = NULL;
+  taskProfile_size = taskProfile_cnt = 0;
+
+  chpl_thread_mutexUnlock(&taskProfile_lock);
+}
+
+
 //
 // This is a signal handler that does thread and task reporting.
 //
@@ -1163,8 +1531,16 @@ thread_begin(void* ptask_void) {
       chpl_thread_mutexUnlock(&taskTable_lock);
     }
 
+    if (do_taskProfile)
+      ptask->start_ns = taskProfile_now();
+
     (*ptask->fun)(ptask->arg);
 
+    chpl_task_freeLocals(&ptask->chpl_data.prvdata.local_data);
+
+    if (do_taskProfile)
+      taskProfile_record(ptask);
+
     if (do_taskReport) {
       chpl_thread_mutexLock(&taskTable_lock);
       chpldev_taskTable_remove(ptask->id);
@@ -1432,6 +1808,8 @@ static task_pool_p add_to_task_pool(chpl_fn_p fp,
   ptask->ltask        = ltask;
   ptask->begun        = false;
   ptask->chpl_data    = chpl_data;
+  ptask->create_ns    = do_taskProfile ? taskProfile_now() : 0;
+  ptask->blocked_ns   = 0;
 
   if (ltask) {
     ptask->filename = ltask->filename;
@@ -287,6 +287,7 @@ static void* moved_task_wrapper(void* a) {
   if (pmtwd->count_running)
     chpl_taskRunningCntInc(0, NULL);
   (pmtwd->fp)(pmtwd->arg);
+  chpl_task_freeLocals(&getTaskPrivateData()->prvdata.local_data);
   if (pmtwd->count_running)
     chpl_taskRunningCntDec(0, NULL);
   chpl_mem_free(pmtwd, 0, 0);
@@ -373,6 +374,7 @@ void chpl_task_exit(void) {
 void chpl_task_callMain(void(*chpl_main)(void)) {
   //Call main function
   chpl_main();
+  chpl_task_freeLocals(&getTaskPrivateData()->prvdata.local_data);
 }
 
 void chpl_task_stdModulesInitialized(void) {
@@ -389,6 +391,7 @@ void chpl_task_addToTaskList(chpl_fn_int_t fid, void* arg, c_sublocid_t subLoc,
   //Create a new task directly
   myth_thread_option opt;
   myth_thread_t th;
+  moved_task_wrapper_desc_t* pmtwd;
   chpl_bool serial_state = getTaskPrivateData()->prvdata.serial_state;
 
   assert(subLoc == 0 || subLoc == c_sublocid_any);
@@ -398,13 +401,20 @@ void chpl_task_addToTaskList(chpl_fn_int_t fid, void* arg, c_sublocid_t subLoc,
     return;
   }
   //Create one task
-  //chpl_fn_p is defined as "typedef void (*chpl_fn_p)(void*);" in chpltypes.h at line 85.
-  //So this cast is OK unless the definition is changed.
+  //The child starts with a copy of our private data, except that it
+  //must not inherit our task-local storage, and it needs the wrapper
+  //to free its own task-local storage when it ends.
+  pmtwd = (moved_task_wrapper_desc_t*) chpl_mem_alloc(sizeof(*pmtwd), 0, 0, 0);
+  *pmtwd = (moved_task_wrapper_desc_t)
+           { chpl_ftable[fid], arg, false,
+             *getTaskPrivateData() };
+  pmtwd->chpl_data.prvdata.local_data = (chpl_task_localData_t) { 0, NULL };
+
   opt.stack_size = 0;
   opt.switch_immediately = (is_worker_in_cs())?0:1;
   opt.custom_data_size = sizeof(chpl_task_prvDataImpl_t);
-  opt.custom_data = getTaskPrivateData();
-  th = myth_create_ex((void*(*)(void*)) chpl_ftable[fid], arg, &opt);
+  opt.custom_data = (void*)&pmtwd->chpl_data;
+  th = myth_create_ex(moved_task_wrapper, pmtwd, &opt);
   assert(th);
   myth_detach(th);
 }
@@ -0,0 +1,34 @@
+//
+// Reference counts of privatized objects are kept on the original, but
+// iterating over a Block array must not touch them: a forall forks
+// once per locale, not once per element.
+//
+use BlockDist, CommDiagnostics;
+
+config const n = 100000;
+
+const D = {1..n} dmapped Block({1..n});
+var A: [D] int;
+
+proc countForks() {
+  var forks = 0;
+  for d in getCommDiagnostics() do
+    forks += d.fork + d.fork_fast + d.fork_nb;
+  return forks;
+}
+
+resetCommDiagnostics();
+startCommDiagnostics();
+forall i in D do
+  A[i] += 1;
+stopCommDiagnostics();
+writeln(countForks() <= 2 * numLocales);
+
+resetCommDiagnostics();
+startCommDiagnostics();
+forall a in A do
+  a += 1;
+stopCommDiagnostics();
+writeln(countForks() <= 2 * numLocales);
+
+writeln(+ reduce A == 2 * n);
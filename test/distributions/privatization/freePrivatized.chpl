@@ -0,0 +1,38 @@
+//
+// Privatized distributions, domains and arrays must release their
+// pids when they are destroyed, so that creating and destroying them
+// in a loop does not grow the privatization table.
+//
+use BlockDist;
+
+extern proc chpl_numPrivatizedPids(): int(64);
+
+config const n = 1000;
+
+proc sumNew(i: int) {
+  const D = {1..10} dmapped Block({1..10});
+  var A: [D] int;
+  A = i;
+  return + reduce A;
+}
+
+proc sumOver(D: domain, i: int) {
+  var A: [D] int;
+  A = i;
+  return + reduce A;
+}
+
+var sum = sumNew(1);
+const pids = chpl_numPrivatizedPids();
+for i in 2..n do
+  sum += sumNew(i);
+writeln(sum);
+writeln(chpl_numPrivatizedPids() == pids);
+
+const D = {1..10} dmapped Block({1..10});
+const withD = chpl_numPrivatizedPids();
+sum = 0;
+for i in 1..n do
+  sum += sumOver(D, i);
+writeln(sum);
+writeln(chpl_numPrivatizedPids() == withD);
@@ -0,0 +1,50 @@
+//
+// Multi-locale version of freePrivatized: destroying a Block array,
+// domain or distribution must release its pid and free the copies on
+// every locale, not just the original.
+//
+use BlockDist, Memory;
+
+extern proc chpl_numPrivatizedPids(): int(64);
+
+config const n = 100;
+
+proc sumNew(i: int) {
+  const D = {1..100} dmapped Block({1..100});
+  var A: [D] int;
+  A = i;
+  return + reduce A;
+}
+
+proc sumOver(D: domain, i: int) {
+  var A: [D] int;
+  A = i;
+  return + reduce A;
+}
+
+proc getMemUsed(ref used: [] uint(64)) {
+  for loc in Locales do on loc do
+    used[loc.id] = memoryUsed();
+}
+
+var before, after: [LocaleSpace] uint(64);
+
+var sum = sumNew(1);
+const pids = chpl_numPrivatizedPids();
+getMemUsed(before);
+for i in 2..n do
+  sum += sumNew(i);
+writeln(sum);
+writeln(chpl_numPrivatizedPids() == pids);
+getMemUsed(after);
+writeln(&& reduce (after == before));
+
+{
+  const D = {1..100} dmapped Block({1..100});
+  const withD = chpl_numPrivatizedPids();
+  sum = 0;
+  for i in 1..n do
+    sum += sumOver(D, i);
+  writeln(sum);
+  writeln(chpl_numPrivatizedPids() == withD);
+}
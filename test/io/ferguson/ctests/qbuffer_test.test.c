@@ -549,6 +549,70 @@ void test_qbuffer_edges(void)
   qbytes_release(b3);
 }
 
+void test_qbuffer_trim(void)
+{
+  qbuffer_t buf;
+  qbytes_t* b[4];
+  qbytes_t* got;
+  int64_t skip, len;
+  qbuffer_iter_t start, end;
+  qioerr err;
+  int i;
+
+  for( i = 0; i < 4; i++ ) {
+    err = qbytes_create_calloc(&b[i], 10 * (i + 1));
+    assert(!err);
+    fill_test_data(b[i], i);
+  }
+
+  err = qbuffer_init(&buf);
+  assert(!err);
+
+  // 100 bytes in parts of 10, 20, 30, 40
+  for( i = 0; i < 4; i++ ) {
+    err = qbuffer_append(&buf, b[i], 0, b[i]->len);
+    assert(!err);
+  }
+
+  // Remove the last two parts entirely and 5 bytes of the second one.
+  qbuffer_trim_back(&buf, 75);
+  assert( qbuffer_start_offset(&buf) == 0 );
+  assert( qbuffer_end_offset(&buf) == 25 );
+
+  start = qbuffer_begin(&buf);
+  end = qbuffer_end(&buf);
+  assert( deque_size(sizeof(qbuffer_part_t), &buf.deque) == 2 );
+
+  // The parts left are the first ones.
+  qbuffer_iter_get(start, end, &got, &skip, &len);
+  assert( got == b[0] && skip == 0 && len == 10 );
+  qbuffer_iter_next_part(&buf, &start);
+  qbuffer_iter_get(start, end, &got, &skip, &len);
+  assert( got == b[1] && skip == 0 && len == 15 );
+
+  // Only the removed parts were released.
+  assert( DO_GET_REFCNT(b[0]) == 2 );
+  assert( DO_GET_REFCNT(b[1]) == 2 );
+  assert( DO_GET_REFCNT(b[2]) == 1 );
+  assert( DO_GET_REFCNT(b[3]) == 1 );
+
+  // Trim into the first part.
+  qbuffer_trim_back(&buf, 20);
+  assert( qbuffer_end_offset(&buf) == 5 );
+  start = qbuffer_begin(&buf);
+  end = qbuffer_end(&buf);
+  qbuffer_iter_get(start, end, &got, &skip, &len);
+  assert( got == b[0] && skip == 0 && len == 5 );
+  assert( DO_GET_REFCNT(b[0]) == 2 );
+  assert( DO_GET_REFCNT(b[1]) == 1 );
+
+  qbuffer_destroy(&buf);
+
+  for( i = 0; i < 4; i++ ) {
+    qbytes_release(b[i]);
+  }
+}
+
 
 int main(int argc, char** argv)
 {
@@ -560,6 +624,8 @@ int main(int argc, char** argv)
 
   test_qbuffer_edges();
 
+  test_qbuffer_trim();
+
   printf("qbuffer_test PASS\n");
 
   return 0;
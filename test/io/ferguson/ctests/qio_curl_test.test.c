@@ -0,0 +1,270 @@
+#include "qio.h"
+#include "qio_plugin_curl.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+// A minimal HTTP/1.1 server on localhost that serves one file and
+// understands HEAD and single byte range GET requests.
+
+static unsigned char* file_data;
+static size_t file_len;
+static int server_port;
+static int num_gets;
+
+static
+void send_all(int fd, const void* buf, size_t len)
+{
+  size_t done = 0;
+  ssize_t got;
+
+  while( done < len ) {
+    got = send(fd, (const char*) buf + done, len - done, MSG_NOSIGNAL);
+    if( got <= 0 ) return;
+    done += got;
+  }
+}
+
+static
+void* serve_connection(void* arg)
+{
+  int fd = (int) (intptr_t) arg;
+  char req[4096];
+  char hdr[512];
+  size_t used = 0;
+  ssize_t got;
+  char* end;
+  char* range;
+  long long start, last;
+  int hlen;
+
+  while( 1 ) {
+    req[used] = '\0';
+    end = strstr(req, "\r\n\r\n");
+    if( ! end ) {
+      if( used == sizeof(req) - 1 ) break;
+      got = recv(fd, req + used, sizeof(req) - 1 - used, 0);
+      if( got <= 0 ) break;
+      used += got;
+      continue;
+    }
+    *end = '\0';
+
+    if( strncmp(req, "HEAD ", 5) == 0 ) {
+      hlen = snprintf(hdr, sizeof(hdr),
+                      "HTTP/1.1 200 OK\r\nContent-Length: %lld\r\n"
+                      "Accept-Ranges: bytes\r\n\r\n", (long long) file_len);
+      send_all(fd, hdr, hlen);
+    } else {
+      __sync_fetch_and_add(&num_gets, 1);
+      start = 0;
+      last = file_len - 1;
+      range = strstr(req, "Range: bytes=");
+      if( range ) {
+        sscanf(range + 13, "%lld-%lld", &start, &last);
+        if( last >= (long long) file_len ) last = file_len - 1;
+        hlen = snprintf(hdr, sizeof(hdr),
+                        "HTTP/1.1 206 Partial Content\r\nContent-Length: %lld\r\n"
+                        "Content-Range: bytes %lld-%lld/%lld\r\n\r\n",
+                        last - start + 1, start, last, (long long) file_len);
+      } else {
+        hlen = snprintf(hdr, sizeof(hdr),
+                        "HTTP/1.1 200 OK\r\nContent-Length: %lld\r\n\r\n",
+                        (long long) file_len);
+      }
+      send_all(fd, hdr, hlen);
+      send_all(fd, file_data + start, last - start + 1);
+    }
+
+    // keep any pipelined request
+    used -= (end + 4) - req;
+    memmove(req, end + 4, used);
+  }
+
+  close(fd);
+  return NULL;
+}
+
+static
+void* serve(void* arg)
+{
+  int lfd = (int) (intptr_t) arg;
+  pthread_t thread;
+  int fd;
+
+  while( 1 ) {
+    fd = accept(lfd, NULL, NULL);
+    if( fd < 0 ) break;
+    pthread_create(&thread, NULL, serve_connection, (void*) (intptr_t) fd);
+    pthread_detach(thread);
+  }
+  return NULL;
+}
+
+static
+void start_server(void)
+{
+  struct sockaddr_in addr;
+  socklen_t addrlen = sizeof(addr);
+  pthread_t thread;
+  int lfd;
+  int rc;
+
+  lfd = socket(AF_INET, SOCK_STREAM, 0);
+  assert(lfd >= 0);
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  addr.sin_port = 0;
+  rc = bind(lfd, (struct sockaddr*) &addr, sizeof(addr));
+  assert(rc == 0);
+  rc = listen(lfd, 64);
+  assert(rc == 0);
+  rc = getsockname(lfd, (struct sockaddr*) &addr, &addrlen);
+  assert(rc == 0);
+  server_port = ntohs(addr.sin_port);
+
+  pthread_create(&thread, NULL, serve, (void*) (intptr_t) lfd);
+  pthread_detach(thread);
+}
+
+static
+qio_file_t* open_url(void)
+{
+  char url[128];
+  qio_file_t* f;
+  qioerr err;
+
+  snprintf(url, sizeof(url), "http://127.0.0.1:%d/data", server_port);
+  err = qio_file_open_access_usr(&f, url, "r", 0, NULL, NULL, curl_function_struct_ptr);
+  assert(!err);
+  return f;
+}
+
+// Read [start, end) in small pieces and check it.
+static
+void check_read(qio_file_t* f, int64_t start, int64_t end)
+{
+  qio_channel_t* ch;
+  unsigned char buf[1000];
+  int64_t pos;
+  ssize_t n;
+  qioerr err;
+
+  err = qio_channel_create(&ch, f, 0, 1, 0, start, end, NULL);
+  assert(!err);
+
+  for( pos = start; pos < end; pos += n ) {
+    n = end - pos;
+    if( n > (ssize_t) sizeof(buf) ) n = sizeof(buf);
+    err = qio_channel_read_amt(1, ch, buf, n);
+    assert(!err);
+    assert(memcmp(buf, file_data + pos, n) == 0);
+  }
+
+  err = qio_channel_close(1, ch);
+  assert(!err);
+  qio_channel_release(ch);
+}
+
+typedef struct {
+  qio_file_t* f;
+  int64_t start;
+  int64_t end;
+} region_t;
+
+static
+void* read_region(void* arg)
+{
+  region_t* r = (region_t*) arg;
+  check_read(r->f, r->start, r->end);
+  return NULL;
+}
+
+static
+int read_all_count_gets(void)
+{
+  qio_file_t* f;
+  int64_t len;
+  qioerr err;
+  int before = num_gets;
+
+  f = open_url();
+  err = qio_file_length(f, &len);
+  assert(!err);
+  assert(len == (int64_t) file_len);
+  check_read(f, 0, file_len);
+  err = qio_file_close(f);
+  assert(!err);
+  qio_file_release(f);
+
+  return num_gets - before;
+}
+
+int main(int argc, char** argv)
+{
+  qio_file_t* f;
+  region_t regions[8];
+  pthread_t threads[8];
+  uint64_t x = 88172645463325252ULL;
+  int cached, uncached;
+  qioerr err;
+  size_t i;
+
+  file_len = 3000000;
+  file_data = (unsigned char*) malloc(file_len);
+  assert(file_data);
+  for( i = 0; i < file_len; i++ ) {
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    file_data[i] = x & 0xff;
+  }
+
+  start_server();
+
+  // Without the cache, every buffer fill is its own request.
+  setenv("CHPL_RT_QIO_CURL_CACHE_BLOCKS", "0", 1);
+  uncached = read_all_count_gets();
+
+  // Small blocks so that reads cross many block boundaries.
+  setenv("CHPL_RT_QIO_CURL_CACHE_BLOCKS", "8", 1);
+  setenv("CHPL_RT_QIO_CURL_BLOCK_SIZE", "65536", 1);
+  setenv("CHPL_RT_QIO_CURL_READAHEAD", "6", 1);
+  setenv("CHPL_RT_QIO_CURL_PARALLEL", "3", 1);
+  cached = read_all_count_gets();
+  assert(cached < uncached);
+
+  f = open_url();
+
+  // Reads starting and ending in the middle of blocks
+  for( i = 0; i < 40; i++ ) {
+    int64_t start = (i * 7919 * 131ULL) % file_len;
+    int64_t end = start + (i * 40099) % 300000;
+    if( end > (int64_t) file_len ) end = file_len;
+    check_read(f, start, end);
+  }
+
+  // Several readers on the same handle at once
+  for( i = 0; i < 8; i++ ) {
+    regions[i].f = f;
+    regions[i].start = file_len * i / 8;
+    regions[i].end = file_len * (i + 1) / 8;
+    pthread_create(&threads[i], NULL, read_region, &regions[i]);
+  }
+  for( i = 0; i < 8; i++ ) pthread_join(threads[i], NULL);
+
+  err = qio_file_close(f);
+  assert(!err);
+  qio_file_release(f);
+
+  free(file_data);
+
+  printf("qio_curl_test PASS\n");
+  return 0;
+}
@@ -1416,6 +1416,297 @@ void test_quoted_string_maxlength(void)
   if( verbose ) printf("PASS: quoted max length\n");
 }
 
+// Scan many numbers in the default style, so that most of them
+// are read by the fast path but some straddle buffer boundaries.
+void test_scan_numbers_fast(void)
+{
+  const char* ints[] = {"0", "7", "-7", "00042", "-0", "1234567",
+                        "12345678", "123456789", "-1234567890123456",
+                        "9223372036854775807", "-9223372036854775807",
+                        "0000000000000000000000001", NULL};
+  const char* floats[] = {"0", "-0.0", "1", "1.5", "-2.25", "0.1", ".5",
+                          "5.", "1e5", "1E-5", "3.14159265358979",
+                          "2.2250738585072014e-308", "1.7976931348623157e308",
+                          "123456789012345678901234567890",
+                          "0.000000000000000000000000000001",
+                          "9007199254740993", "4.9406564584124654e-324",
+                          "1.125e+300", "6.125e-300", "00001.25000", NULL};
+  const char* seps[] = {" ", "\n", " \t "};
+  qioerr err;
+  qio_file_t* f;
+  qio_channel_t* writing;
+  qio_channel_t* reading;
+  int64_t n = 0;
+  int i, j;
+
+  err = qio_file_open_tmp(&f, 0, NULL);
+  assert(!err);
+
+  err = qio_channel_create(&writing, f, QIO_CH_BUFFERED, 0, 1, 0, INT64_MAX, NULL);
+  assert(!err);
+
+  for( j = 0; j < 500; j++ ) {
+    for( i = 0; ints[i]; i++ ) {
+      err = qio_channel_write_amt(false, writing, ints[i], strlen(ints[i]));
+      assert(!err);
+      err = qio_channel_write_amt(false, writing, seps[(i+j)%3], strlen(seps[(i+j)%3]));
+      assert(!err);
+    }
+    for( i = 0; floats[i]; i++ ) {
+      err = qio_channel_write_amt(false, writing, floats[i], strlen(floats[i]));
+      assert(!err);
+      err = qio_channel_write_amt(false, writing, seps[(i+j)%3], strlen(seps[(i+j)%3]));
+      assert(!err);
+    }
+  }
+  qio_channel_release(writing);
+
+  err = qio_channel_create(&reading, f, QIO_CH_BUFFERED, 1, 0, 0, INT64_MAX, NULL);
+  assert(!err);
+
+  for( j = 0; j < 500; j++ ) {
+    for( i = 0; ints[i]; i++ ) {
+      int64_t got = 1;
+      err = qio_channel_scan_int(false, reading, &got, 8, 1);
+      assert(!err);
+      assert(got == strtoll(ints[i], NULL, 10));
+      n++;
+    }
+    for( i = 0; floats[i]; i++ ) {
+      double got = 1;
+      double expect = strtod(floats[i], NULL);
+      err = qio_channel_scan_float(false, reading, &got, 8);
+      assert(!err);
+      assert(0 == memcmp(&got, &expect, sizeof(double)));
+      n++;
+    }
+  }
+
+  // At the end of the file, the slow path reports EOF.
+  {
+    int64_t got;
+    err = qio_channel_scan_int(false, reading, &got, 8, 1);
+    assert(qio_err_to_int(err) == EEOF);
+  }
+
+  qio_channel_release(reading);
+
+  qio_file_release(f);
+  f = NULL;
+
+  if( verbose ) printf("PASS: test_scan_numbers_fast %lli\n", (long long int) n);
+}
+
+// Print many reals in the default style and with explicit precisions,
+// checking that they match what printf would give.
+void test_print_float_printf(void)
+{
+  qioerr err;
+  qio_file_t* f;
+  qio_channel_t* writing;
+  qio_channel_t* reading;
+  qio_style_t style;
+  int precisions[] = {-1, 0, 1, 3, 10, 15, 17};
+  int nprecisions = sizeof(precisions)/sizeof(precisions[0]);
+  int n = 5000;
+  int i, p, showpoint;
+  uint64_t seed = 1;
+  char expect[64];
+  char got[64];
+
+  for( p = 0; p < nprecisions; p++ ) {
+    for( showpoint = 0; showpoint < 2; showpoint++ ) {
+      err = qio_file_open_tmp(&f, 0, NULL);
+      assert(!err);
+
+      style = qio_style_default();
+      style.precision = precisions[p];
+      style.showpoint = showpoint;
+      style.showpointzero = 0;
+
+      err = qio_channel_create(&writing, f, QIO_CH_BUFFERED, 0, 1, 0, INT64_MAX, &style);
+      assert(!err);
+      err = qio_channel_create(&reading, f, QIO_CH_BUFFERED, 1, 0, 0, INT64_MAX, NULL);
+      assert(!err);
+
+      for( i = 0; i < n; i++ ) {
+        double num;
+        ssize_t len;
+        seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+        if( i % 2 ) {
+          memcpy(&num, &seed, sizeof(double));
+          if( isnan(num) ) num = 0.0;
+        } else {
+          num = (double) (seed >> 40) / 1000.0;
+        }
+
+        err = qio_channel_print_float(false, writing, &num, 8);
+        assert(!err);
+        err = qio_channel_write_amt(false, writing, "\n", 1);
+        assert(!err);
+        err = qio_channel_flush(false, writing);
+        assert(!err);
+
+        snprintf(expect, sizeof(expect), showpoint ? "%#.*g" : "%.*g",
+                 precisions[p] < 0 ? 6 : precisions[p], num);
+        len = strlen(expect) + 1;
+        err = qio_channel_read_amt(false, reading, got, len);
+        assert(!err);
+        got[len-1] = '\0';
+        if( strcmp(got, expect) != 0 ) {
+          printf("%.17g with precision %i printed as %s not %s\n",
+                 num, precisions[p], got, expect);
+          assert(0);
+        }
+      }
+
+      qio_channel_release(writing);
+      qio_channel_release(reading);
+      qio_file_release(f);
+      f = NULL;
+    }
+  }
+
+  if( verbose ) printf("PASS: print float matches printf\n");
+}
+
+void test_scan_fields(void)
+{
+  qioerr err;
+  qio_file_t* f;
+  qio_channel_t* writing;
+  qio_channel_t* reading;
+  const char* csv = "name,count,weight,id\n"
+                    "apple, 3, 1.5, 18446744073709551615\n"
+                    "\"b, \"\"c\"\"\",-42,,7\r\n"
+                    "\n"
+                    "\"multi\nline\",0,2e3,0\n"
+                    "last,1,0.25,1";
+  const char* bad = "a,1,2\n" // too few
+                    "a,1,2,3,4\n" // too many
+                    "a,x,2,3\n" // not a number
+                    "a,9223372036854775808,2,3\n" // too big for int64
+                    "a,-129,2,3\n" // too small for int(8)
+                    "a,1,2,256\n"; // too big for uint(8)
+  int8_t types[4] = {QIO_FIELD_STRING, QIO_FIELD_INT, QIO_FIELD_REAL, QIO_FIELD_UINT};
+  int8_t bits8[4] = {0, 8, 0, 8};
+  int8_t skiptypes[5] = {QIO_FIELD_SKIP, QIO_FIELD_SKIP, QIO_FIELD_SKIP,
+                         QIO_FIELD_SKIP, QIO_FIELD_SKIP};
+  int8_t spacetypes[3] = {QIO_FIELD_INT, QIO_FIELD_REAL, QIO_FIELD_STRING};
+  int64_t nums[5];
+  double reals[5];
+  const char* strs[5];
+  int i;
+
+  err = qio_file_open_tmp(&f, 0, NULL);
+  assert(!err);
+
+  err = qio_channel_create(&writing, f, QIO_CH_BUFFERED, 0, 1, 0, INT64_MAX, NULL);
+  assert(!err);
+  for( i = 0; i < 100; i++ ) {
+    err = qio_channel_write_amt(false, writing, csv, strlen(csv));
+    assert(!err);
+    err = qio_channel_write_amt(false, writing, "\n", 1);
+    assert(!err);
+  }
+  err = qio_channel_write_amt(false, writing, bad, strlen(bad));
+  assert(!err);
+  qio_channel_release(writing);
+
+  err = qio_channel_create(&reading, f, QIO_CH_BUFFERED, 1, 0, 0, INT64_MAX, NULL);
+  assert(!err);
+
+  for( i = 0; i < 100; i++ ) {
+    // the header
+    err = qio_channel_scan_fields(false, reading, ",", 4, skiptypes, NULL, nums, reals, strs);
+    assert(!err);
+
+    err = qio_channel_scan_fields(false, reading, ",", 4, types, NULL, nums, reals, strs);
+    assert(!err);
+    assert(0 == strcmp(strs[0], "apple"));
+    assert(nums[1] == 3 && reals[2] == 1.5 && (uint64_t) nums[3] == UINT64_MAX);
+    qio_free((void*) strs[0]);
+
+    reals[2] = 9.0;
+    err = qio_channel_scan_fields(false, reading, ",", 4, types, NULL, nums, reals, strs);
+    assert(!err);
+    assert(0 == strcmp(strs[0], "b, \"c\""));
+    assert(nums[1] == -42 && reals[2] == 9.0 && nums[3] == 7);
+    qio_free((void*) strs[0]);
+
+    err = qio_channel_scan_fields(false, reading, ",", 4, types, NULL, nums, reals, strs);
+    assert(!err);
+    assert(0 == strcmp(strs[0], "multi\nline"));
+    assert(nums[1] == 0 && reals[2] == 2000.0 && nums[3] == 0);
+    qio_free((void*) strs[0]);
+
+    err = qio_channel_scan_fields(false, reading, ",", 4, types, NULL, nums, reals, strs);
+    assert(!err);
+    assert(0 == strcmp(strs[0], "last"));
+    assert(nums[1] == 1 && reals[2] == 0.25 && nums[3] == 1);
+    qio_free((void*) strs[0]);
+  }
+
+  // Errors don't consume the record.
+  err = qio_channel_scan_fields(false, reading, ",", 4, types, NULL, nums, reals, strs);
+  assert(qio_err_to_int(err) == EFORMAT);
+  err = qio_channel_scan_fields(false, reading, ",", 3, skiptypes, NULL, nums, reals, strs);
+  assert(!err);
+  err = qio_channel_scan_fields(false, reading, ",", 4, types, NULL, nums, reals, strs);
+  assert(qio_err_to_int(err) == EFORMAT);
+  err = qio_channel_scan_fields(false, reading, ",", 5, skiptypes, NULL, nums, reals, strs);
+  assert(!err);
+  err = qio_channel_scan_fields(false, reading, ",", 4, types, NULL, nums, reals, strs);
+  assert(qio_err_to_int(err) == EFORMAT);
+  err = qio_channel_scan_fields(false, reading, ",", 4, skiptypes, NULL, nums, reals, strs);
+  assert(!err);
+  // Out of range, whether for 64 bits or for a narrower field
+  err = qio_channel_scan_fields(false, reading, ",", 4, types, NULL, nums, reals, strs);
+  assert(qio_err_to_int(err) == ERANGE);
+  err = qio_channel_scan_fields(false, reading, ",", 4, skiptypes, NULL, nums, reals, strs);
+  assert(!err);
+  err = qio_channel_scan_fields(false, reading, ",", 4, types, bits8, nums, reals, strs);
+  assert(qio_err_to_int(err) == ERANGE);
+  err = qio_channel_scan_fields(false, reading, ",", 4, types, NULL, nums, reals, strs);
+  assert(!err);
+  assert(nums[1] == -129);
+  qio_free((void*) strs[0]);
+  err = qio_channel_scan_fields(false, reading, ",", 4, types, bits8, nums, reals, strs);
+  assert(qio_err_to_int(err) == ERANGE);
+  bits8[3] = 16;
+  err = qio_channel_scan_fields(false, reading, ",", 4, types, bits8, nums, reals, strs);
+  assert(!err);
+  assert(nums[1] == 1 && nums[3] == 256);
+  qio_free((void*) strs[0]);
+
+  err = qio_channel_scan_fields(false, reading, ",", 4, types, NULL, nums, reals, strs);
+  assert(qio_err_to_int(err) == EEOF);
+
+  qio_channel_release(reading);
+  qio_file_release(f);
+
+  // Space-separated fields.
+  err = qio_file_open_tmp(&f, 0, NULL);
+  assert(!err);
+  err = qio_channel_create(&writing, f, QIO_CH_BUFFERED, 0, 1, 0, INT64_MAX, NULL);
+  assert(!err);
+  err = qio_channel_write_amt(false, writing, "  1\t 2.5  x \n", 13);
+  assert(!err);
+  qio_channel_release(writing);
+
+  err = qio_channel_create(&reading, f, QIO_CH_BUFFERED, 1, 0, 0, INT64_MAX, NULL);
+  assert(!err);
+  err = qio_channel_scan_fields(false, reading, " \t", 3, spacetypes, NULL, nums, reals, strs);
+  assert(!err);
+  assert(nums[0] == 1 && reals[1] == 2.5);
+  assert(0 == strcmp(strs[2], "x"));
+  qio_free((void*) strs[2]);
+  qio_channel_release(reading);
+  qio_file_release(f);
+
+  if( verbose ) printf("PASS: scan fields\n");
+}
+
 int main(int argc, char** argv)
 {
   int sizes[] = {qbytes_iobuf_size, 1, 2, 0};
@@ -1451,6 +1742,9 @@ int main(int argc, char** argv)
     test_endian();
     test_printscan_int();
     test_printscan_float();
+    test_scan_numbers_fast();
+    test_print_float_printf();
+    test_scan_fields();
 
     test_readwritestring();
 
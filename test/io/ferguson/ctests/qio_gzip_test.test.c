@@ -0,0 +1,417 @@
+#include "qio.h"
+#include "qio_plugin_gzip.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <zlib.h>
+
+// Data with a mix of compressible text and incompressible noise, so that
+// some blocks fall back to being stored.
+static
+void fill_data(unsigned char* data, size_t len)
+{
+  uint64_t x = 88172645463325252ULL;
+  size_t i;
+
+  for( i = 0; i < len; i++ ) {
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    if( (i / 100000) % 3 == 2 ) data[i] = x & 0xff;
+    else data[i] = "abcdefgh ,\n"[(x >> 11) % 11];
+  }
+}
+
+static
+void write_gzip(const char* path, const unsigned char* data, size_t len)
+{
+  qio_file_t* f;
+  qio_channel_t* ch;
+  qioerr err;
+  size_t off, n;
+
+  err = qio_file_open_access_usr(&f, path, "w", 0, NULL, NULL, gzip_function_struct_ptr);
+  assert(!err);
+
+  err = qio_channel_create(&ch, f, 0, 0, 1, 0, INT64_MAX, NULL);
+  assert(!err);
+
+  // write in odd-sized pieces
+  for( off = 0; off < len; off += n ) {
+    n = 12345;
+    if( n > len - off ) n = len - off;
+    err = qio_channel_write_amt(1, ch, data + off, n);
+    assert(!err);
+  }
+
+  err = qio_channel_close(1, ch);
+  assert(!err);
+  qio_channel_release(ch);
+
+  err = qio_file_close(f);
+  assert(!err);
+  qio_file_release(f);
+}
+
+static
+void check_read(qio_file_t* f, const unsigned char* data, int64_t start, int64_t end)
+{
+  qio_channel_t* ch;
+  unsigned char* got;
+  ssize_t amt;
+  unsigned char c;
+  qioerr err;
+
+  got = (unsigned char*) malloc(end - start);
+  assert(got);
+
+  err = qio_channel_create(&ch, f, 0, 1, 0, start, INT64_MAX, NULL);
+  assert(!err);
+
+  err = qio_channel_read_amt(1, ch, got, end - start);
+  assert(!err);
+  assert(memcmp(got, data + start, end - start) == 0);
+
+  if( end == start ) {
+    // nothing else to read
+  } else {
+    err = qio_channel_read(1, ch, &c, 1, &amt);
+    assert(amt == 0 || c == data[end]);
+  }
+
+  err = qio_channel_close(1, ch);
+  assert(!err);
+  qio_channel_release(ch);
+  free(got);
+}
+
+typedef struct {
+  qio_file_t* f;
+  const unsigned char* data;
+  int64_t start;
+  int64_t end;
+} region_t;
+
+static
+void* read_region(void* arg)
+{
+  region_t* r = (region_t*) arg;
+  check_read(r->f, r->data, r->start, r->end);
+  return NULL;
+}
+
+static
+void test_roundtrip(size_t len)
+{
+  const char* path = "qio_gzip_test.gz";
+  unsigned char* data;
+  unsigned char* got;
+  qio_file_t* f;
+  int64_t flen;
+  gzFile gz;
+  int fstype;
+  region_t regions[8];
+  pthread_t threads[8];
+  qioerr err;
+  int i, n;
+
+  data = (unsigned char*) malloc(len + 1);
+  got = (unsigned char*) malloc(len + 1);
+  assert(data && got);
+  fill_data(data, len);
+
+  write_gzip(path, data, len);
+
+  // The file is an ordinary (multi-member) gzip file.
+  gz = gzopen(path, "rb");
+  assert(gz);
+  n = gzread(gz, got, len + 1);
+  assert(n == (int) len);
+  assert(memcmp(got, data, len) == 0);
+  gzclose(gz);
+
+  err = qio_file_open_access_usr(&f, path, "r", 0, NULL, NULL, gzip_function_struct_ptr);
+  assert(!err);
+
+  err = qio_get_fs_type(f, &fstype);
+  assert(!err && fstype == FTYPE_GZIP);
+
+  err = qio_file_length(f, &flen);
+  assert(!err);
+  assert(flen == (int64_t) len);
+
+  check_read(f, data, 0, len);
+
+  // Read some ranges that start and end in the middle of blocks.
+  if( len > 0 ) {
+    for( i = 0; i < 50; i++ ) {
+      int64_t start = (int64_t) ((i * 7919 * 131ULL) % len);
+      int64_t end = start + (i * 4099) % 200000;
+      if( end > (int64_t) len ) end = len;
+      check_read(f, data, start, end);
+    }
+  }
+
+  // Several readers on the same file at once.
+  for( i = 0; i < 8; i++ ) {
+    regions[i].f = f;
+    regions[i].data = data;
+    regions[i].start = len * i / 8;
+    regions[i].end = len * (i + 1) / 8;
+    pthread_create(&threads[i], NULL, read_region, &regions[i]);
+  }
+  for( i = 0; i < 8; i++ ) pthread_join(threads[i], NULL);
+
+  err = qio_file_close(f);
+  assert(!err);
+  qio_file_release(f);
+
+  unlink(path);
+  free(data);
+  free(got);
+}
+
+// Files written by other gzip tools have no block index, so they are
+// read as a stream.
+static
+void test_plain_gzip(void)
+{
+  const char* path = "qio_gzip_test_plain.gz";
+  size_t len = 300000;
+  unsigned char* data;
+  qio_file_t* f;
+  gzFile gz;
+  qioerr err;
+  int n;
+
+  data = (unsigned char*) malloc(len);
+  assert(data);
+  fill_data(data, len);
+
+  // two members, as from cat a.gz b.gz
+  gz = gzopen(path, "wb");
+  assert(gz);
+  n = gzwrite(gz, data, 100000);
+  assert(n == 100000);
+  gzclose(gz);
+  gz = gzopen(path, "ab");
+  assert(gz);
+  n = gzwrite(gz, data + 100000, len - 100000);
+  assert(n == (int) (len - 100000));
+  gzclose(gz);
+
+  err = qio_file_open_access_usr(&f, path, "r", 0, NULL, NULL, gzip_function_struct_ptr);
+  assert(!err);
+
+  assert(!(f->fdflags & QIO_FDFLAG_SEEKABLE));
+
+  check_read(f, data, 0, len);
+
+  err = qio_file_close(f);
+  assert(!err);
+  qio_file_release(f);
+
+  unlink(path);
+  free(data);
+}
+
+// A minimal in-memory file system, standing in for curl or HDFS to check
+// that gzip can be layered on another plugin.
+typedef struct {
+  unsigned char* buf;
+  size_t len;
+  size_t cap;
+  off_t offset;
+  int calls;
+} mem_file_t;
+
+static mem_file_t mem_file;
+
+static
+qioerr mem_writev(void* file, const struct iovec* iov, int iovcnt, ssize_t* num_written_out, void* fs)
+{
+  mem_file_t* m = (mem_file_t*) file;
+  ssize_t total = 0;
+  int i;
+
+  assert(fs == &mem_file);
+  m->calls++;
+  for( i = 0; i < iovcnt; i++ ) {
+    if( m->len + iov[i].iov_len > m->cap ) {
+      m->cap = 2 * (m->len + iov[i].iov_len);
+      m->buf = (unsigned char*) realloc(m->buf, m->cap);
+      assert(m->buf);
+    }
+    memcpy(m->buf + m->len, iov[i].iov_base, iov[i].iov_len);
+    m->len += iov[i].iov_len;
+    total += iov[i].iov_len;
+  }
+  *num_written_out = total;
+  return 0;
+}
+
+static
+qioerr mem_preadv(void* file, const struct iovec* iov, int iovcnt, off_t offset, ssize_t* num_read_out, void* fs)
+{
+  mem_file_t* m = (mem_file_t*) file;
+  ssize_t total = 0;
+  size_t n;
+  int i;
+
+  assert(fs == &mem_file);
+  m->calls++;
+  for( i = 0; i < iovcnt && offset + total < (off_t) m->len; i++ ) {
+    n = m->len - (offset + total);
+    if( n > iov[i].iov_len ) n = iov[i].iov_len;
+    memcpy(iov[i].iov_base, m->buf + offset + total, n);
+    total += n;
+  }
+  *num_read_out = total;
+  if( total == 0 && iovcnt > 0 ) return qio_int_to_err(EEOF);
+  return 0;
+}
+
+static
+qioerr mem_readv(void* file, const struct iovec* iov, int iovcnt, ssize_t* num_read_out, void* fs)
+{
+  mem_file_t* m = (mem_file_t*) file;
+  qioerr err;
+
+  err = mem_preadv(file, iov, iovcnt, m->offset, num_read_out, fs);
+  m->offset += *num_read_out;
+  return err;
+}
+
+static
+qioerr mem_open(void** fd, const char* path, int* flags, mode_t mode, qio_hint_t iohints, void* fs)
+{
+  assert(fs == &mem_file);
+  if( (*flags & O_ACCMODE) == O_WRONLY ) mem_file.len = 0;
+  mem_file.offset = 0;
+  *fd = &mem_file;
+  return 0;
+}
+
+static
+qioerr mem_close(void* file, void* fs)
+{
+  return 0;
+}
+
+static
+qioerr mem_getlength(void* file, int64_t* len_out, void* fs)
+{
+  *len_out = ((mem_file_t*) file)->len;
+  return 0;
+}
+
+static
+qio_file_functions_t mem_functions = {
+    &mem_writev,    // writev
+    &mem_readv,     // readv
+    NULL,           // pwritev
+    &mem_preadv,    // preadv
+    &mem_close,     // close
+    &mem_open,      // open
+    NULL,           // seek
+    &mem_getlength, // filelength
+    NULL,           // getpath
+    NULL,           // fsync
+    NULL,           // getcwd
+    NULL,           // get_fs_type
+    NULL,           // get_chunk
+    NULL,           // get_locales_for_region
+};
+
+static
+void test_layered(void)
+{
+  qio_file_functions_t stream_functions = mem_functions;
+  size_t len = 1000000;
+  unsigned char* data;
+  unsigned char* got;
+  qio_file_t* f;
+  qio_channel_t* ch;
+  int64_t flen;
+  z_stream zs;
+  qioerr err;
+  int i;
+
+  data = (unsigned char*) malloc(len);
+  got = (unsigned char*) malloc(len);
+  assert(data && got);
+  fill_data(data, len);
+
+  err = gzip_file_open_access_usr(&f, "mem", "w", 0, NULL, &mem_file, &mem_functions);
+  assert(!err);
+  // The layer was on gzip_file_open_access_usr's stack; it isn't kept.
+  assert(f->fs_info == NULL);
+  err = qio_channel_create(&ch, f, 0, 0, 1, 0, INT64_MAX, NULL);
+  assert(!err);
+  err = qio_channel_write_amt(1, ch, data, len);
+  assert(!err);
+  err = qio_channel_close(1, ch);
+  assert(!err);
+  qio_channel_release(ch);
+  err = qio_file_close(f);
+  assert(!err);
+  qio_file_release(f);
+
+  // What reached the inner file system is compressed.
+  assert(mem_file.calls > 0);
+  assert(mem_file.len > 0 && mem_file.len < len);
+  memset(&zs, 0, sizeof(zs));
+  assert(inflateInit2(&zs, 15 + 32) == Z_OK);
+  zs.next_in = mem_file.buf;
+  zs.avail_in = mem_file.len;
+  zs.next_out = got;
+  zs.avail_out = len;
+  while( zs.avail_in > 0 && inflate(&zs, Z_NO_FLUSH) == Z_STREAM_END )
+    inflateReset(&zs);
+  inflateEnd(&zs);
+  assert(zs.avail_out == 0 && memcmp(got, data, len) == 0);
+
+  // Reading through the inner plugin builds a block index.
+  mem_file.calls = 0;
+  err = gzip_file_open_access_usr(&f, "mem", "r", 0, NULL, &mem_file, &mem_functions);
+  assert(!err);
+  assert(f->fdflags & QIO_FDFLAG_SEEKABLE);
+  err = qio_file_length(f, &flen);
+  assert(!err && flen == (int64_t) len);
+  check_read(f, data, 0, len);
+  for( i = 0; i < 20; i++ )
+    check_read(f, data, (int64_t) ((i * 7919 * 131ULL) % len), len);
+  err = qio_file_close(f);
+  assert(!err);
+  qio_file_release(f);
+  assert(mem_file.calls > 0);
+
+  // Without preadv the same file can still be streamed.
+  stream_functions.preadv = NULL;
+  err = gzip_file_open_access_usr(&f, "mem", "r", 0, NULL, &mem_file, &stream_functions);
+  assert(!err);
+  assert(!(f->fdflags & QIO_FDFLAG_SEEKABLE));
+  check_read(f, data, 0, len);
+  err = qio_file_close(f);
+  assert(!err);
+  qio_file_release(f);
+
+  free(mem_file.buf);
+  free(data);
+  free(got);
+}
+
+int main(int argc, char** argv)
+{
+  test_roundtrip(0);
+  test_roundtrip(100);
+  test_roundtrip(QIO_GZIP_BLOCK_SIZE);
+  test_roundtrip(3000000);
+  test_plain_gzip();
+  test_layered();
+
+  printf("qio_gzip_test PASS\n");
+  return 0;
+}
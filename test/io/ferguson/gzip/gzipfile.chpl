@@ -0,0 +1,47 @@
+use IO;
+
+config const path = "gzipfile.txt.gz";
+config const n = 100000;
+config const nreaders = 4;
+
+// Write enough lines to span many compressed blocks.
+{
+  var f = open(url="gzip://" + path, mode=iomode.cw);
+  var w = f.writer();
+  for i in 1..n do w.writeln(i, " ", i*i);
+  w.close();
+  f.close();
+}
+
+var f = open(url="gzip://" + path, mode=iomode.r);
+writeln(f.fstype() == FTYPE_GZIP);
+
+// Read it all back in order.
+{
+  var r = f.reader();
+  var ok = true;
+  for i in 1..n {
+    var a, b: int;
+    r.readln(a, b);
+    if a != i || b != i*i then ok = false;
+  }
+  writeln(ok);
+  r.close();
+}
+
+// Read pieces of it from several tasks at once, starting each reader in
+// the middle of a compressed block.
+const len = f.length();
+var counts: [0..#nreaders] int;
+forall t in 0..#nreaders {
+  const start = len * t / nreaders;
+  const end = len * (t+1) / nreaders;
+  var r = f.reader(start=start, end=end);
+  var c: uint(64);
+  while r.readbits(c, 8) do
+    if c == ascii("\n") then counts[t] += 1;
+  r.close();
+}
+writeln(+ reduce counts == n);
+
+f.close();
@@ -0,0 +1,50 @@
+config const n = 1000;
+const path = "maparray.bin";
+
+// Write a header and then n ints through a writeable shared mapping.
+{
+  var f = open(path, iomode.cwr);
+  {
+    var w = f.writer(kind=ionative);
+    w.write(12345);
+    w.close();
+  }
+  var A = f.mapArray(int, {1..n}, offset=numBytes(int), writeable=true);
+  forall i in 1..n do A[i] = i*i;
+  f.close();
+}
+
+// Read it back with a channel and with a read-only mapping.
+{
+  var f = open(path, iomode.r);
+  assert(f.length() == (n+1)*numBytes(int));
+  var r = f.reader(kind=ionative);
+  var x: int;
+  r.read(x);
+  assert(x == 12345);
+  for i in 1..n {
+    r.read(x);
+    assert(x == i*i);
+  }
+  r.close();
+
+  var B = f.mapArray(int, {1..n/10, 1..10}, offset=numBytes(int),
+                     hints=IOHINT_RANDOM);
+  assert(B[n/10, 10] == n*n);
+  assert(+ reduce B == + reduce [i in 1..n] i*i);
+  writeln("mapped sum ", + reduce B);
+  f.close();
+}
+
+// Changes to a private mapping stay out of the file.
+{
+  var f = open(path, iomode.rw);
+  {
+    var C = f.mapArray(int, {0..n}, writeable=true, shared=false);
+    C = 0;
+  }
+  var D = f.mapArray(int, {0..n});
+  assert(D[0] == 12345 && D[n] == n*n);
+  writeln("private ok");
+  f.close();
+}
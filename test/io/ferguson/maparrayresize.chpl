@@ -0,0 +1,16 @@
+// Assigning the same indices to the domain of a mapped array leaves it
+// mapped, but resizing it halts rather than silently copying the array
+// off the file.
+use IO;
+
+const path = "maparrayresize.bin";
+
+var f = open(path, iomode.cwr);
+var D = {1..10};
+var A = f.mapArray(int, D, writeable=true);
+A = 1;
+D = {1..10};
+A[10] = 10;
+writeln(+ reduce A);
+D = {1..20};
+writeln("should not get here");
@@ -0,0 +1,28 @@
+//
+// Read a file's lines with a forall loop, which splits the file into
+// pieces, and check that every line is seen exactly once and whole.
+//
+config const n = 100000;
+config const filename = "parlines.test.txt";
+
+proc check(delimiter:string) {
+  var f = open(filename, iomode.cwr);
+  var w = f.writer();
+  for i in 1..n do
+    w.write(i, delimiter);
+  w.close();
+
+  var numLines, sum, bad: atomic int;
+  forall line in f.lines(delimiter=ascii(delimiter):uint(8)) {
+    numLines.add(1);
+    if line.length < 2 || line.substring(line.length) != delimiter then
+      bad.add(1);
+    else
+      sum.add(line.substring(1..line.length-1):int);
+  }
+  writeln(numLines.read(), " ", sum.read() == n * (n + 1) / 2, " ", bad.read());
+  f.close();
+}
+
+check("\n");
+check(";");
@@ -0,0 +1,34 @@
+//
+// Replace a file by name after opening it.  A forall loop over its
+// lines must still read the open file on every locale, not the new
+// file that other locales would find by opening the path again.
+//
+use FileSystem;
+
+config const n = 100000;
+config const filename = "parlinesreplaced.test.txt";
+config const othername = "parlinesreplaced.other.txt";
+
+proc writeLines(name:string, first:int) {
+  var f = open(name, iomode.cw);
+  var w = f.writer();
+  for i in first..#n do
+    w.writeln(i);
+  w.close();
+  f.close();
+}
+
+writeLines(filename, 1);
+var f = open(filename, iomode.r);
+
+// A new file at the same path, with different numbers
+writeLines(othername, 100001);
+rename(othername, filename);
+
+var numLines, sum: atomic int;
+forall line in f.lines() {
+  numLines.add(1);
+  sum.add(line.substring(1..line.length-1):int);
+}
+writeln(numLines.read(), " ", sum.read() == n * (n + 1) / 2);
+f.close();
@@ -0,0 +1,71 @@
+// Read a CSV file into an array of records, one call per record.
+record Sale {
+  var item: string;
+  var count: int;
+  var price: real;
+  var store: uint(8);
+}
+
+record Header {
+  var a, b, c, d: string;
+}
+
+config const n = 1000;
+
+var f = open("readfields.csv", iomode.cwr);
+{
+  var w = f.writer();
+  w.writeln("item,count,price,store");
+  for i in 1..n {
+    if i % 100 == 0 then
+      w.writeln("\"widget, \"\"large\"\"\",", i, ",,", i % 7);
+    else
+      w.writeln("widget", i, ", ", i, ", ", i / 4.0, ", ", i % 7);
+  }
+  w.close();
+}
+
+var A: [1..n] Sale;
+{
+  var r = f.reader();
+  var header: Header;
+  r.readfields(header);
+  writeln(header);
+
+  for a in A {
+    a.price = -1.0;
+    r.readfields(a);
+  }
+
+  var extra: Sale;
+  writeln("more records: ", r.readfields(extra));
+  r.close();
+}
+
+var ok = true;
+for (a, i) in zip(A, 1..n) {
+  const item = if i % 100 == 0 then "widget, \"large\"" else "widget" + i;
+  const price = if i % 100 == 0 then -1.0 else i / 4.0;
+  if a.item != item || a.count != i || a.price != price || a.store != i % 7 {
+    writeln("mismatch at ", i, ": ", a);
+    ok = false;
+  }
+}
+writeln(A[100]);
+writeln(A[n]);
+writeln("all ok: ", ok);
+
+// A record with the wrong number of fields is an error.
+{
+  var w = f.writer();
+  w.writeln("a,1,2.0");
+  w.close();
+  var r = f.reader();
+  var s: Sale;
+  var err: syserr;
+  r.readfields(s, error=err);
+  writeln("short record error: ", err == EFORMAT);
+  r.close();
+}
+
+f.close();
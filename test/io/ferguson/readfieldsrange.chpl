@@ -0,0 +1,62 @@
+// A number that doesn't fit a narrow integer field is ERANGE, as with
+// read(), rather than being truncated into the field.  As with any
+// other readfields error, the record is not consumed and none of its
+// fields are set.
+record Small {
+  var name: string;
+  var a: uint(8);
+  var b: int(16);
+}
+
+record Skip {
+  var name, a, b: string;
+}
+
+record Wide {
+  var name: string;
+  var a: int;
+  var b: int;
+}
+
+var f = openmem();
+{
+  var w = f.writer();
+  w.writeln("ok,255,-32768");
+  w.writeln("big,256,0");
+  w.writeln("low,0,-32769");
+  w.writeln("high,0,32768");
+  w.writeln("huge,0,9223372036854775808");
+  w.writeln("after,1,1");
+  w.close();
+}
+
+var r = f.reader();
+var s: Small;
+var err: syserr;
+r.readfields(s, error=err);
+writeln(s, " ", err == ENOERR);
+
+// Each bad record fails the same way twice, then reads into wider
+// fields.
+for i in 1..3 {
+  for j in 1..2 {
+    var t = new Small("unset", 7, 7);
+    r.readfields(t, error=err);
+    writeln(t, " ", err == ERANGE);
+  }
+  var w: Wide;
+  r.readfields(w, error=err);
+  writeln(w, " ", err == ENOERR);
+}
+
+// Too big for int(64) behaves the same way.
+var t = new Wide("unset", 7, 7);
+r.readfields(t, error=err);
+writeln(t, " ", err == ERANGE);
+var skip: Skip;
+r.readfields(skip, error=err);
+
+r.readfields(s, error=err);
+writeln(s, " ", err == ENOERR);
+r.close();
+f.close();
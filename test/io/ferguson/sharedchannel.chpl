@@ -0,0 +1,25 @@
+// A channel is locked without the sync variable while only the task
+// that created it uses it; check that output stays intact when other
+// tasks start using it too.
+config const n = 10000;
+
+var f = openmem();
+{
+  var w = f.writer();
+  for i in 1..n do w.writeln(i);
+  forall i in n+1..2*n do w.writeln(i);
+  for i in 2*n+1..3*n do w.writeln(i);
+  w.close();
+}
+
+var seen: [1..3*n] bool;
+var r = f.reader();
+var x: int;
+var count = 0;
+while r.read(x) {
+  seen[x] = true;
+  count += 1;
+}
+r.close();
+writeln("lines: ", count == 3*n);
+writeln("all seen: ", && reduce seen);
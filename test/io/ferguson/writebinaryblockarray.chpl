@@ -0,0 +1,55 @@
+use BlockDist;
+
+config const n = 1000;
+
+// Block arrays written and read in binary native byte order go
+// directly between each locale and the file. Surround them with
+// other data to check that the channel position is kept right.
+proc test(D) {
+  var A: [D] int;
+  var k = 0;
+  for a in A {
+    k += 1;
+    a = k;
+  }
+
+  var f = open("binary-block.bin", iomode.cwr);
+  {
+    var w = f.writer(kind=ionative);
+    w.write(17, A, 42);
+    w.close();
+  }
+  assert(f.length() == (D.numIndices + 2) * numBytes(int));
+
+  {
+    // Element by element, as the serial path would have written it.
+    var r = f.reader(kind=ionative);
+    var x: int;
+    r.read(x);
+    assert(x == 17);
+    for i in 1..D.numIndices {
+      r.read(x);
+      assert(x == i);
+    }
+    r.read(x);
+    assert(x == 42);
+    r.close();
+  }
+
+  {
+    var B: [D] int;
+    var x, y: int;
+    var r = f.reader(kind=ionative);
+    r.read(x, B, y);
+    r.close();
+    assert(x == 17 && y == 42);
+    assert(&& reduce (A == B));
+  }
+  f.close();
+  writeln("ok ", D.rank);
+}
+
+const D1 = {1..n} dmapped Block({1..n});
+test(D1);
+const D2 = {1..n/10, 0..9} dmapped Block({1..n/10, 0..9});
+test(D2);
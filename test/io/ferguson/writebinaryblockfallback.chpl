@@ -0,0 +1,61 @@
+use BlockDist;
+
+config const n = 1000;
+
+// When the other locales can't open the channel's file by name, Block
+// arrays are written and read through the channel instead.
+const D = {1..n} dmapped Block({1..n});
+var A: [D] int;
+forall i in D do A(i) = i;
+
+proc check(f: file) {
+  {
+    var w = f.writer(kind=ionative);
+    w.write(17, A, 42);
+    w.close();
+  }
+  assert(f.length() == (n + 2) * numBytes(int));
+
+  var B: [D] int;
+  var x, y: int;
+  var r = f.reader(kind=ionative);
+  r.read(x, B, y);
+  r.close();
+  assert(x == 17 && y == 42);
+  assert(&& reduce (A == B));
+}
+
+// opentmp files are unlinked, so they have no path to open.
+{
+  var f = opentmp();
+  check(f);
+  f.close();
+  writeln("ok opentmp");
+}
+
+// A file that can't be opened for reading can't be reopened with
+// iomode.rw by the other locales.
+{
+  extern proc chmod(path: c_string, mode: int(32)): c_int;
+  const path = "binary-block-wronly.bin";
+  var f = open(path, iomode.cw);
+  chmod(path.c_str(), 0o200:int(32));
+  {
+    var w = f.writer(kind=ionative);
+    w.write(17, A, 42);
+    w.close();
+  }
+  f.close();
+  chmod(path.c_str(), 0o600:int(32));
+
+  var g = open(path, iomode.r);
+  var B: [D] int;
+  var x, y: int;
+  var r = g.reader(kind=ionative);
+  r.read(x, B, y);
+  r.close();
+  g.close();
+  assert(x == 17 && y == 42);
+  assert(&& reduce (A == B));
+  writeln("ok write-only");
+}
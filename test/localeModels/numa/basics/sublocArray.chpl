@@ -0,0 +1,17 @@
+//
+// Arrays declared on a sublocale get their data from that sublocale's
+// NUMA domain.  Make sure the placement doesn't disturb their contents.
+//
+config const n = 1000000;
+
+for loc in Locales do on loc {
+  for i in 0..#(here:LocaleModel).numSublocales do
+    on (here:LocaleModel).getChild(i) {
+      var A: [1..n] int;
+      forall j in A.domain do A[j] = j;
+      if + reduce A != n*(n+1)/2 then
+        writeln("[", here.id, "] Wrong sum on subloc ", i);
+    }
+}
+
+writeln("done");
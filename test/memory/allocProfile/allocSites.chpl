@@ -0,0 +1,19 @@
+//
+// Allocate from two made-up sites and check the allocation profile.
+// With --memProfile=1 every byte is a sample point, so the estimates
+// are exact.
+//
+extern proc chpl_mem_allocMany(number, size, description, lineno, filename:c_string): opaque;
+extern proc chpl_mem_free(ptr: opaque, lineno, filename:c_string);
+
+var a1 = chpl_mem_allocMany(1, 64, 0, 1, "profSiteA");
+var a2 = chpl_mem_allocMany(1, 64, 0, 1, "profSiteA");
+var a3 = chpl_mem_allocMany(1, 64, 0, 1, "profSiteA");
+var a4 = chpl_mem_allocMany(1, 64, 0, 1, "profSiteA");
+chpl_mem_free(a1, 2, "profSiteA");
+chpl_mem_free(a2, 2, "profSiteA");
+
+var b1 = chpl_mem_allocMany(10, 100, 0, 7, "profSiteB");
+chpl_mem_free(b1, 8, "profSiteB");
+
+writeln("done");
@@ -0,0 +1,89 @@
+//
+// Allocate, reallocate and free blocks of many sizes: small size
+// classes, page runs, and blocks that need whole chunks.  Every block
+// is filled with its own tag, so a block that moved without its
+// contents, or two live blocks that overlap, shows up as a mismatch.
+//
+extern proc chpl_mem_allocMany(number:size_t, size:size_t,
+                               description:int(16), lineno:int(32),
+                               filename:c_string): c_ptr(uint(8));
+extern proc chpl_mem_allocManyZero(number:size_t, size:size_t,
+                                   description:int(16), lineno:int(32),
+                                   filename:c_string): c_ptr(uint(8));
+extern proc chpl_mem_realloc(ptr:c_ptr(uint(8)), size:size_t,
+                             description:int(16), lineno:int(32),
+                             filename:c_string): c_ptr(uint(8));
+extern proc chpl_mem_free(ptr:c_ptr(uint(8)), lineno:int(32),
+                          filename:c_string);
+
+config const ops = 20000;
+config const slots = 256;
+
+var x: uint(64) = 7;
+
+proc rand(n: int): int {
+  x = x * 6364136223846793005 + 1442695040888963407;
+  return ((x >> 33) % n:uint(64)):int;
+}
+
+// Mostly small blocks, some page runs, and a few huge ones.
+proc pickSize(): int {
+  const r = rand(256);
+  if r < 200 then return 1 + rand(2048);
+  if r < 250 then return 2049 + rand(64*1024);
+  if r < 255 then return 64*1024 + rand(448*1024);
+  return 512*1024 + rand(2048*1024);
+}
+
+proc fill(p: c_ptr(uint(8)), lo: int, hi: int, tag: uint(8)) {
+  for i in lo..hi-1 do
+    p[i] = tag;
+}
+
+var bad = 0;
+
+proc check(p: c_ptr(uint(8)), n: int, tag: uint(8)) {
+  for i in 0..#n do
+    if p[i] != tag {
+      bad += 1;
+      return;
+    }
+}
+
+var ptrs: [0..#slots] c_ptr(uint(8));
+var sizes: [0..#slots] int;
+var tags: [0..#slots] uint(8);
+
+for i in 1..ops {
+  const s = rand(slots);
+  if is_c_nil(ptrs[s]) {
+    sizes[s] = pickSize();
+    tags[s] = (1 + i % 251):uint(8);
+    if rand(2) == 0 then
+      ptrs[s] = chpl_mem_allocMany(1, sizes[s]:size_t, 0, 0, "");
+    else {
+      ptrs[s] = chpl_mem_allocManyZero(1, sizes[s]:size_t, 0, 0, "");
+      check(ptrs[s], sizes[s], 0);
+    }
+    fill(ptrs[s], 0, sizes[s], tags[s]);
+  } else if rand(2) == 0 {
+    check(ptrs[s], sizes[s], tags[s]);
+    chpl_mem_free(ptrs[s], 0, "");
+    ptrs[s] = nil;
+  } else {
+    const n = pickSize();
+    check(ptrs[s], sizes[s], tags[s]);
+    ptrs[s] = chpl_mem_realloc(ptrs[s], n:size_t, 0, 0, "");
+    check(ptrs[s], min(n, sizes[s]), tags[s]);
+    fill(ptrs[s], sizes[s], n, tags[s]);
+    sizes[s] = n;
+  }
+}
+
+for s in 0..#slots do
+  if !is_c_nil(ptrs[s]) {
+    check(ptrs[s], sizes[s], tags[s]);
+    chpl_mem_free(ptrs[s], 0, "");
+  }
+
+writeln("mismatches: ", bad);
@@ -0,0 +1,80 @@
+//
+// Several tasks allocate, reallocate and free at once, with fewer
+// arenas than tasks so that some arenas are shared.  Then each task
+// frees the blocks another task allocated, which must go back to the
+// arena they came from.
+//
+extern proc chpl_mem_allocMany(number:size_t, size:size_t,
+                               description:int(16), lineno:int(32),
+                               filename:c_string): c_ptr(uint(8));
+extern proc chpl_mem_realloc(ptr:c_ptr(uint(8)), size:size_t,
+                             description:int(16), lineno:int(32),
+                             filename:c_string): c_ptr(uint(8));
+extern proc chpl_mem_free(ptr:c_ptr(uint(8)), lineno:int(32),
+                          filename:c_string);
+
+config const perTask = 2000;
+config const numTasks = 8;
+
+var blocks: [0..#numTasks, 0..#perTask] c_ptr(uint(8));
+var sizes: [0..#numTasks, 0..#perTask] int;
+var bad: atomic int;
+
+proc fill(p: c_ptr(uint(8)), n: int, tag: uint(8)) {
+  for i in 0..#n do
+    p[i] = tag;
+}
+
+proc check(p: c_ptr(uint(8)), n: int, tag: uint(8)) {
+  for i in 0..#n do
+    if p[i] != tag {
+      bad.add(1);
+      return;
+    }
+}
+
+coforall t in 0..#numTasks {
+  const tag = (1 + t % 251):uint(8);
+  var x = (t + 1):uint(64);
+  proc rand(n: int): int {
+    x = x * 6364136223846793005 + 1442695040888963407;
+    return ((x >> 33) % n:uint(64)):int;
+  }
+
+  for i in 0..#perTask {
+    var n = 1 + (if rand(16) == 0 then rand(64*1024) else rand(4096));
+    var p = chpl_mem_allocMany(1, n:size_t, 0, 0, "");
+    fill(p, n, tag);
+
+    // Keep some, grow or shrink some, and free the rest right away.
+    select rand(3) {
+      when 0 {
+        check(p, n, tag);
+        chpl_mem_free(p, 0, "");
+        p = nil;
+        n = 0;
+      }
+      when 1 {
+        const m = 1 + rand(8192);
+        p = chpl_mem_realloc(p, m:size_t, 0, 0, "");
+        check(p, min(n, m), tag);
+        fill(p, m, tag);
+        n = m;
+      }
+    }
+    blocks[t, i] = p;
+    sizes[t, i] = n;
+  }
+}
+
+coforall t in 0..#numTasks {
+  const owner = (t + 1) % numTasks;
+  const tag = (1 + owner % 251):uint(8);
+  for i in 0..#perTask do
+    if !is_c_nil(blocks[owner, i]) {
+      check(blocks[owner, i], sizes[owner, i], tag);
+      chpl_mem_free(blocks[owner, i], 0, "");
+    }
+}
+
+writeln("mismatches: ", bad.read());
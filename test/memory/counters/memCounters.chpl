@@ -0,0 +1,29 @@
+//
+// Check that the counters-only memory statistics see an array being
+// allocated and freed, and that its description shows up.
+//
+use Memory;
+
+config const n = 100000;
+
+const before = here.memoryInUse();
+
+proc allocate() {
+  var A: [1..n] int;
+  A = 1;
+  writeln(+ reduce A);
+  const during = here.memoryInUse();
+  writeln(during - before >= (n * numBytes(int)):uint(64));
+}
+
+allocate();
+
+writeln(here.memoryInUse() < before + (n * numBytes(int)):uint(64));
+writeln(here.memoryHighWater() >= before + (n * numBytes(int)):uint(64));
+writeln(here.memoryTotalFreed() >= (n * numBytes(int)):uint(64));
+
+var sawArrayElements = false;
+for c in here.memoryByDescription() do
+  if c.description == "array elements" && c.bytes >= (n * numBytes(int)):uint(64) then
+    sawArrayElements = true;
+writeln(sawArrayElements);
@@ -0,0 +1,25 @@
+//
+// Leave blocks of every size class on the per-thread lists of many
+// threads when the program ends.  They are flushed back to the mspace
+// as the threads exit.  Every block was freed as far as the memory
+// tracking is concerned, so the leak report must be empty, and the
+// flush must not trip over the heap.
+//
+extern proc chpl_mem_allocMany(number:size_t, size:size_t,
+                               description:int(16), lineno:int(32),
+                               filename:c_string): c_ptr(uint(8));
+extern proc chpl_mem_free(ptr:c_ptr(uint(8)), lineno:int(32),
+                          filename:c_string);
+
+config const numTasks = 16;
+config const perClass = 100;
+
+coforall t in 0..#numTasks {
+  var blocks: [1..32, 1..perClass] c_ptr(uint(8));
+  for (c, i) in blocks.domain do
+    blocks[c, i] = chpl_mem_allocMany(1, (c * 16):size_t, 0, 0, "");
+  for (c, i) in blocks.domain do
+    chpl_mem_free(blocks[c, i], 0, "");
+}
+
+writeln("done");
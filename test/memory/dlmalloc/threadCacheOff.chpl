@@ -0,0 +1,5 @@
+//
+// threadCacheTasks with CHPL_RT_MEM_THREAD_CACHE=0, so every
+// allocation and free goes straight to the mspace.
+//
+use threadCacheTasks;
@@ -0,0 +1,76 @@
+//
+// Exercise the per-thread caches in front of the dlmalloc mspace.
+// Each task allocates blocks on both sides of the size class
+// boundaries (the smallest class, 512 bytes, the largest one, and 513
+// to 527 bytes, whose usable size can still land in the last class
+// when freed).  Then each task frees the blocks another task
+// allocated, so they go onto a different thread's lists, and
+// allocates again from them.  Every block is filled over its whole
+// usable size with its own tag, so a block handed out too small, or
+// two live blocks that overlap, shows up as a mismatch.
+//
+extern proc chpl_mem_allocMany(number:size_t, size:size_t,
+                               description:int(16), lineno:int(32),
+                               filename:c_string): c_ptr(uint(8));
+extern proc chpl_mem_free(ptr:c_ptr(uint(8)), lineno:int(32),
+                          filename:c_string);
+extern proc chpl_dlmalloc_usable_size(ptr:c_ptr(uint(8))): size_t;
+
+config const perSize = 200;
+config const numTasks = 8;
+
+const sizes = (1, 15, 16, 17, 24, 25, 496, 511, 512, 513, 520, 521,
+               527, 528, 1024);
+const perTask = sizes.size * perSize;
+
+var blocks: [0..#numTasks, 0..#perTask] c_ptr(uint(8));
+var lens: [0..#numTasks, 0..#perTask] int;
+var bad, small: atomic int;
+
+proc sizeOf(i: int) return sizes(1 + i % sizes.size);
+
+proc fill(p: c_ptr(uint(8)), n: int, tag: uint(8)) {
+  for i in 0..#n do
+    p[i] = tag;
+}
+
+proc check(p: c_ptr(uint(8)), n: int, tag: uint(8)) {
+  for i in 0..#n do
+    if p[i] != tag {
+      bad.add(1);
+      return;
+    }
+}
+
+proc allocAll(t: int, tag: uint(8)) {
+  for i in 0..#perTask {
+    const n = sizeOf(i);
+    const p = chpl_mem_allocMany(1, n:size_t, 0, 0, "");
+    const usable = chpl_dlmalloc_usable_size(p):int;
+    if usable < n then small.add(1);
+    fill(p, usable, tag);
+    blocks[t, i] = p;
+    lens[t, i] = usable;
+  }
+}
+
+proc freeOwners(t: int, round: int) {
+  const owner = (t + round) % numTasks;
+  const tag = (1 + (owner + round) % 251):uint(8);
+  for i in 0..#perTask {
+    check(blocks[owner, i], lens[owner, i], tag);
+    chpl_mem_free(blocks[owner, i], 0, "");
+  }
+}
+
+// Allocate on one task and free on another, twice, so the second
+// round allocates from lists filled by another task's frees.
+for round in 1..2 {
+  coforall t in 0..#numTasks do
+    allocAll(t, (1 + (t + round) % 251):uint(8));
+  coforall t in 0..#numTasks do
+    freeOwners(t, round);
+}
+
+writeln("mismatches: ", bad.read());
+writeln("too small: ", small.read());
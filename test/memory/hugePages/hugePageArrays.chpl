@@ -0,0 +1,21 @@
+//
+// Put large array data on transparent huge pages, and check that the
+// arrays work and that the mode is reported.
+//
+use Memory;
+
+config const n = 1 << 20;
+
+var A: [1..n] real;
+var B: [1..n] int;
+forall i in 1..n {
+  A[i] = i;
+  B[i] = 2 * i;
+}
+
+var small: [1..10] int = 1;
+
+writeln(arrayPageMode());
+writeln(+ reduce A);
+writeln(+ reduce B);
+writeln(+ reduce small);
@@ -0,0 +1,16 @@
+//
+// The main task's memory region is released when the main task ends,
+// so a program whose main task allocates from it leaks nothing.
+//
+config const n = 1000;
+
+proc bump() {
+  var x = 0;
+  on here do x += 1;
+  return x;
+}
+
+var sum = 0;
+for i in 1..n do
+  sum += bump();
+writeln(sum);
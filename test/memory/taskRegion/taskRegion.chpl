@@ -0,0 +1,53 @@
+//
+// With --no-local, a local that an on-statement refers to is moved to
+// the heap.  When no task can outlive it, the compiler allocates it
+// from the running task's memory region instead, and the region is
+// released when the task ends.  With one thread, fifo runs the tasks
+// of the coforall below on the thread waiting for them.
+//
+use Memory;
+
+config const n = 1000;
+
+proc bump() {
+  var x = 0;
+  on here do x += 1;
+  return x;
+}
+
+proc allocations(desc: string) {
+  for c in here.memoryByDescription() do
+    if c.description == desc then
+      return c.allocations;
+  return 0:uint(64);
+}
+
+proc bumpInTasks() {
+  coforall t in 1..4 {
+    var sum = 0;
+    for i in 1..n do
+      sum += bump();
+    if sum != n then
+      writeln("wrong sum in task ", t);
+  }
+}
+
+// The first call sets up the main task's region.
+writeln(bump());
+writeln(allocations("task memory region") > 0);
+
+// Later calls reuse it, and nothing comes from the ordinary heap.
+const regionAllocs = allocations("task memory region");
+const heapAllocs = allocations("local heap-converted data");
+for i in 1..n do
+  bump();
+writeln(allocations("task memory region") == regionAllocs);
+writeln(allocations("local heap-converted data") == heapAllocs);
+
+// Each task gets its own region, which is gone once the task ends.
+bumpInTasks();
+const before = here.memoryInUse();
+const regionAllocsBefore = allocations("task memory region");
+bumpInTasks();
+writeln(allocations("task memory region") > regionAllocsBefore);
+writeln(here.memoryInUse() == before);
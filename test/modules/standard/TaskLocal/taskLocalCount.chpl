@@ -0,0 +1,34 @@
+use TaskLocal;
+
+config const n = 100000;
+
+var count: taskLocal(int);
+var total: atomic int;
+
+// Every task counts its own iterations, then adds its count in once.
+coforall t in 1..here.maxTaskPar {
+  for i in 1..n do
+    count.get() += 1;
+  total.add(count.get());
+}
+writeln(total.read() == n * here.maxTaskPar);
+
+// The main task's copy is untouched by the tasks above, and a new
+// task starts out with a zeroed copy of its own.
+count.get() = 7;
+sync begin {
+  writeln(count.get());
+  count.get() = 5;
+}
+writeln(count.get());
+
+// Several variables of different types coexist within one task.
+var flag: taskLocal(bool);
+var sum: taskLocal(real);
+coforall t in 1..4 {
+  flag.get() = true;
+  sum.get() += t;
+  if !flag.get() || sum.get() != t then
+    writeln("wrong value in task ", t);
+}
+writeln(flag.get(), " ", sum.get());
@@ -0,0 +1,27 @@
+use TaskLocal, Memory;
+
+config const n = 1000;
+
+var count: taskLocal(int);
+
+// With only one thread, fifo runs the tasks of a cobegin itself, one
+// after another, while it waits for them.  Each still gets its own
+// task-local storage, which must be freed when it finishes.
+proc run() {
+  var total: atomic int;
+  cobegin {
+    { count.get() += 1; total.add(count.get()); }
+    { count.get() += 2; total.add(count.get()); }
+    { count.get() += 3; total.add(count.get()); }
+  }
+  return total.read();
+}
+
+writeln(run());
+
+const before = here.memoryInUse();
+var ok = true;
+for i in 1..n do
+  if run() != 6 then ok = false;
+writeln(ok);
+writeln(here.memoryInUse() == before);
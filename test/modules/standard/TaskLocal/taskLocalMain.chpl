@@ -0,0 +1,10 @@
+use TaskLocal;
+
+// The main task's task-local values are freed when the main task
+// ends, so they don't show up as leaks.
+var count: taskLocal(int);
+var name: taskLocal(3*real);
+
+count.get() = 7;
+name.get() = (1.0, 2.0, 3.0);
+writeln(count.get(), " ", name.get());
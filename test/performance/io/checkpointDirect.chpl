@@ -0,0 +1,63 @@
+//
+// Write a large array to a file as a checkpoint, once through the page
+// cache and once with IOHINT_DIRECT, then read it back to check it.
+// Reports the write bandwidth of each and how much the page cache grew
+// (from the "Cached:" line of /proc/meminfo, where available).
+//
+use Time, FileSystem;
+
+config const n = 1024*1024;
+config const path = "checkpointDirect.bin";
+config const printTiming = false;
+
+var A: [1..n] int;
+forall i in A.domain do A[i] = i;
+
+// Returns the size of the page cache in kB, or 0 if unknown.
+proc cachedKB(): int {
+  var err: syserr;
+  var f = open(err, "/proc/meminfo", iomode.r);
+  if err then return 0;
+  var r = f.reader();
+  var tok: string;
+  var kb = 0;
+  while r.read(tok) {
+    if tok == "Cached:" {
+      r.read(kb);
+      break;
+    }
+  }
+  r.close();
+  f.close();
+  return kb;
+}
+
+proc checkpoint(hints: iohints, name: string) {
+  const cached = cachedKB();
+  const st = getCurrentTime();
+  var f = open(path, iomode.cw, hints=hints);
+  var w = f.writer(kind=ionative, hints=hints);
+  w.write(A);
+  w.close();
+  f.fsync();
+  f.close();
+  const dt = getCurrentTime() - st;
+  const grown = cachedKB() - cached;
+
+  var B: [1..n] int;
+  var g = open(path, iomode.r, hints=hints);
+  var r = g.reader(kind=ionative, hints=hints);
+  r.read(B);
+  r.close();
+  g.close();
+  writeln(name, " data ok: ", && reduce (A == B));
+
+  if printTiming {
+    writeln(name, " GB/s: ", (n*numBytes(int)):real / dt / 1e9);
+    writeln(name, " page cache growth (MB): ", grown / 1024.0);
+  }
+}
+
+checkpoint(IOHINT_NONE, "buffered");
+checkpoint(IOHINT_DIRECT, "direct");
+remove(path);
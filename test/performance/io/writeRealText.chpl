@@ -0,0 +1,41 @@
+//
+// Write a large array of reals to a file as text in the default style,
+// then read the values back to check them against %g of the originals.
+// Reports output throughput in MB/s and values per second.
+//
+use Time, FileSystem;
+
+config const n = 100000;
+config const path = "writeRealText.txt";
+config const printTiming = false;
+
+var A: [1..n] real;
+forall i in A.domain do A[i] = (i * 7919 % 1000003):real / 1024.0 + 1.0 / i;
+
+const st = getCurrentTime();
+var f = open(path, iomode.cw);
+var w = f.writer();
+for a in A do w.writeln(a);
+w.close();
+const nbytes = f.length();
+f.close();
+const dt = getCurrentTime() - st;
+
+var ok = true;
+var g = open(path, iomode.r);
+var r = g.reader();
+for a in A {
+  var b: real;
+  r.read(b);
+  if abs(b - a) > 1e-5 * abs(a) then ok = false;
+}
+r.close();
+g.close();
+writeln("data ok: ", ok);
+
+if printTiming {
+  writeln("text output MB/s: ", nbytes / dt / 1e6);
+  writeln("reals written per second: ", n / dt);
+}
+
+remove(path);
@@ -0,0 +1,33 @@
+//
+// Every task repeatedly allocates and frees small objects.  When run
+// with --memTrack each allocation and free updates the memory table,
+// so this measures how well memory tracking scales with the number of
+// tasks allocating at once.
+//
+use Time, Memory;
+
+config const n = 1000;
+config const numTasks = here.maxTaskPar;
+config const printTiming = false;
+
+class C {
+  var x: int;
+}
+
+var total: atomic int;
+
+const st = getCurrentTime();
+coforall t in 1..numTasks {
+  var sum = 0;
+  for i in 1..n {
+    var c = new C(i);
+    sum += c.x;
+    delete c;
+  }
+  total.add(sum);
+}
+const dt = getCurrentTime() - st;
+
+writeln("total ok: ", total.read() == numTasks * n * (n+1) / 2);
+if printTiming then
+  writeln("tracked alloc/free: ", dt);
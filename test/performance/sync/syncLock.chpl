@@ -0,0 +1,27 @@
+//
+// Many tasks update a shared counter, using a sync variable as a lock
+// around a very short critical section.  This measures the cost of
+// contended sync variable handoffs.
+//
+use Time;
+
+config const n = 1000;
+config const numTasks = here.maxTaskPar;
+config const printTiming = false;
+
+var lock: sync bool;
+var count = 0;
+
+const st = getCurrentTime();
+coforall t in 1..numTasks {
+  for i in 1..n {
+    lock.writeEF(true);
+    count += 1;
+    lock.readFE();
+  }
+}
+const dt = getCurrentTime() - st;
+
+writeln("count ok: ", count == n*numTasks);
+if printTiming then
+  writeln("sync lock: ", dt);
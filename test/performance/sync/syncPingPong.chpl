@@ -0,0 +1,27 @@
+//
+// Two tasks hand a token back and forth through a pair of sync
+// variables.  Every handoff finds the variable in the wrong state, so
+// this measures the latency of blocking and waking on a sync variable.
+//
+use Time;
+
+config const n = 1000;
+config const printTiming = false;
+
+var ping, pong: sync int;
+var total = 0;
+
+const st = getCurrentTime();
+cobegin {
+  for i in 1..n {
+    ping = i;
+    total += pong;
+  }
+  for i in 1..n do
+    pong = ping;
+}
+const dt = getCurrentTime() - st;
+
+writeln("total ok: ", total == n*(n+1)/2);
+if printTiming then
+  writeln("sync ping-pong: ", dt);
@@ -0,0 +1,33 @@
+//
+// Producer tasks pass items to consumer tasks through a single sync
+// variable acting as a one-slot buffer.  Both sides contend for it and
+// frequently find it in the wrong state.
+//
+use Time;
+
+config const n = 1000;
+config const numProducers = 2;
+config const numConsumers = 2;
+config const printTiming = false;
+
+var slot: sync int;
+var sums: [1..numConsumers] int;
+
+const perProducer = n;
+const perConsumer = n*numProducers/numConsumers;
+
+const st = getCurrentTime();
+cobegin {
+  coforall p in 1..numProducers do
+    for i in 1..perProducer do
+      slot = i;
+  coforall c in 1..numConsumers do
+    for i in 1..perConsumer do
+      sums[c] += slot;
+}
+const dt = getCurrentTime() - st;
+
+const total = + reduce sums;
+writeln("total ok: ", total == numProducers*n*(n+1)/2);
+if printTiming then
+  writeln("sync producer-consumer: ", dt);
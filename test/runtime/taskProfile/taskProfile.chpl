@@ -0,0 +1,20 @@
+config const n = 4;
+
+var count: atomic int;
+var go$: sync bool;
+
+coforall i in 1..n {
+  count.add(1);
+}
+
+begin {
+  go$ = true;
+}
+
+sync {
+  begin {
+    if go$ then count.add(1);
+  }
+}
+
+writeln("count = ", count.read());
@@ -0,0 +1 @@
+/root/repo/third-party/../third-party/hwloc/hwloc-1.9.1/src/topology-cuda.c
\ No newline at end of file
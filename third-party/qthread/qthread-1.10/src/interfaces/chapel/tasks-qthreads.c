@@ -657,6 +657,8 @@ static aligned_t chapel_wrapper(void *arg)
 
     (*(chpl_fn_p)(rarg->fn))(rarg->args);
 
+    chpl_task_freeLocals(&data->chpl_data.prvdata.local_data);
+
     if (rarg->countRunning) {
         chpl_taskRunningCntDec(0, NULL);
     }
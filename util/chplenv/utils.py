@@ -24,10 +24,12 @@ def get_chpl_home():
 @memoize
 def get_compiler_version(compiler):
     if 'gnu' in compiler:
+        # Newer versions of gcc report just the major version here
+        # (e.g., "5" rather than "4.9.2"), so the minor one is optional.
         output = run_command(['gcc', '-dumpversion'])
-        match = re.search(r'(\d+\.\d+)', output)
+        match = re.search(r'\d+(\.\d+)?', output)
         if match:
-            return float(match.group(1))
+            return float(match.group(0))
         else:
             raise ValueError("Could not find the GCC version")
     else: